@@ -0,0 +1,465 @@
+// Joseph Miller (c) 2019
+
+#include "Instrumentation.h"
+#include "Maze.h"
+#include "MazeGenerator.h"
+#include "QueryCache.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static constexpr size_t DEFAULT_QUERIES = 100; ///< The default number of starting points searched per maze.
+static constexpr size_t DEFAULT_WARMUP = 1; ///< The default number of untimed passes over the queries.
+static constexpr size_t DEFAULT_REPETITIONS = 3; ///< The default number of timed passes over the queries.
+static constexpr uint32_t DEFAULT_SEED = 2019; ///< The default seed for the mazes and the queries.
+static constexpr size_t MULTI_EXIT_CELLS_PER_EXIT = 500; ///< The multi-exit maps get one exit per this many cells.
+
+/** A synthetic maze family the benchmark sweeps over.
+*/
+struct Generator
+{
+    const char * name; ///< The name reported in the results.
+    std::function<void( MazeGenerator & generator, const size_t rows, const size_t columns )> build; ///< Builds the maze and its exits.
+};
+
+/** A search the benchmark times.
+*/
+struct Algorithm
+{
+    const char * name; ///< The name used on the command line and in the results.
+    std::function<SearchResult( const Maze & maze, const size_t start_row, const size_t start_column )> search; ///< The search to run.
+    bool reusesWorkspace = false; ///< Whether the search keeps one SearchWorkspace across queries, so its timed passes must not allocate.
+};
+
+/** A cell layout the benchmark times the searches in.
+*/
+struct Layout
+{
+    const char * name; ///< The name used on the command line and in the results.
+    Maze::GRID_LAYOUT layout; ///< The layout the searches walk.
+};
+
+/** Splits a comma separated list.
+
+@param list The list to split.
+
+@return The items of the list.
+*/
+static std::vector<std::string> SplitList( const std::string & list )
+{
+    std::vector<std::string> items;
+    std::istringstream stream( list );
+    std::string item;
+    while ( std::getline( stream, item, ',' ) )
+    {
+        if ( !item.empty() )
+        {
+            items.push_back( item );
+        }
+    }
+    return items;
+}
+
+/** Parses a maze size, either N for a square maze or RxC for R rows of C columns.
+
+@param size The size to parse.
+
+@return The rows and the columns, 0 if the size isn't a number.
+*/
+static std::pair<size_t, size_t> ParseSize( const std::string & size )
+{
+    char * end = nullptr; // the character after the rows
+    const size_t rows = std::strtoull( size.c_str(), &end, 10 );
+    const size_t columns = ( *end == 'x' ) ? std::strtoull( end + 1, nullptr, 10 ) : rows;
+    return { rows, columns };
+}
+
+/** Retrieves a percentile of sorted latencies using the nearest rank.
+
+@param sorted The latencies in ascending order.
+@param percentile The percentile to retrieve, from 0 to 100.
+
+@return The latency at the percentile in microseconds, or 0 if there are no latencies.
+*/
+static double Percentile( const std::vector<double> & sorted, const double percentile )
+{
+    if ( sorted.empty() )
+    {
+        return 0;
+    }
+    const size_t rank = static_cast<size_t>( percentile / 100.0 * ( sorted.size() - 1 ) + 0.5 ); // the index of the nearest rank
+    return sorted[std::min( rank, sorted.size() - 1 )];
+}
+
+/** Prints the usage of the benchmark.
+
+@param program The name the benchmark was run as.
+*/
+static void PrintUsage( const char * program )
+{
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --sizes N,RxC,...      maze sizes to sweep, N for N by N or R rows by C columns (default 64,256,1024)\n"
+              << "  --generators G,G,...   open,random10,random30,backtracker,prim,corridors,spiral,multiexit,terrain (default all)\n"
+              << "  --algorithms A,A,...   bfs,dfs,idfs,bitbfs,field,astar,jps,hpa,hpa_approx,bfs_path,dijkstra,parallel_bfs,cached_bfs,bfs_reused,astar_reused,jps_reused,bfs_path_reused,between_reused,parallel_bfs_reused (default all but dfs, which is exponential on open maps, bfs_path, dijkstra, parallel_bfs, cached_bfs, and the reused searches)\n"
+              << "  --queries N            starting points per maze (default " << DEFAULT_QUERIES << ")\n"
+              << "  --warmup N             untimed passes over the queries (default " << DEFAULT_WARMUP << ")\n"
+              << "  --repetitions N        timed passes over the queries (default " << DEFAULT_REPETITIONS << ")\n"
+              << "  --seed N               seed for the mazes and the queries (default " << DEFAULT_SEED << ")\n"
+              << "  --neighbourhood N      four, eight, or eight_no_corner_cut moves (default four)\n"
+              << "  --layouts L,L,...      row_major,tiled,morton cell layouts to search in (default row_major)\n"
+              << "  --hardware-counters N  in instrumented builds, sample cycles, instructions, and cache misses every N searches per thread (default 0, off)\n";
+}
+
+/** Main. Generates mazes, times every selected search on them, and writes one CSV row per maze and search to std out.
+    Latencies are per query, taken from SearchResult::elapsed. cells_per_second is SearchResult::cellsExpanded
+    over the timed passes (layers for bitbfs, jump points for jps), and mismatches counts queries whose distance differs from bfs.
+    A hierarchy_build row per maze times Maze::BuildHierarchy on a thread pool with a worker per hardware thread, and parallel_bfs runs on the same pool;
+    hpa_approx mismatches count its near-optimal answers that are longer than the minimum.
+    A field_update row per maze times Maze::SetCell blocking and reopening every starting point, to compare with field_build.
+    dijkstra answers move costs rather than spaces, so its mismatches on the terrain maze count the queries whose cheapest route isn't a shortest one.
+    cached_bfs answers through a QueryCache that the warmup pass fills, so its timed passes measure cache hits.
+    bfs_reused, astar_reused, jps_reused, bfs_path_reused, and parallel_bfs_reused search with one SearchWorkspace kept
+    across every query, where the plain searches start each query with a new workspace, so the difference is the cost of
+    allocating and clearing the buffers. between_reused times the point to point search from each starting point to the
+    point mirrored through the centre of the maze, so its mismatches count where that differs from the nearest exit.
+    allocations counts the SearchWorkspace buffer allocations on the benchmark thread during the timed passes; the
+    reused searches must make none once warmed up, and the benchmark fails if they do. The other workers of
+    parallel_bfs_reused grow their frontiers on their own threads, so only worker 0's show in the count.
+    Every search and the field_update row are repeated in each selected layout, whose name is in the layout column;
+    tall and wide sizes show how far apart the rows are, and sizes past the last level cache when the layout pays.
+    Instrumented builds also write a CSV row per maze and search to std err with the counters of the timed passes:
+    enqueues, revisits avoided, and the frontier high-water mark, plus cycles, instructions per cycle, and cache
+    misses per sampled search when hardware counters are sampled.
+
+@param argc The number of command line arguments.
+@param argv The command line arguments.
+
+@return EXIT_SUCCESS, or EXIT_FAILURE if the arguments are invalid or a reused search allocated after its warmup.
+*/
+int main( int argc, char ** argv )
+{
+    const std::vector<Generator> allGenerators =
+    {
+        { "open", []( MazeGenerator & generator, const size_t, const size_t ) { generator.OpenField(); generator.AddExits( 4 ); } },
+        { "random10", []( MazeGenerator & generator, const size_t, const size_t ) { generator.RandomObstacles( 0.1 ); generator.AddExits( 4 ); } },
+        { "random30", []( MazeGenerator & generator, const size_t, const size_t ) { generator.RandomObstacles( 0.3 ); generator.AddExits( 4 ); } },
+        { "backtracker", []( MazeGenerator & generator, const size_t, const size_t ) { generator.RecursiveBacktracker(); generator.AddExits( 1 ); } },
+        { "prim", []( MazeGenerator & generator, const size_t, const size_t ) { generator.Prim(); generator.AddExits( 1 ); } },
+        { "corridors", []( MazeGenerator & generator, const size_t, const size_t ) { generator.Corridors(); generator.AddExits( 1 ); } },
+        { "spiral", []( MazeGenerator & generator, const size_t, const size_t ) { generator.Spiral(); generator.AddExits( 1 ); } },
+        { "multiexit", []( MazeGenerator & generator, const size_t rows, const size_t columns )
+            {
+                generator.RandomObstacles( 0.2 );
+                generator.AddExits( std::max<size_t>( rows * columns / MULTI_EXIT_CELLS_PER_EXIT, 1 ) );
+            } },
+        { "terrain", []( MazeGenerator & generator, const size_t, const size_t ) { generator.RandomObstacles( 0.2 ); generator.AddTerrain( 0.3 ); generator.AddExits( 4 ); } },
+    };
+    ThreadPool pool; // builds the hierarchy of each maze and runs the parallel search
+    QueryCache cache; // remembers breadth first search answers, so every pass after the first is answered from it
+    SearchWorkspace workspace; // kept across the queries of the reused searches, so they never allocate after the warmup
+    std::vector<std::pair<size_t, size_t>> path; // the route of bfs_path_reused, discarded but kept at its largest size
+    const std::vector<Algorithm> allAlgorithms =
+    {
+        { "bfs", &Maze::MinimumNumberOfSpacesBFS },
+        { "dfs", &Maze::MinimumNumberOfSpacesDFS },
+        { "idfs", &Maze::MinimumNumberOfSpacesIterativeDFS },
+        { "bitbfs", &Maze::MinimumNumberOfSpacesBitParallelBFS },
+        { "field", &Maze::MinimumNumberOfSpacesDistanceField },
+        { "astar", &Maze::MinimumNumberOfSpacesAStar },
+        { "jps", &Maze::MinimumNumberOfSpacesJumpPoint },
+        { "bfs_path", []( const Maze & maze, const size_t row, const size_t column )
+            {
+                std::vector<std::pair<size_t, size_t>> path; // the route, discarded
+                return maze.MinimumPath( row, column, Maze::SEARCH_ALGORITHM::BFS, path );
+            } },
+        { "hpa", []( const Maze & maze, const size_t row, const size_t column ) { return maze.MinimumNumberOfSpacesHierarchical( row, column, true ); } },
+        { "hpa_approx", []( const Maze & maze, const size_t row, const size_t column ) { return maze.MinimumNumberOfSpacesHierarchical( row, column, false ); } },
+        { "dijkstra", &Maze::MinimumMoveCostDijkstra },
+        { "parallel_bfs", [&pool]( const Maze & maze, const size_t row, const size_t column ) { return maze.MinimumNumberOfSpacesParallelBFS( row, column, pool ); } },
+        { "cached_bfs", [&cache]( const Maze & maze, const size_t row, const size_t column ) { return cache.Query( maze, row, column, Maze::SEARCH_ALGORITHM::BFS ); } },
+        { "bfs_reused", [&workspace]( const Maze & maze, const size_t row, const size_t column ) { return maze.MinimumNumberOfSpaces( row, column, Maze::SEARCH_ALGORITHM::BFS, workspace ); }, true },
+        { "astar_reused", [&workspace]( const Maze & maze, const size_t row, const size_t column ) { return maze.MinimumNumberOfSpaces( row, column, Maze::SEARCH_ALGORITHM::A_STAR, workspace ); }, true },
+        { "jps_reused", [&workspace]( const Maze & maze, const size_t row, const size_t column ) { return maze.MinimumNumberOfSpaces( row, column, Maze::SEARCH_ALGORITHM::JUMP_POINT, workspace ); }, true },
+        { "bfs_path_reused", [&workspace, &path]( const Maze & maze, const size_t row, const size_t column ) { return maze.MinimumPath( row, column, Maze::SEARCH_ALGORITHM::BFS, path, workspace ); }, true },
+        { "between_reused", [&workspace]( const Maze & maze, const size_t row, const size_t column )
+            {
+                return maze.MinimumNumberOfSpacesBetween( row, column, maze.GetRowSize() - 1 - row, maze.GetColumnSize() - 1 - column, workspace );
+            }, true },
+        { "parallel_bfs_reused", [&pool, &workspace]( const Maze & maze, const size_t row, const size_t column ) { return maze.MinimumNumberOfSpacesParallelBFS( row, column, pool, workspace ); }, true },
+    };
+
+    const std::vector<Layout> allLayouts =
+    {
+        { "row_major", Maze::GRID_LAYOUT::ROW_MAJOR },
+        { "tiled", Maze::GRID_LAYOUT::TILED },
+        { "morton", Maze::GRID_LAYOUT::MORTON },
+    };
+
+    std::vector<std::pair<size_t, size_t>> sizes = { { 64, 64 }, { 256, 256 }, { 1024, 1024 } }; // the rows and columns of the maze sizes to sweep
+    std::vector<std::string> generatorNames; // the generators to run, or empty for all
+    std::vector<std::string> algorithmNames = { "bfs", "idfs", "bitbfs", "field", "astar", "jps", "hpa", "hpa_approx" }; // the searches to time
+    std::vector<std::string> layoutNames = { "row_major" }; // the layouts to search in
+    size_t queries = DEFAULT_QUERIES;
+    size_t warmup = DEFAULT_WARMUP;
+    size_t repetitions = DEFAULT_REPETITIONS;
+    uint32_t seed = DEFAULT_SEED;
+    Maze::NEIGHBOURHOOD neighbourhood = Maze::NEIGHBOURHOOD::FOUR_WAY; // the moves the searches may make
+    uint32_t samplePeriod = 0; // the searches per hardware counter sample, or 0 for none
+    bool reuseAllocated = false; // whether a reused search allocated buffers after its warmup
+
+    for ( int argument = 1; argument < argc; ++argument )
+    {
+        const std::string option = argv[argument];
+        if ( argument + 1 >= argc )
+        {
+            PrintUsage( argv[0] );
+            return EXIT_FAILURE;
+        }
+        const std::string value = argv[++argument];
+        if ( option == "--sizes" )
+        {
+            sizes.clear();
+            for ( const std::string & size : SplitList( value ) )
+            {
+                sizes.push_back( ParseSize( size ) );
+            }
+        }
+        else if ( option == "--generators" )
+        {
+            generatorNames = SplitList( value );
+        }
+        else if ( option == "--algorithms" )
+        {
+            algorithmNames = SplitList( value );
+        }
+        else if ( option == "--layouts" )
+        {
+            layoutNames = SplitList( value );
+        }
+        else if ( option == "--queries" )
+        {
+            queries = std::strtoull( value.c_str(), nullptr, 10 );
+        }
+        else if ( option == "--warmup" )
+        {
+            warmup = std::strtoull( value.c_str(), nullptr, 10 );
+        }
+        else if ( option == "--repetitions" )
+        {
+            repetitions = std::max<size_t>( std::strtoull( value.c_str(), nullptr, 10 ), 1 );
+        }
+        else if ( option == "--seed" )
+        {
+            seed = static_cast<uint32_t>( std::strtoul( value.c_str(), nullptr, 10 ) );
+        }
+        else if ( option == "--neighbourhood" && value == "four" )
+        {
+            neighbourhood = Maze::NEIGHBOURHOOD::FOUR_WAY;
+        }
+        else if ( option == "--neighbourhood" && value == "eight" )
+        {
+            neighbourhood = Maze::NEIGHBOURHOOD::EIGHT_WAY;
+        }
+        else if ( option == "--neighbourhood" && value == "eight_no_corner_cut" )
+        {
+            neighbourhood = Maze::NEIGHBOURHOOD::EIGHT_WAY_NO_CORNER_CUTTING;
+        }
+        else if ( option == "--hardware-counters" )
+        {
+            samplePeriod = static_cast<uint32_t>( std::strtoul( value.c_str(), nullptr, 10 ) );
+        }
+        else
+        {
+            PrintUsage( argv[0] );
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<const Generator *> generators; // the generators selected
+    for ( const Generator & generator : allGenerators )
+    {
+        if ( generatorNames.empty() || std::find( generatorNames.begin(), generatorNames.end(), generator.name ) != generatorNames.end() )
+        {
+            generators.push_back( &generator );
+        }
+    }
+    std::vector<const Algorithm *> algorithms; // the searches selected
+    for ( const std::string & name : algorithmNames )
+    {
+        const auto algorithm = std::find_if( allAlgorithms.begin(), allAlgorithms.end(), [&name]( const Algorithm & candidate ) { return name == candidate.name; } );
+        if ( algorithm == allAlgorithms.end() )
+        {
+            std::cerr << "Unknown algorithm: " << name << "\n";
+            PrintUsage( argv[0] );
+            return EXIT_FAILURE;
+        }
+        algorithms.push_back( &*algorithm );
+    }
+    std::vector<const Layout *> layouts; // the layouts selected
+    for ( const std::string & name : layoutNames )
+    {
+        const auto layout = std::find_if( allLayouts.begin(), allLayouts.end(), [&name]( const Layout & candidate ) { return name == candidate.name; } );
+        if ( layout == allLayouts.end() )
+        {
+            std::cerr << "Unknown layout: " << name << "\n";
+            PrintUsage( argv[0] );
+            return EXIT_FAILURE;
+        }
+        layouts.push_back( &*layout );
+    }
+
+    if ( samplePeriod != 0 && !Instrumentation::EnableHardwareCounters( samplePeriod ) )
+    {
+        std::cerr << "Hardware counters are unavailable; counting without them\n";
+    }
+    if ( INSTRUMENTATION_ENABLED )
+    {
+        std::cerr << "generator,rows,columns,layout,algorithm,searches,enqueues,revisits_avoided,frontier_high_water,sampled_searches,cycles_per_search,instructions_per_cycle,cache_misses_per_search\n";
+    }
+    std::cout << "generator,rows,columns,layout,algorithm,queries,repetitions,total_ms,cells_per_second,mean_us,p50_us,p90_us,p99_us,max_us,mismatches,allocations\n";
+    for ( const std::pair<size_t, size_t> & size : sizes )
+    {
+        const size_t rows = size.first; // the rows of the mazes of this size
+        const size_t columns = size.second; // the columns of the mazes of this size
+        for ( const Generator * generator : generators )
+        {
+            MazeGenerator mazeGenerator( rows, columns, seed );
+            generator->build( mazeGenerator, rows, columns );
+            const std::vector<std::pair<size_t, size_t>> starts = mazeGenerator.RandomClearCells( queries ); // the query starting points
+
+            Maze maze;
+            if ( !maze.LoadMazeFromText( mazeGenerator.ToText() ) )
+            {
+                std::cerr << "Could not load the " << generator->name << " maze of size " << rows << 'x' << columns << "\n";
+                continue;
+            }
+            maze.SetNeighbourhood( neighbourhood );
+
+            const std::chrono::steady_clock::time_point buildStart = std::chrono::steady_clock::now();
+            maze.BuildDistanceField();
+            const double buildMilliseconds = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - buildStart ).count();
+            std::cout << generator->name << ',' << rows << ',' << columns << ",row_major,field_build,0,1," << buildMilliseconds << ",0,0,0,0,0,0,0,0\n";
+
+            const std::chrono::steady_clock::time_point hierarchyStart = std::chrono::steady_clock::now();
+            maze.BuildHierarchy( pool );
+            const double hierarchyMilliseconds = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - hierarchyStart ).count();
+            std::cout << generator->name << ',' << rows << ',' << columns << ",row_major,hierarchy_build,0,1," << hierarchyMilliseconds << ",0,0,0,0,0,0,0,0\n";
+
+            std::vector<int> expected; // the breadth first search distance of every query, to check the other searches against
+            expected.reserve( starts.size() );
+            for ( const std::pair<size_t, size_t> & start : starts )
+            {
+                expected.push_back( maze.MinimumNumberOfSpacesBFS( start.first, start.second ).distance );
+            }
+
+            for ( const Layout * layout : layouts )
+            {
+                if ( !maze.SetGridLayout( layout->layout ) )
+                {
+                    std::cerr << "The " << layout->name << " copy of the " << generator->name << " maze of size " << rows << 'x' << columns << " exceeds the memory limit\n";
+                    continue;
+                }
+                if ( !maze.HierarchyBuilt() ) // the field_update timing of the layout before discarded it
+                {
+                    maze.BuildHierarchy( pool );
+                }
+                for ( const Algorithm * algorithm : algorithms )
+                {
+                    for ( size_t pass = 0; pass < warmup; ++pass )
+                    {
+                        for ( const std::pair<size_t, size_t> & start : starts )
+                        {
+                            algorithm->search( maze, start.first, start.second );
+                        }
+                    }
+
+                    Instrumentation::Reset(); // count the timed passes only
+                    const uint64_t allocationsBefore = SearchWorkspace::GetAllocationCount(); // the buffer allocations before the timed passes
+                    std::vector<double> latencies; // the time of every timed query in microseconds
+                    latencies.reserve( starts.size() * repetitions );
+                    size_t cellsExpanded = 0; // the cells expanded by every timed query
+                    size_t mismatches = 0; // the queries whose distance differs from the breadth first search
+                    for ( size_t pass = 0; pass < repetitions; ++pass )
+                    {
+                        for ( size_t query = 0; query < starts.size(); ++query )
+                        {
+                            const SearchResult result = algorithm->search( maze, starts[query].first, starts[query].second );
+                            latencies.push_back( std::chrono::duration<double, std::micro>( result.elapsed ).count() );
+                            cellsExpanded += result.cellsExpanded;
+                            mismatches += ( pass == 0 && result.distance != expected[query] ) ? 1 : 0;
+                        }
+                    }
+
+                    const uint64_t allocations = SearchWorkspace::GetAllocationCount() - allocationsBefore; // the buffer allocations of the timed passes
+                    if ( algorithm->reusesWorkspace && warmup != 0 && allocations != 0 )
+                    {
+                        std::cerr << algorithm->name << " allocated " << allocations << " buffers after its warmup on the " << generator->name << " maze of size " << rows << 'x' << columns << "\n";
+                        reuseAllocated = true;
+                    }
+
+                    double totalMicroseconds = 0; // the time of all the timed queries
+                    for ( const double latency : latencies )
+                    {
+                        totalMicroseconds += latency;
+                    }
+                    std::sort( latencies.begin(), latencies.end() );
+                    const double mean = latencies.empty() ? 0 : totalMicroseconds / latencies.size();
+                    const double cellsPerSecond = ( totalMicroseconds > 0 ) ? cellsExpanded / ( totalMicroseconds / 1e6 ) : 0;
+
+                    std::cout << generator->name << ',' << rows << ',' << columns << ',' << layout->name << ',' << algorithm->name << ','
+                              << starts.size() << ',' << repetitions << ',' << totalMicroseconds / 1000.0 << ','
+                              << cellsPerSecond << ',' << mean << ',' << Percentile( latencies, 50 ) << ','
+                              << Percentile( latencies, 90 ) << ',' << Percentile( latencies, 99 ) << ','
+                              << ( latencies.empty() ? 0 : latencies.back() ) << ',' << mismatches << ',' << allocations << '\n';
+                    if ( INSTRUMENTATION_ENABLED )
+                    {
+                        const InstrumentationTotals totals = Instrumentation::Collect(); // the work of the timed passes
+                        const uint64_t sampled = std::max<uint64_t>( totals.sampledSearches, 1 ); // avoids dividing by zero when nothing was sampled
+                        std::cerr << generator->name << ',' << rows << ',' << columns << ',' << layout->name << ',' << algorithm->name << ',' << totals.searches << ','
+                                  << totals.enqueues << ',' << totals.revisitsAvoided << ',' << totals.frontierHighWater << ',' << totals.sampledSearches << ','
+                                  << totals.cycles / sampled << ',' << ( totals.cycles > 0 ? static_cast<double>( totals.instructions ) / totals.cycles : 0.0 ) << ','
+                                  << totals.cacheMisses / sampled << '\n';
+                    }
+                }
+
+                // block and then reopen every starting point, timing the incremental repair of each change
+                std::vector<double> updateLatencies; // the time of every cell change in microseconds
+                updateLatencies.reserve( starts.size() * 2 );
+                for ( const std::pair<size_t, size_t> & start : starts )
+                {
+                    for ( const Maze::MAZE_DATA_TYPE type : { Maze::MAZE_DATA_TYPE::BLOCKED, Maze::MAZE_DATA_TYPE::CLEAR } )
+                    {
+                        const std::chrono::steady_clock::time_point updateStart = std::chrono::steady_clock::now();
+                        maze.SetCell( start.first, start.second, type );
+                        updateLatencies.push_back( std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now() - updateStart ).count() );
+                    }
+                }
+                size_t updateMismatches = 0; // the queries whose repaired distance differs from the breadth first search on the original maze
+                for ( size_t query = 0; query < starts.size(); ++query )
+                {
+                    updateMismatches += ( maze.MinimumNumberOfSpacesDistanceField( starts[query].first, starts[query].second ).distance != expected[query] ) ? 1 : 0;
+                }
+                double updateMicroseconds = 0; // the time of all the cell changes
+                for ( const double latency : updateLatencies )
+                {
+                    updateMicroseconds += latency;
+                }
+                std::sort( updateLatencies.begin(), updateLatencies.end() );
+                std::cout << generator->name << ',' << rows << ',' << columns << ',' << layout->name << ",field_update," << updateLatencies.size() << ",1,"
+                          << updateMicroseconds / 1000.0 << ",0," << ( updateLatencies.empty() ? 0 : updateMicroseconds / updateLatencies.size() ) << ','
+                          << Percentile( updateLatencies, 50 ) << ',' << Percentile( updateLatencies, 90 ) << ',' << Percentile( updateLatencies, 99 ) << ','
+                          << ( updateLatencies.empty() ? 0 : updateLatencies.back() ) << ',' << updateMismatches << ",0\n";
+            }
+            std::cout.flush(); // let long sweeps be followed as they run
+        }
+    }
+
+    return reuseAllocated ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,283 @@
+// Joseph Miller (c) 2019
+
+#include "BitGrid.h"
+#include "Maze.h"
+#include <algorithm>
+#include <cstring>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+static constexpr size_t BITS_PER_WORD = 64; ///< The number of cells held by one word of a bit row.
+
+/** Works out the memory the bit planes of a maze of the given size occupy.
+
+@param rows The number of rows in the maze.
+@param columns The number of columns in the maze.
+
+@return The bytes of the passable and exit planes together.
+*/
+size_t BitGrid::PlaneBytes( const size_t rows, const size_t columns )
+{
+    const size_t rowStride = ( columns + BITS_PER_WORD - 1 ) / BITS_PER_WORD + 2; // the words in a padded row
+    return 2 * ( rows + 2 ) * rowStride * sizeof( uint64_t );
+}
+
+/** Sets up empty bit planes for a maze of the given size.
+    Every plane has an empty row above and below the maze and an empty word on each side of every row,
+    so a layer can be expanded without bounds checks.
+
+@param rows The number of rows in the maze.
+@param columns The number of columns in the maze.
+*/
+void BitGrid::Reset( const size_t rows, const size_t columns )
+{
+    m_rows = rows;
+    m_columns = columns;
+    m_wordsPerRow = ( columns + BITS_PER_WORD - 1 ) / BITS_PER_WORD;
+    m_rowStride = m_wordsPerRow + 2;
+    m_passable.assign( ( rows + 2 ) * m_rowStride, 0 );
+    m_exits.assign( m_passable.size(), 0 );
+}
+
+/** Sets the bits of a maze cell.
+
+@param row The row of the cell.
+@param column The column of the cell.
+@param passable Whether the cell can be traveled through.
+@param exit Whether the cell is an exit.
+*/
+void BitGrid::SetCell( const size_t row, const size_t column, const bool passable, const bool exit )
+{
+    const size_t word = WordIndex( row, column ); // the word holding the cell
+    const uint64_t bit = ColumnBit( column ); // the bit of the cell within the word
+    m_passable[word] = passable ? ( m_passable[word] | bit ) : ( m_passable[word] & ~bit );
+    m_exits[word] = exit ? ( m_exits[word] | bit ) : ( m_exits[word] & ~bit );
+}
+
+/** Expands the frontier into one word of the next layer.
+    A cell is reached from the cells above, below, left (shifted up a bit), and right (shifted down a bit),
+    as long as it hasn't been visited yet.
+
+@param frontier The frontier plane.
+@param word The index of the word to expand into.
+@param rowStride The number of words in one padded row.
+@param unvisited The unvisited passable cells of the word.
+
+@return The newly reached cells of the word.
+*/
+static uint64_t ExpandWord( const uint64_t * frontier, const size_t word, const size_t rowStride, const uint64_t unvisited )
+{
+    const uint64_t current = frontier[word];
+    return ( frontier[word - rowStride] | frontier[word + rowStride]
+           | ( current << 1 ) | ( frontier[word - 1] >> 63 )
+           | ( current >> 1 ) | ( frontier[word + 1] << 63 ) ) & unvisited;
+}
+
+/** Finds the distance to the nearest exit with a bit-parallel breadth first search.
+    The frontier and the unvisited passable cells are packed bit rows, so a layer of the search is
+    expanded 64 cells at a time with shifts, ands, and ors. An exit is found by and-ing the new frontier with the exit plane.
+    The non-empty frontier words are also kept in a list. Each layer picks the cheaper of sweeping every row the
+    frontier could reach (vectorised with AVX2 when available) or expanding only the words around the listed ones,
+    so thin frontiers cost about as much as a scalar search and wide frontiers are processed a word at a time.
+
+@param start_row The row of the starting cell.
+@param start_column The column of the starting cell.
+@param layers Set to the number of layers expanded.
+@param peakWords Set to the most non-empty words a layer held.
+@param workspace The scratch planes to search with.
+
+@return The minimum number of spaces from the start to the closest exit, or -1 if no exit can be reached.
+*/
+int BitGrid::ExitDistance( const size_t start_row, const size_t start_column, size_t & layers, size_t & peakWords, BitGridWorkspace & workspace ) const
+{
+    layers = 0;
+    peakWords = 0;
+    if ( start_row >= m_rows || start_column >= m_columns )
+    {
+        return Maze::PATH_UNREACHABLE;
+    }
+    const size_t startWord = WordIndex( start_row, start_column ); // the word holding the starting cell
+    const uint64_t startBit = ColumnBit( start_column ); // the bit of the starting cell
+    if ( ( m_exits[startWord] & startBit ) != 0 )
+    {
+        return 0;
+    }
+    if ( ( m_passable[startWord] & startBit ) == 0 )
+    {
+        return Maze::PATH_UNREACHABLE;
+    }
+
+    // reuse the workspace planes; assigning a plane of the same size doesn't allocate
+    ScratchVector<uint64_t> & unvisited = workspace.m_unvisited;
+    ScratchVector<uint64_t> & frontier = workspace.m_frontier;
+    ScratchVector<uint64_t> & next = workspace.m_next;
+    ScratchVector<uint32_t> & frontierWords = workspace.m_frontierWords;
+    ScratchVector<uint32_t> & nextWords = workspace.m_nextWords;
+    ScratchVector<uint32_t> & expandedLayer = workspace.m_expandedLayer;
+    unvisited.assign( m_passable.begin(), m_passable.end() );
+    frontier.assign( m_passable.size(), 0 );
+    next.assign( m_passable.size(), 0 );
+    frontierWords.clear();
+    nextWords.clear();
+    if ( expandedLayer.size() != m_passable.size() )
+    {
+        expandedLayer.assign( m_passable.size(), 0 );
+        workspace.m_layerStamp = 0;
+    }
+
+    frontier[startWord] = startBit;
+    unvisited[startWord] &= ~startBit;
+    frontierWords.push_back( static_cast<uint32_t>( startWord ) );
+    peakWords = 1;
+    size_t frontierFirstRow = start_row + 1; // the first padded row holding frontier bits
+    size_t frontierLastRow = start_row + 1; // the last padded row holding frontier bits
+
+    int distance = 0; // the distance of the frontier from the start
+    while ( true )
+    {
+        ++distance;
+        ++layers;
+        if ( ++workspace.m_layerStamp == 0 ) // the stamp wrapped, so forget every stamp handed out before
+        {
+            std::fill( expandedLayer.begin(), expandedLayer.end(), 0 );
+            workspace.m_layerStamp = 1;
+        }
+        const uint32_t layerStamp = workspace.m_layerStamp; // marks the words expanded in this layer
+        uint64_t exitsReached = 0; // any exit bits in the new layer
+        size_t reachedFirstRow = m_rows + 1; // the first padded row the new layer reached
+        size_t reachedLastRow = 0; // the last padded row the new layer reached
+
+        const size_t firstRow = std::max<size_t>( frontierFirstRow - 1, 1 ); // the frontier can only reach one row further each way
+        const size_t lastRow = std::min( frontierLastRow + 1, m_rows );
+        const size_t sweepCost = ( lastRow - firstRow + 1 ) * m_wordsPerRow; // the words a sweep would expand
+        const size_t sparseCost = frontierWords.size() * 5; // the words a sparse layer could expand
+        if ( sweepCost <= sparseCost ) // the frontier is wide, so sweep the rows it could reach
+        {
+            for ( size_t row = firstRow; row <= lastRow; ++row )
+            {
+                uint64_t * reached = &next[row * m_rowStride]; // the new layer row
+                uint64_t * open = &unvisited[row * m_rowStride]; // the unvisited row
+                const uint64_t * exits = &m_exits[row * m_rowStride]; // the exit row
+                size_t word = 1; // the words of a row start after the padding word
+#ifdef __AVX2__
+                const uint64_t * above = &frontier[( row - 1 ) * m_rowStride]; // the frontier row above
+                const uint64_t * current = &frontier[row * m_rowStride]; // the frontier row
+                const uint64_t * below = &frontier[( row + 1 ) * m_rowStride]; // the frontier row below
+                __m256i exitsVector = _mm256_setzero_si256();
+                for ( ; word + 4 <= m_wordsPerRow + 1; word += 4 )
+                {
+                    const __m256i middle = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( current + word ) );
+                    const __m256i left = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( current + word - 1 ) );
+                    const __m256i right = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( current + word + 1 ) );
+                    __m256i expanded = _mm256_or_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i *>( above + word ) ),
+                                                        _mm256_loadu_si256( reinterpret_cast<const __m256i *>( below + word ) ) );
+                    expanded = _mm256_or_si256( expanded, _mm256_or_si256( _mm256_slli_epi64( middle, 1 ), _mm256_srli_epi64( left, 63 ) ) );
+                    expanded = _mm256_or_si256( expanded, _mm256_or_si256( _mm256_srli_epi64( middle, 1 ), _mm256_slli_epi64( right, 63 ) ) );
+                    const __m256i unvisitedWords = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( open + word ) );
+                    expanded = _mm256_and_si256( expanded, unvisitedWords );
+                    _mm256_storeu_si256( reinterpret_cast<__m256i *>( open + word ), _mm256_andnot_si256( expanded, unvisitedWords ) );
+                    exitsVector = _mm256_or_si256( exitsVector, _mm256_and_si256( expanded, _mm256_loadu_si256( reinterpret_cast<const __m256i *>( exits + word ) ) ) );
+                    if ( !_mm256_testz_si256( expanded, expanded ) ) // only the non-empty words are stored and listed
+                    {
+                        _mm256_storeu_si256( reinterpret_cast<__m256i *>( reached + word ), expanded );
+                        for ( size_t lane = 0; lane < 4; ++lane )
+                        {
+                            if ( reached[word + lane] != 0 )
+                            {
+                                nextWords.push_back( static_cast<uint32_t>( row * m_rowStride + word + lane ) );
+                            }
+                        }
+                        reachedFirstRow = std::min( reachedFirstRow, row );
+                        reachedLastRow = row;
+                    }
+                }
+                exitsReached |= _mm256_testz_si256( exitsVector, exitsVector ) ? 0 : 1;
+#endif
+                for ( ; word <= m_wordsPerRow; ++word )
+                {
+                    const uint64_t expanded = ExpandWord( frontier.data(), row * m_rowStride + word, m_rowStride, open[word] );
+                    if ( expanded != 0 ) // only the non-empty words are stored and listed
+                    {
+                        reached[word] = expanded;
+                        open[word] &= ~expanded;
+                        exitsReached |= expanded & exits[word];
+                        nextWords.push_back( static_cast<uint32_t>( row * m_rowStride + word ) );
+                        reachedFirstRow = std::min( reachedFirstRow, row );
+                        reachedLastRow = row;
+                    }
+                }
+            }
+        }
+        else // the frontier is thin, so only expand the words next to it
+        {
+            const ptrdiff_t neighbourWords[] = { 0, -1, 1, -static_cast<ptrdiff_t>( m_rowStride ), static_cast<ptrdiff_t>( m_rowStride ) }; // a word and the words around it
+            for ( const uint32_t frontierWord : frontierWords )
+            {
+                for ( const ptrdiff_t offset : neighbourWords )
+                {
+                    const size_t word = frontierWord + offset; // the word to expand into
+                    if ( unvisited[word] == 0 || expandedLayer[word] == layerStamp ) // nothing to reach, or already expanded; padding words are never passable
+                    {
+                        continue;
+                    }
+                    expandedLayer[word] = layerStamp;
+                    const uint64_t expanded = ExpandWord( frontier.data(), word, m_rowStride, unvisited[word] );
+                    if ( expanded != 0 )
+                    {
+                        next[word] = expanded;
+                        unvisited[word] &= ~expanded;
+                        exitsReached |= expanded & m_exits[word];
+                        nextWords.push_back( static_cast<uint32_t>( word ) );
+                        const size_t row = word / m_rowStride; // the padded row of the word
+                        reachedFirstRow = std::min( reachedFirstRow, row );
+                        reachedLastRow = std::max( reachedLastRow, row );
+                    }
+                }
+            }
+        }
+
+        if ( exitsReached != 0 ) // the new layer reached an exit
+        {
+            return distance;
+        }
+        if ( nextWords.empty() ) // the new layer is empty, so no exit can be reached
+        {
+            return Maze::PATH_UNREACHABLE;
+        }
+
+        for ( const uint32_t frontierWord : frontierWords ) // empty the old frontier so it can hold the following layer
+        {
+            frontier[frontierWord] = 0;
+        }
+        frontier.swap( next );
+        frontierWords.swap( nextWords );
+        peakWords = std::max( peakWords, frontierWords.size() );
+        nextWords.clear();
+        frontierFirstRow = reachedFirstRow;
+        frontierLastRow = reachedLastRow;
+    }
+}
+
+/** Retrieves the index of the word holding a maze cell.
+
+@param row The row of the cell.
+@param column The column of the cell.
+
+@return The index of the word within a bit plane.
+*/
+size_t BitGrid::WordIndex( const size_t row, const size_t column ) const
+{
+    return ( row + 1 ) * m_rowStride + 1 + column / BITS_PER_WORD;
+}
+
+/** Retrieves the bit of a maze column within its word.
+
+@param column The column of the cell.
+
+@return The bit mask of the column.
+*/
+uint64_t BitGrid::ColumnBit( const size_t column ) const
+{
+    return static_cast<uint64_t>( 1 ) << ( column % BITS_PER_WORD );
+}
@@ -0,0 +1,54 @@
+// Joseph Miller (c) 2019
+#ifndef __BIT_GRID_H
+#define __BIT_GRID_H
+
+#include "ScratchAllocator.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Scratch bit planes for BitGrid::ExitDistance.
+    The planes keep their capacity between searches, so repeated searches of the same grid don't allocate.
+    A workspace may only be used by one search at a time.
+*/
+class BitGridWorkspace
+{
+    public:
+        BitGridWorkspace() = default;
+        ~BitGridWorkspace() = default;
+
+    private:
+        friend class BitGrid;
+
+        ScratchVector<uint64_t> m_unvisited; ///< Passable cells that haven't been reached yet.
+        ScratchVector<uint64_t> m_frontier; ///< The cells reached in the latest layer; only listed words are non-zero.
+        ScratchVector<uint64_t> m_next; ///< The cells reached in the layer being built.
+        ScratchVector<uint32_t> m_frontierWords; ///< The non-empty words of the frontier.
+        ScratchVector<uint32_t> m_nextWords; ///< The non-empty words of the layer being built.
+        ScratchVector<uint32_t> m_expandedLayer; ///< The last layer stamp each word was expanded in, so sparse layers expand a word once.
+        uint32_t m_layerStamp{ 0 }; ///< The stamp of the latest layer, carried across searches so m_expandedLayer never needs clearing.
+};
+
+class BitGrid
+{
+    public:
+        BitGrid() = default;
+        ~BitGrid() = default;
+        static size_t PlaneBytes( const size_t rows, const size_t columns );
+        void Reset( const size_t rows, const size_t columns );
+        void SetCell( const size_t row, const size_t column, const bool passable, const bool exit );
+        int ExitDistance( const size_t start_row, const size_t start_column, size_t & layers, size_t & peakWords, BitGridWorkspace & workspace ) const;
+
+    private:
+        size_t WordIndex( const size_t row, const size_t column ) const;
+        uint64_t ColumnBit( const size_t column ) const;
+
+        size_t m_rows{ 0 }; ///< The number of maze rows.
+        size_t m_columns{ 0 }; ///< The number of maze columns.
+        size_t m_wordsPerRow{ 0 }; ///< The number of 64-bit words holding one row of cells.
+        size_t m_rowStride{ 0 }; ///< The number of words in one padded row (one empty word on each side).
+        std::vector<uint64_t> m_passable; ///< One bit per cell that can be traveled through, with an empty border of rows and words.
+        std::vector<uint64_t> m_exits; ///< One bit per exit cell, laid out like m_passable.
+};
+
+#endif // __BIT_GRID_H
@@ -0,0 +1,67 @@
+// Joseph Miller (c) 2019
+// A simple query server client: sends std in to the server and writes the answers to std out.
+
+#include "Socket.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char * const DEFAULT_ADDRESS = "unix:/tmp/mazefinder.sock"; ///< Where the server listens unless told otherwise.
+static constexpr size_t CLIENT_BUFFER_BYTES = static_cast<size_t>( 1 ) << 16; ///< The most bytes moved at once in either direction.
+
+/** Main. Connects to the server, then pipelines every line of std in to it while writing its answers to std out
+    as they arrive, so a whole query file costs one round trip rather than one per line.
+
+@param argc The number of command line arguments.
+@param argv The command line arguments: optionally the server address, "unix:PATH" or "tcp:PORT".
+
+@return EXIT_SUCCESS, or EXIT_FAILURE if the server can't be reached or the connection fails.
+*/
+int main( int argc, char ** argv )
+{
+    const std::string address = argc > 1 ? argv[1] : DEFAULT_ADDRESS; // the server
+    if ( argc > 2 )
+    {
+        std::cerr << "Usage: " << argv[0] << " [unix:PATH|tcp:PORT] < requests" << std::endl;
+        return EXIT_FAILURE;
+    }
+    Socket socket;
+    if ( !socket.Connect( address ) )
+    {
+        std::cerr << "Error connecting to: " << address << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bool sent = true; // whether every request reached the server
+    std::thread sender( [&socket, &sent]() // writes while the main thread reads, so neither side's buffers fill up and stall the other
+    {
+        std::vector<char> buffer( CLIENT_BUFFER_BYTES ); // the requests being sent
+        for ( size_t bytes = std::fread( buffer.data(), 1, buffer.size(), stdin ); bytes > 0; bytes = std::fread( buffer.data(), 1, buffer.size(), stdin ) )
+        {
+            if ( !socket.WriteAll( buffer.data(), bytes ) )
+            {
+                sent = false;
+                break;
+            }
+        }
+        socket.ShutdownWrite(); // tells the server the last request has been sent
+    } );
+
+    std::vector<char> buffer( CLIENT_BUFFER_BYTES ); // the answers being received
+    ptrdiff_t bytes = 0;
+    while ( ( bytes = socket.Read( buffer.data(), buffer.size() ) ) > 0 )
+    {
+        std::fwrite( buffer.data(), 1, static_cast<size_t>( bytes ), stdout );
+    }
+    sender.join();
+    std::fflush( stdout );
+    if ( bytes < 0 || !sent )
+    {
+        std::cerr << "Connection to " << address << " failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+// Joseph Miller (c) 2019
+// The cell layouts of Maze: the copy of the grid in tiled or Z-order the cell by cell searches walk instead of the rows.
+
+#include "Maze.h"
+#include "GridLayout.h"
+#include <algorithm>
+#include <limits>
+
+/** Sets the order of the cells the cell by cell searches walk.
+    Breadth first search, depth first search, A*, jump point search, Dijkstra's algorithm, and the bidirectional
+    and parallel searches walk a copy of the grid kept in the layout's order, with their scratch buffers indexed
+    the same way, so the cells above and below a cell are usually on its cache line (TILED) or page (MORTON) rather
+    than a whole row away. The copy costs a byte a cell, more for mazes that don't fill whole blocks, and is kept
+    up to date by SetCell. The bit-parallel search, the distance field, and the hierarchy keep the row-major grid,
+    since they read whole rows or precomputed tables. The layout never changes an answer.
+    Must not be called while queries on the maze are running.
+
+@param layout The layout to search in; it carries over to mazes loaded later.
+
+@retval true if the searches use the layout, or will once a maze is loaded.
+@retval false if the copy of the loaded maze wouldn't fit the memory limit, so the searches walk the rows.
+*/
+bool Maze::SetGridLayout( const GRID_LAYOUT layout )
+{
+    m_layout = layout;
+    BuildLayoutGrid();
+    return !MazeLoaded() || GetGridLayout() == layout;
+}
+
+/** Retrieves the order of the cells the cell by cell searches walk.
+
+@return the layout searched in, which is ROW_MAJOR when the copy for the chosen layout couldn't be built.
+*/
+Maze::GRID_LAYOUT Maze::GetGridLayout() const
+{
+    return SearchLayout();
+}
+
+/** Chooses the layout the searches run in: the chosen layout once its copy of the grid is built, or the rows.
+
+@return the layout to pass to WithLayout.
+*/
+Maze::GRID_LAYOUT Maze::SearchLayout() const
+{
+    return m_layoutCells.empty() ? GRID_LAYOUT::ROW_MAJOR : m_layout;
+}
+
+/** Copies the padded grid into the order of the chosen layout, padding it with blocked cells out to whole blocks.
+    Nothing is copied for the row-major layout, or when the copy and the rest of the loaded maze wouldn't fit the
+    memory limit, or the copy wouldn't fit 32-bit indices.
+*/
+void Maze::BuildLayoutGrid()
+{
+    m_layoutCells.clear();
+    m_layoutCells.shrink_to_fit();
+    m_layoutRowCells = 0;
+    if ( !MazeLoaded() )
+    {
+        return;
+    }
+    WithLayout( m_layout, [&]( auto layout )
+    {
+        using LAYOUT_POLICY = decltype( layout );
+        if constexpr ( LAYOUT_POLICY::BLOCK_SIDE > 1 )
+        {
+            const size_t paddedRows = m_rowSize + 2; // the rows including the top and bottom border
+            const size_t blockRows = ( paddedRows + LAYOUT_POLICY::BLOCK_SIDE - 1 ) / LAYOUT_POLICY::BLOCK_SIDE; // the rows of blocks
+            const size_t blockColumns = ( m_stride + LAYOUT_POLICY::BLOCK_SIDE - 1 ) / LAYOUT_POLICY::BLOCK_SIDE; // the blocks across a row of blocks
+            const size_t loadedBytes = LoadedBytes( m_rowSize, m_columnSize ); // what the maze already holds
+            const size_t spareBytes = ( m_memoryLimit > loadedBytes ) ? m_memoryLimit - loadedBytes : 0; // what the limit leaves for the copy
+            const size_t maxCells = std::min<size_t>( spareBytes / sizeof( MAZE_DATA_TYPE ), std::numeric_limits<uint32_t>::max() ); // the largest copy allowed
+            if ( blockColumns > maxCells / LAYOUT_POLICY::BLOCK_CELLS / blockRows )
+            {
+                return;
+            }
+            m_layoutRowCells = blockColumns * LAYOUT_POLICY::BLOCK_CELLS;
+            m_layoutCells.assign( blockRows * m_layoutRowCells, MAZE_DATA_TYPE::BLOCKED );
+            const MAZE_DATA_TYPE * cells = Cells(); // the padded grid
+            for ( size_t row = 0; row < paddedRows; ++row )
+            {
+                for ( size_t column = 0; column < m_stride; ++column )
+                {
+                    m_layoutCells[LAYOUT_POLICY::Index( row, column, m_layoutRowCells )] = cells[row * m_stride + column];
+                }
+            }
+        }
+    } );
+}
+
+/** Changes a cell of the copy of the grid in the chosen layout, if there is one.
+
+@param row The row of the cell to change.
+@param column The column of the cell to change.
+@param type What the cell becomes.
+*/
+void Maze::SetLayoutCell( const size_t row, const size_t column, const MAZE_DATA_TYPE type )
+{
+    if ( m_layoutCells.empty() )
+    {
+        return;
+    }
+    WithLayout( m_layout, [&]( auto layout )
+    {
+        m_layoutCells[decltype( layout )::Index( row + 1, column + 1, m_layoutRowCells )] = type;
+    } );
+}
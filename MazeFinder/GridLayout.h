@@ -0,0 +1,230 @@
+// Joseph Miller (c) 2019
+#ifndef __GRID_LAYOUT_H
+#define __GRID_LAYOUT_H
+
+#include "Maze.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/** Spreads the low 16 bits of a value out to the even bits, so two spread values interleave into a Z-order index.
+
+@param value The value to spread; only its low 16 bits are kept.
+
+@return The bits of value at twice their position.
+*/
+constexpr size_t SpreadBits( const size_t value )
+{
+    size_t bits = value & 0xFFFF; // the bits left to spread
+    bits = ( bits | ( bits << 8 ) ) & 0x00FF00FF;
+    bits = ( bits | ( bits << 4 ) ) & 0x0F0F0F0F;
+    bits = ( bits | ( bits << 2 ) ) & 0x33333333;
+    bits = ( bits | ( bits << 1 ) ) & 0x55555555;
+    return bits;
+}
+
+/** Gathers the even bits of a value back together, undoing SpreadBits.
+
+@param value The value to gather; only its low 32 bits are read.
+
+@return The even bits of value at half their position.
+*/
+constexpr size_t GatherBits( const size_t value )
+{
+    size_t bits = value & 0x55555555; // the bits left to gather
+    bits = ( bits | ( bits >> 1 ) ) & 0x33333333;
+    bits = ( bits | ( bits >> 2 ) ) & 0x0F0F0F0F;
+    bits = ( bits | ( bits >> 4 ) ) & 0x00FF00FF;
+    bits = ( bits | ( bits >> 8 ) ) & 0x0000FFFF;
+    return bits;
+}
+
+/** Stores the padded grid one row after another, as the maze itself does, so a move up or down is a whole row away.
+    Every layout maps a padded row and column to an index given the number of cells in one row of its blocks; here
+    a block is a single cell, so that is the padded stride, and a move is the offset it adds to an index.
+*/
+struct RowMajorLayout
+{
+    static constexpr size_t BLOCK_SIDE = 1; ///< The width and height of the blocks of cells stored together.
+    using Step = ptrdiff_t; ///< A move, as the offset it adds to an index.
+
+    static constexpr size_t Index( const size_t row, const size_t column, const size_t rowCells )
+    {
+        return row * rowCells + column;
+    }
+
+    static constexpr size_t Row( const size_t index, const size_t rowCells )
+    {
+        return index / rowCells;
+    }
+
+    static constexpr size_t Column( const size_t index, const size_t rowCells )
+    {
+        return index % rowCells;
+    }
+
+    static constexpr Step MakeStep( const ptrdiff_t rowStep, const ptrdiff_t columnStep, const size_t rowCells )
+    {
+        return rowStep * static_cast<ptrdiff_t>( rowCells ) + columnStep;
+    }
+
+    static constexpr size_t Move( const size_t index, const Step step )
+    {
+        return index + step;
+    }
+};
+
+/** A move through a blocked layout, worked out once per search for each direction.
+*/
+struct BlockedStep
+{
+    size_t columnAdd; ///< Added to the column bits: 1 to move right, all of them to move left, or 0.
+    size_t rowAdd; ///< Added to the row bits: their lowest bit to move down, all of them to move up, or 0.
+    size_t rowWrap; ///< The row bits of the cells the move leaves their block from, meaningful only when rowCarry isn't 0.
+    size_t rowCarry; ///< Added to the index when the move leaves its block up or down: plus or minus a row of blocks, or 0.
+};
+
+/** Stores the padded grid in square blocks of BLOCK_SIDE cells a side, each block contiguous, and the blocks one row
+    of blocks after another. Within a block the cells run row after row, or in Z-order when Z_ORDER is set, and the
+    grid is padded with blocked cells out to whole blocks.
+    A cell's index within its block interleaves its row bits, ROW_BITS, with its column bits. The column bits run on
+    into the block number above them, so moving left or right is an addition to every bit but the row bits, whose
+    carry steps into the next block; moving up or down is an addition to the row bits alone, plus a row of blocks
+    when it wraps. Either is a few bit operations without a branch, and the mappings are constexpr.
+*/
+template <size_t BLOCK_SHIFT, bool Z_ORDER>
+struct BlockedLayout
+{
+    static_assert( BLOCK_SHIFT > 0 && BLOCK_SHIFT <= 16, "SpreadBits and GatherBits handle blocks of up to 65536 cells a side" );
+
+    static constexpr size_t BLOCK_SIDE = static_cast<size_t>( 1 ) << BLOCK_SHIFT; ///< The width and height of the blocks of cells stored together.
+    static constexpr size_t BLOCK_CELLS = BLOCK_SIDE * BLOCK_SIDE; ///< The number of cells in a block.
+    static constexpr size_t ROW_BITS = Z_ORDER ? SpreadBits( BLOCK_SIDE - 1 ) << 1 : ( BLOCK_SIDE - 1 ) << BLOCK_SHIFT; ///< The bits of an index within a block that hold the row.
+    using Step = BlockedStep; ///< A move, as the additions it makes to an index.
+
+    static constexpr size_t Local( const size_t row, const size_t column )
+    {
+        return Z_ORDER ? ( SpreadBits( column ) | ( SpreadBits( row ) << 1 ) ) : ( ( row << BLOCK_SHIFT ) | column );
+    }
+
+    static constexpr size_t Index( const size_t row, const size_t column, const size_t rowCells )
+    {
+        return ( row >> BLOCK_SHIFT ) * rowCells + ( column >> BLOCK_SHIFT ) * BLOCK_CELLS + Local( row & ( BLOCK_SIDE - 1 ), column & ( BLOCK_SIDE - 1 ) );
+    }
+
+    static constexpr size_t Row( const size_t index, const size_t rowCells )
+    {
+        const size_t local = index & ( BLOCK_CELLS - 1 ); // the index within the block
+        return ( index / rowCells ) * BLOCK_SIDE + ( Z_ORDER ? GatherBits( local >> 1 ) : local >> BLOCK_SHIFT );
+    }
+
+    static constexpr size_t Column( const size_t index, const size_t rowCells )
+    {
+        const size_t local = index & ( BLOCK_CELLS - 1 ); // the index within the block
+        return ( ( index % rowCells ) >> ( 2 * BLOCK_SHIFT ) ) * BLOCK_SIDE + ( Z_ORDER ? GatherBits( local ) : local & ( BLOCK_SIDE - 1 ) );
+    }
+
+    static constexpr Step MakeStep( const ptrdiff_t rowStep, const ptrdiff_t columnStep, const size_t rowCells )
+    {
+        Step step{ 0, 0, 0, 0 };
+        if ( columnStep != 0 )
+        {
+            step.columnAdd = ( columnStep > 0 ) ? 1 : ~ROW_BITS; // every column bit set is minus one
+        }
+        if ( rowStep != 0 )
+        {
+            step.rowAdd = ( rowStep > 0 ) ? ( ROW_BITS & ( ~ROW_BITS + 1 ) ) : ROW_BITS; // the lowest row bit, or minus one
+            step.rowWrap = ( rowStep > 0 ) ? ROW_BITS : 0;
+            step.rowCarry = ( rowStep > 0 ) ? rowCells : ~rowCells + 1;
+        }
+        return step;
+    }
+
+    static constexpr size_t Move( const size_t index, const Step & step )
+    {
+        const size_t row = index & ROW_BITS; // the row bits before the move
+        const size_t moved = ( ( ( index | ROW_BITS ) + step.columnAdd ) & ~ROW_BITS ) | row; // the setting of the row bits carries across them
+        return ( ( ( moved | ~ROW_BITS ) + step.rowAdd ) & ROW_BITS ) + ( moved & ~ROW_BITS ) + ( ( row == step.rowWrap ) ? step.rowCarry : 0 );
+    }
+};
+
+using TiledLayout = BlockedLayout<3, false>; ///< 8 by 8 tiles, each one 64 byte cache line of cells, so a move up or down usually stays in its line.
+using MortonLayout = BlockedLayout<6, true>; ///< 64 by 64 blocks in Z-order, each one 4 KiB page of cells, and every aligned square within one contiguous.
+
+/** The cells the searches walk, in the order of a layout.
+*/
+template <typename LAYOUT_POLICY>
+struct LayoutGrid
+{
+    const Maze::MAZE_DATA_TYPE * cells; ///< The padded grid in the layout's order.
+    size_t cellCount; ///< The number of cells, including the border and the padding out to whole blocks.
+    size_t rowCells; ///< The number of cells in one row of blocks; for the row-major layout, the padded stride.
+
+    /** Converts a maze position into an index of the grid.
+    */
+    size_t Index( const size_t row, const size_t column ) const
+    {
+        return LAYOUT_POLICY::Index( row + 1, column + 1, rowCells );
+    }
+
+    /** Retrieves the padded row of a cell.
+    */
+    size_t Row( const size_t index ) const
+    {
+        return LAYOUT_POLICY::Row( index, rowCells );
+    }
+
+    /** Retrieves the padded column of a cell.
+    */
+    size_t Column( const size_t index ) const
+    {
+        return LAYOUT_POLICY::Column( index, rowCells );
+    }
+};
+
+/** Retrieves the grid the searches walk in a layout: the padded grid itself for the row-major layout, or the copy
+    kept in the layout's order otherwise.
+
+@return The cells, their count, and the cells in a row of blocks.
+*/
+template <typename LAYOUT_POLICY>
+LayoutGrid<LAYOUT_POLICY> Maze::Grid() const
+{
+    if constexpr ( std::is_same_v<LAYOUT_POLICY, RowMajorLayout> )
+    {
+        return { Cells(), m_cellCount, m_stride };
+    }
+    else
+    {
+        return { m_layoutCells.data(), m_layoutCells.size(), m_layoutRowCells };
+    }
+}
+
+/** Runs a search with the policy of a layout, choosing the template instantiation once per query.
+
+@param layout The layout to search in.
+@param search Called with a default constructed policy, whose type selects the instantiation.
+
+@return What search returns.
+*/
+template <typename SEARCH>
+inline auto WithLayout( const Maze::GRID_LAYOUT layout, SEARCH && search )
+{
+    switch ( layout )
+    {
+        case Maze::GRID_LAYOUT::TILED:
+        {
+            return search( TiledLayout() );
+        } break;
+        case Maze::GRID_LAYOUT::MORTON:
+        {
+            return search( MortonLayout() );
+        } break;
+        default:
+        {
+            return search( RowMajorLayout() );
+        } break;
+    }
+}
+
+#endif // __GRID_LAYOUT_H
@@ -0,0 +1,456 @@
+// Joseph Miller (c) 2019
+// The heuristic searches of Maze: A* and jump point search, both guided by ExitDistanceLowerBound.
+
+#include "Maze.h"
+#include "GridLayout.h"
+#include "Neighbourhood.h"
+#include <algorithm>
+#include <limits>
+
+static constexpr size_t NO_JUMP_POINT = std::numeric_limits<size_t>::max(); ///< Returned by a jump that runs into a wall.
+static constexpr uint8_t JUMP_UP = 0; ///< Jump point search direction towards the row above.
+static constexpr uint8_t JUMP_LEFT = 1; ///< Jump point search direction towards the column to the left.
+static constexpr uint8_t JUMP_DOWN = 2; ///< Jump point search direction towards the row below.
+static constexpr uint8_t JUMP_RIGHT = 3; ///< Jump point search direction towards the column to the right.
+static constexpr size_t JUMP_DIRECTIONS = 4; ///< The number of directions a jump point can be reached in.
+
+/** Retrieves the minimum number of spaces using A*.
+    Gives the same answers as MinimumNumberOfSpacesBFS, but expands the cells closest to an exit first,
+    so mazes with few, distant exits are searched without flooding everything around the start.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+
+@return The minimum number of spaces from the start to the closest end point (-1 if no end point could be reached from start or if start was invalid), with the statistics of the search.
+*/
+SearchResult Maze::MinimumNumberOfSpacesAStar( const size_t start_row, const size_t start_column ) const
+{
+    return TimedSearch( start_row, start_column, SEARCH_ALGORITHM::A_STAR );
+}
+
+/** Retrieves the minimum number of spaces using jump point search.
+    Gives the same answers as MinimumNumberOfSpacesBFS. Straight runs of open cells are skipped over in one jump,
+    so only the few cells where a shortest path may have to turn are ever put on the open list.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+
+@return The minimum number of spaces from the start to the closest end point (-1 if no end point could be reached from start or if start was invalid), with the statistics of the search.
+*/
+SearchResult Maze::MinimumNumberOfSpacesJumpPoint( const size_t start_row, const size_t start_column ) const
+{
+    return TimedSearch( start_row, start_column, SEARCH_ALGORITHM::JUMP_POINT );
+}
+
+/** Finds the minimum number of spaces to the nearest exit using A* in the maze's layout.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param workspace The buffers to search with.
+@param result Receives the number of cells expanded and the largest the open list grew.
+
+@return The minimum number of spaces from the start to the closest end point, or -1 if no end point could be reached from start or if start was invalid.
+*/
+template <bool RECORD_PATH>
+int Maze::SearchAStar( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const
+{
+    return WithLayout( SearchLayout(), [&]( auto layout )
+    {
+        return AStarSearch<decltype( layout ), RECORD_PATH>( start_row, start_column, workspace, result );
+    } );
+}
+
+/** Finds the minimum number of spaces to the nearest exit using A*.
+    Cells are expanded in order of depth plus ExitDistanceLowerBound. The bound is the Manhattan distance to the
+    closest exit, which changes by at most one between neighbours, so a neighbour's estimate is never smaller than
+    its parent's and at most two larger. The open list is therefore three buckets used as a ring instead of a heap,
+    and each bucket is a stack so the deepest cells of an estimate (those closest to an exit) come off first.
+    When RECORD_PATH is set the direction each cell is reached in and the exit found are kept in the workspace for
+    TracePath; the heuristic is consistent, so a cell's direction is final once it is expanded.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param workspace The buffers to search with.
+@param result Receives the number of cells expanded and the largest the open list grew.
+
+@return The minimum number of spaces from the start to the closest end point, or -1 if no end point could be reached from start or if start was invalid.
+*/
+template <typename LAYOUT_POLICY, bool RECORD_PATH>
+int Maze::AStarSearch( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const
+{
+    if ( start_row >= m_rowSize || start_column >= m_columnSize ) // check that the row and column for start is within bounds
+    {
+        return PATH_UNREACHABLE;
+    }
+    const LayoutGrid<LAYOUT_POLICY> grid = Grid<LAYOUT_POLICY>(); // the padded grid in the layout's order
+    const MAZE_DATA_TYPE * cells = grid.cells;
+    const size_t startIndex = grid.Index( start_row, start_column ); // the index of the starting position
+    switch ( cells[startIndex] )
+    {
+        case MAZE_DATA_TYPE::EXIT: // If the start is the exit, the end point costs 0 spaces
+        {
+            return 0;
+        } break;
+        case MAZE_DATA_TYPE::BLOCKED: // a blocked start can't travel anywhere
+        {
+            return PATH_UNREACHABLE;
+        } break;
+        default:
+        {
+        } break;
+    }
+    if ( m_exits.empty() ) // without an exit there is nothing to search for
+    {
+        return PATH_UNREACHABLE;
+    }
+
+    using StackEntry = SearchWorkspace::StackEntry;
+
+    // steps to the cell above, to the left, below, and to the right; the blocked border keeps these in bounds
+    const NeighbourOffsets<FourWayNeighbourhood, LAYOUT_POLICY> neighbourOffsets( grid.rowCells );
+
+    const uint32_t base = workspace.NextDepthBase( grid.cellCount ); // the depth base of this search
+    uint32_t * bestDepth = workspace.m_bestDepth.data(); // the smallest depth each cell has been reached at, plus the base
+    ScratchVector<StackEntry> * buckets = workspace.m_openBuckets; // the open list, bucketed by estimate modulo 3
+    for ( size_t bucket = 0; bucket < 3; ++bucket )
+    {
+        buckets[bucket].clear();
+    }
+    const auto depthOf = [&]( const size_t index ) // the smallest depth a cell has been reached at, or the largest int if it hasn't been
+    {
+        return ( bestDepth[index] >= base ) ? static_cast<int>( bestDepth[index] - base ) : std::numeric_limits<int>::max();
+    };
+
+    int estimate = ExitDistanceLowerBound( grid, startIndex ); // the estimate being expanded
+    bestDepth[startIndex] = base;
+    if ( RECORD_PATH )
+    {
+        workspace.m_parents.resize( ( grid.cellCount * FourWayNeighbourhood::PARENT_BITS + 7 ) / 8 );
+    }
+    buckets[estimate % 3].push_back( { static_cast<uint32_t>( startIndex ), 0, estimate } );
+    size_t openCount = 1; // the number of entries across the buckets
+
+    while ( openCount > 0 )
+    {
+        ScratchVector<StackEntry> & bucket = buckets[estimate % 3]; // the entries with the current estimate
+        if ( bucket.empty() ) // nothing left at this estimate, so move on to the next
+        {
+            ++estimate;
+            continue;
+        }
+        const StackEntry current = bucket.back(); // the cell to expand
+        bucket.pop_back();
+        --openCount;
+        if ( current.depth > depthOf( current.index ) ) // reached at a smaller depth after being pushed
+        {
+            continue;
+        }
+        if ( cells[current.index] == MAZE_DATA_TYPE::EXIT ) // the first exit off the open list is the nearest
+        {
+            if ( RECORD_PATH )
+            {
+                workspace.m_pathEnd = current.index;
+            }
+            return current.depth;
+        }
+
+        ++result.cellsExpanded;
+        const int depth = current.depth + 1; // the depth of the surrounding points
+        for ( uint8_t direction = 0; direction < 4; ++direction )
+        {
+            const size_t neighbourIndex = neighbourOffsets.Move( current.index, direction );
+            const MAZE_DATA_TYPE neighbour = cells[neighbourIndex];
+            if ( neighbour == MAZE_DATA_TYPE::BLOCKED || depth >= depthOf( neighbourIndex ) )
+            {
+                if ( neighbour != MAZE_DATA_TYPE::BLOCKED )
+                {
+                    result.counters.RevisitAvoided();
+                }
+                continue;
+            }
+            const bool exit = ( neighbour == MAZE_DATA_TYPE::EXIT );
+            const int neighbourEstimate = depth + ( exit ? 0 : ExitDistanceLowerBound( grid, neighbourIndex ) ); // never below the current estimate
+            if ( RECORD_PATH )
+            {
+                workspace.SetParent<FourWayNeighbourhood::PARENT_BITS>( neighbourIndex, direction );
+            }
+            if ( exit && neighbourEstimate == estimate ) // nothing left on the open list can reach an exit sooner
+            {
+                if ( RECORD_PATH )
+                {
+                    workspace.m_pathEnd = static_cast<uint32_t>( neighbourIndex );
+                }
+                return depth;
+            }
+            bestDepth[neighbourIndex] = base + depth;
+            buckets[neighbourEstimate % 3].push_back( { static_cast<uint32_t>( neighbourIndex ), depth, neighbourEstimate } );
+            ++openCount;
+            result.counters.Enqueue();
+        }
+        result.peakFrontier = std::max( result.peakFrontier, openCount );
+    }
+
+    return PATH_UNREACHABLE;
+}
+
+template int Maze::SearchAStar<false>( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const;
+template int Maze::SearchAStar<true>( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const;
+
+/** Finds the minimum number of spaces to the nearest exit using jump point search on the 4-connected grid.
+    Any shortest path can be rearranged so that it only turns from vertical to horizontal at a forced cell, one
+    whose side neighbour is open while the cell beside the previous step is blocked; otherwise the turn could be
+    taken one step earlier. Horizontal runs may turn vertical anywhere. So a vertical jump runs straight until it
+    meets a wall, an exit, or a forced cell, and a horizontal jump stops at a cell whose vertical jumps find
+    anything. Only those jump points go on the open list, ordered by depth plus ExitDistanceLowerBound.
+    Depths are kept per cell and direction of arrival, since a cell reached horizontally has more successors than
+    the same cell reached vertically.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param workspace The buffers to search with.
+@param result Receives the number of jump points expanded and the largest the open list grew.
+
+@return The minimum number of spaces from the start to the closest end point, or -1 if no end point could be reached from start or if start was invalid.
+*/
+int Maze::SearchJumpPoint( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const
+{
+    return WithLayout( SearchLayout(), [&]( auto layout )
+    {
+        return JumpPointSearch<decltype( layout )>( start_row, start_column, workspace, result );
+    } );
+}
+
+/** Finds the minimum number of spaces to the nearest exit using jump point search in a layout.
+    The jump directions are numbered like the moves of FourWayNeighbourhood, so a direction is also a move.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param workspace The buffers to search with.
+@param result Receives the number of jump points expanded and the largest the open list grew.
+
+@return The minimum number of spaces from the start to the closest end point, or -1 if no end point could be reached from start or if start was invalid.
+*/
+template <typename LAYOUT_POLICY>
+int Maze::JumpPointSearch( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const
+{
+    if ( start_row >= m_rowSize || start_column >= m_columnSize ) // check that the row and column for start is within bounds
+    {
+        return PATH_UNREACHABLE;
+    }
+    const LayoutGrid<LAYOUT_POLICY> grid = Grid<LAYOUT_POLICY>(); // the padded grid in the layout's order
+    const MAZE_DATA_TYPE * cells = grid.cells;
+    const size_t startIndex = grid.Index( start_row, start_column ); // the index of the starting position
+    switch ( cells[startIndex] )
+    {
+        case MAZE_DATA_TYPE::EXIT: // If the start is the exit, the end point costs 0 spaces
+        {
+            return 0;
+        } break;
+        case MAZE_DATA_TYPE::BLOCKED: // a blocked start can't travel anywhere
+        {
+            return PATH_UNREACHABLE;
+        } break;
+        default:
+        {
+        } break;
+    }
+    if ( m_exits.empty() ) // without an exit there is nothing to search for
+    {
+        return PATH_UNREACHABLE;
+    }
+
+    using JumpEntry = SearchWorkspace::JumpEntry;
+
+    const NeighbourOffsets<FourWayNeighbourhood, LAYOUT_POLICY> moves( grid.rowCells ); // indexed by JUMP_UP, JUMP_LEFT, JUMP_DOWN, JUMP_RIGHT
+    const auto later = []( const JumpEntry & first, const JumpEntry & second ) // orders the heap by estimate, deepest first on ties
+    {
+        return first.estimate > second.estimate || ( first.estimate == second.estimate && first.depth < second.depth );
+    };
+
+    const uint32_t stamp = workspace.NextStamp(); // marks the cells this search has reached
+    workspace.m_cellStamps.resize( grid.cellCount, 0 );
+    uint32_t * reached = workspace.m_cellStamps.data();
+    ScratchVector<int> & jumpDepth = workspace.m_jumpDepth; // the smallest depth each cell has been reached at, per direction, where reached
+    ScratchVector<JumpEntry> & heap = workspace.m_jumpHeap; // the jump points still to expand
+    jumpDepth.resize( grid.cellCount * JUMP_DIRECTIONS );
+    heap.clear();
+    const auto depthOf = [&]( const size_t index, const uint8_t direction ) // the smallest depth a cell has been reached at in a direction, or the largest int if it hasn't been
+    {
+        return ( reached[index] == stamp ) ? jumpDepth[index * JUMP_DIRECTIONS + direction] : std::numeric_limits<int>::max();
+    };
+    const auto reach = [&]( const size_t index, const uint8_t direction, const int depth ) // records a cell reached in a direction, resetting its other directions on the first reach
+    {
+        if ( reached[index] != stamp )
+        {
+            reached[index] = stamp;
+            std::fill_n( jumpDepth.begin() + index * JUMP_DIRECTIONS, JUMP_DIRECTIONS, std::numeric_limits<int>::max() );
+        }
+        jumpDepth[index * JUMP_DIRECTIONS + direction] = depth;
+    };
+    for ( uint8_t direction = 0; direction < JUMP_DIRECTIONS; ++direction ) // the start is never worth reaching again
+    {
+        reach( startIndex, direction, 0 );
+    }
+
+    const auto jump = [&]( const size_t from, const int depth, const uint8_t direction ) // jumps from a cell and opens the jump point found
+    {
+        int distance = 0; // the length of the jump
+        const size_t jumpPoint = ( direction == JUMP_UP || direction == JUMP_DOWN ) ? JumpVertical( cells, moves, from, direction, distance ) : JumpHorizontal( cells, moves, from, direction, distance );
+        if ( jumpPoint == NO_JUMP_POINT || depth + distance >= depthOf( jumpPoint, direction ) )
+        {
+            if ( jumpPoint != NO_JUMP_POINT )
+            {
+                result.counters.RevisitAvoided();
+            }
+            return;
+        }
+        reach( jumpPoint, direction, depth + distance );
+        const int estimate = depth + distance + ( ( cells[jumpPoint] == MAZE_DATA_TYPE::EXIT ) ? 0 : ExitDistanceLowerBound( grid, jumpPoint ) );
+        heap.push_back( { static_cast<uint32_t>( jumpPoint ), depth + distance, estimate, direction } );
+        std::push_heap( heap.begin(), heap.end(), later );
+        result.counters.Enqueue();
+        result.peakFrontier = std::max( result.peakFrontier, heap.size() );
+    };
+
+    ++result.cellsExpanded; // the start jumps in every direction
+    for ( uint8_t direction = 0; direction < JUMP_DIRECTIONS; ++direction )
+    {
+        jump( startIndex, 0, direction );
+    }
+
+    while ( !heap.empty() )
+    {
+        std::pop_heap( heap.begin(), heap.end(), later );
+        const JumpEntry current = heap.back(); // the jump point to expand
+        heap.pop_back();
+        if ( current.depth > depthOf( current.index, current.direction ) ) // reached at a smaller depth after being pushed
+        {
+            continue;
+        }
+        if ( cells[current.index] == MAZE_DATA_TYPE::EXIT ) // the first exit off the open list is the nearest
+        {
+            return current.depth;
+        }
+
+        ++result.cellsExpanded;
+        if ( current.direction == JUMP_LEFT || current.direction == JUMP_RIGHT ) // horizontal runs carry on or turn either way
+        {
+            jump( current.index, current.depth, current.direction );
+            jump( current.index, current.depth, JUMP_UP );
+            jump( current.index, current.depth, JUMP_DOWN );
+        }
+        else // vertical runs carry on, and only turn where forced
+        {
+            jump( current.index, current.depth, current.direction );
+            if ( VerticalForced( cells, moves, current.index, current.direction, JUMP_LEFT ) )
+            {
+                jump( current.index, current.depth, JUMP_LEFT );
+            }
+            if ( VerticalForced( cells, moves, current.index, current.direction, JUMP_RIGHT ) )
+            {
+                jump( current.index, current.depth, JUMP_RIGHT );
+            }
+        }
+    }
+
+    return PATH_UNREACHABLE;
+}
+
+/** Jumps up or down from a cell to the next jump point.
+
+@param cells The padded grid, in the layout's order.
+@param moves The steps of the four moves, indexed by jump direction.
+@param from The cell index to jump from.
+@param step The direction of the jump, either JUMP_UP or JUMP_DOWN.
+@param distance Set to the number of steps jumped.
+
+@return The cell index of the wall-free exit or forced cell the jump stops at, or NO_JUMP_POINT if it runs into a wall first.
+*/
+template <typename LAYOUT_POLICY>
+size_t Maze::JumpVertical( const MAZE_DATA_TYPE * cells, const NeighbourOffsets<FourWayNeighbourhood, LAYOUT_POLICY> & moves, const size_t from, const uint8_t step, int & distance ) const
+{
+    size_t index = from; // the cell the jump has reached
+    distance = 0;
+    while ( true )
+    {
+        index = moves.Move( index, step );
+        ++distance;
+        switch ( cells[index] )
+        {
+            case MAZE_DATA_TYPE::BLOCKED: // the blocked border ends every jump
+            {
+                return NO_JUMP_POINT;
+            } break;
+            case MAZE_DATA_TYPE::EXIT:
+            {
+                return index;
+            } break;
+            default:
+            {
+            } break;
+        }
+        if ( VerticalForced( cells, moves, index, step, JUMP_LEFT ) || VerticalForced( cells, moves, index, step, JUMP_RIGHT ) )
+        {
+            return index;
+        }
+    }
+}
+
+/** Jumps left or right from a cell to the next jump point.
+    Every cell passed is also checked for vertical jump points, since a horizontal run may turn anywhere.
+
+@param cells The padded grid, in the layout's order.
+@param moves The steps of the four moves, indexed by jump direction.
+@param from The cell index to jump from.
+@param step The direction of the jump, either JUMP_LEFT or JUMP_RIGHT.
+@param distance Set to the number of steps jumped.
+
+@return The cell index of the exit or the cell with vertical jump points the jump stops at, or NO_JUMP_POINT if it runs into a wall first.
+*/
+template <typename LAYOUT_POLICY>
+size_t Maze::JumpHorizontal( const MAZE_DATA_TYPE * cells, const NeighbourOffsets<FourWayNeighbourhood, LAYOUT_POLICY> & moves, const size_t from, const uint8_t step, int & distance ) const
+{
+    size_t index = from; // the cell the jump has reached
+    distance = 0;
+    while ( true )
+    {
+        index = moves.Move( index, step );
+        ++distance;
+        switch ( cells[index] )
+        {
+            case MAZE_DATA_TYPE::BLOCKED: // the blocked border ends every jump
+            {
+                return NO_JUMP_POINT;
+            } break;
+            case MAZE_DATA_TYPE::EXIT:
+            {
+                return index;
+            } break;
+            default:
+            {
+            } break;
+        }
+        int verticalDistance = 0; // unused; only whether the vertical jumps find anything matters
+        if ( JumpVertical( cells, moves, index, JUMP_UP, verticalDistance ) != NO_JUMP_POINT || JumpVertical( cells, moves, index, JUMP_DOWN, verticalDistance ) != NO_JUMP_POINT )
+        {
+            return index;
+        }
+    }
+}
+
+/** Checks whether a vertical run through a cell is forced to turn to one side.
+
+@param cells The padded grid, in the layout's order.
+@param moves The steps of the four moves, indexed by jump direction.
+@param index The cell index the run has reached.
+@param step The direction of the run, either JUMP_UP or JUMP_DOWN.
+@param side The side to check, either JUMP_LEFT or JUMP_RIGHT.
+
+@retval true if the side cell is open but the cell beside the previous step is blocked.
+@retval false if the turn could have been taken a step earlier, or the side is blocked.
+*/
+template <typename LAYOUT_POLICY>
+bool Maze::VerticalForced( const MAZE_DATA_TYPE * cells, const NeighbourOffsets<FourWayNeighbourhood, LAYOUT_POLICY> & moves, const size_t index, const uint8_t step, const uint8_t side ) const
+{
+    return cells[moves.Move( index, side )] != MAZE_DATA_TYPE::BLOCKED && cells[moves.Move( moves.Move( index, REVERSE_MOVES[step] ), side )] == MAZE_DATA_TYPE::BLOCKED;
+}
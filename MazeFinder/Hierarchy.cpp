@@ -0,0 +1,451 @@
+// Joseph Miller (c) 2019
+// The hierarchical search of Maze: the grid is split into clusters, and queries run on a graph of the cells where
+// paths cross from one cluster into the next, with distances within a cluster precomputed.
+
+#include "Maze.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+static constexpr uint32_t NO_NODE = std::numeric_limits<uint32_t>::max(); ///< Marks a missing hierarchy node, and the nearest exit on the open list.
+static constexpr uint16_t NO_CLUSTER_PATH = std::numeric_limits<uint16_t>::max(); ///< Marks two nodes of a cluster that can't reach each other within it.
+static constexpr size_t MIN_CLUSTER_SIZE = 4; ///< The smallest cluster width and height allowed.
+static constexpr size_t MAX_CLUSTER_SIZE = 128; ///< The largest cluster width and height allowed, so distances within a cluster fit NO_CLUSTER_PATH.
+static constexpr size_t ENTRANCE_SPLIT_LENGTH = 6; ///< Border openings at least this long keep a near-optimal entrance at both ends instead of one in the middle.
+
+/** Builds the hierarchy used by MinimumNumberOfSpacesHierarchical.
+    The maze is split into square clusters. Every passable cell next to a passable cell of another cluster becomes a
+    node, and for every cluster the distance between each pair of its nodes, and from each node to the nearest exit,
+    is found with a breadth first search that stays inside the cluster. Clusters are independent, so they are spread
+    across the workers of the pool.
+    For the near-optimal searches each opening along a cluster border keeps only a few entrance nodes: one in the
+    middle of a short opening, or one at each end of a long one.
+    The hierarchy is discarded when a maze is loaded or a cell is changed.
+
+@param pool The thread pool to build the clusters on.
+@param clusterSize The width and height of a cluster, from MIN_CLUSTER_SIZE to MAX_CLUSTER_SIZE.
+*/
+void Maze::BuildHierarchy( ThreadPool & pool, const size_t clusterSize )
+{
+    AdvanceGeneration();
+    ClearHierarchy();
+    if ( !MazeLoaded() )
+    {
+        return;
+    }
+    const MAZE_DATA_TYPE * cells = Cells(); // the padded grid
+    const ptrdiff_t neighbourOffsets[] = { -static_cast<ptrdiff_t>( m_stride ), -1, static_cast<ptrdiff_t>( m_stride ), 1 }; // offsets to the surrounding cells
+    m_clusterSize = std::min( std::max( clusterSize, MIN_CLUSTER_SIZE ), MAX_CLUSTER_SIZE );
+    m_clusterColumns = ( m_columnSize + m_clusterSize - 1 ) / m_clusterSize;
+    const size_t clusterCount = m_clusterColumns * ( ( m_rowSize + m_clusterSize - 1 ) / m_clusterSize ); // the number of clusters
+
+    // find the nodes; the blocked border means cells on the edge of the maze never cross into another cluster
+    std::vector<uint32_t> nodeOfCell( m_cellCount, NO_NODE ); // the node of every cell, if it is one
+    m_clusterFirstNode.assign( clusterCount + 1, 0 );
+    for ( size_t cluster = 0; cluster < clusterCount; ++cluster )
+    {
+        m_clusterFirstNode[cluster] = static_cast<uint32_t>( m_hierarchyNodes.size() );
+        size_t firstRow, firstColumn, rows, columns;
+        ClusterBounds( cluster, firstRow, firstColumn, rows, columns );
+        for ( size_t row = firstRow; row < firstRow + rows; ++row )
+        {
+            for ( size_t column = firstColumn; column < firstColumn + columns; ++column )
+            {
+                const size_t index = CellIndex( row, column );
+                if ( cells[index] == MAZE_DATA_TYPE::BLOCKED )
+                {
+                    continue;
+                }
+                const bool crossing = ( row == firstRow && cells[index - m_stride] != MAZE_DATA_TYPE::BLOCKED )
+                    || ( row == firstRow + rows - 1 && cells[index + m_stride] != MAZE_DATA_TYPE::BLOCKED )
+                    || ( column == firstColumn && cells[index - 1] != MAZE_DATA_TYPE::BLOCKED )
+                    || ( column == firstColumn + columns - 1 && cells[index + 1] != MAZE_DATA_TYPE::BLOCKED );
+                if ( crossing )
+                {
+                    nodeOfCell[index] = static_cast<uint32_t>( m_hierarchyNodes.size() );
+                    m_hierarchyNodes.push_back( { static_cast<uint32_t>( index ), static_cast<uint32_t>( cluster ), { NO_NODE, NO_NODE }, PATH_UNREACHABLE, false } );
+                }
+            }
+        }
+    }
+    m_clusterFirstNode[clusterCount] = static_cast<uint32_t>( m_hierarchyNodes.size() );
+
+    // link every node to the nodes next to it in other clusters; only a corner cell has two
+    for ( HierarchyNode & node : m_hierarchyNodes )
+    {
+        size_t links = 0; // the number of links made
+        for ( const ptrdiff_t offset : neighbourOffsets )
+        {
+            const size_t neighbourIndex = node.index + offset;
+            if ( nodeOfCell[neighbourIndex] != NO_NODE && m_hierarchyNodes[nodeOfCell[neighbourIndex]].cluster != node.cluster )
+            {
+                node.across[links++] = nodeOfCell[neighbourIndex];
+            }
+        }
+    }
+
+    // pick the entrances: walk each stretch of border between two clusters, one opening (run of passable pairs) at a time
+    const auto markEntrance = [&]( const size_t first, const size_t second )
+    {
+        m_hierarchyNodes[nodeOfCell[first]].entrance = true;
+        m_hierarchyNodes[nodeOfCell[second]].entrance = true;
+    };
+    const auto scanBorder = [&]( const size_t firstIndex, const size_t step, const ptrdiff_t across, const size_t length )
+    {
+        size_t runStart = 0; // the position along the border the current opening starts at
+        for ( size_t position = 0; position <= length; ++position )
+        {
+            const size_t index = firstIndex + position * step;
+            const bool open = position < length && cells[index] != MAZE_DATA_TYPE::BLOCKED && cells[index + across] != MAZE_DATA_TYPE::BLOCKED;
+            if ( open )
+            {
+                continue;
+            }
+            const size_t runLength = position - runStart; // the length of the opening that just ended
+            if ( runLength > 0 && runLength < ENTRANCE_SPLIT_LENGTH )
+            {
+                const size_t middle = firstIndex + ( runStart + runLength / 2 ) * step;
+                markEntrance( middle, middle + across );
+            }
+            else if ( runLength > 0 )
+            {
+                const size_t start = firstIndex + runStart * step;
+                const size_t end = firstIndex + ( position - 1 ) * step;
+                markEntrance( start, start + across );
+                markEntrance( end, end + across );
+            }
+            runStart = position + 1;
+        }
+    };
+    for ( size_t border = m_clusterSize; border < m_columnSize; border += m_clusterSize ) // the borders between columns of clusters
+    {
+        for ( size_t row = 0; row < m_rowSize; row += m_clusterSize )
+        {
+            scanBorder( CellIndex( row, border - 1 ), m_stride, 1, std::min( m_clusterSize, m_rowSize - row ) );
+        }
+    }
+    for ( size_t border = m_clusterSize; border < m_rowSize; border += m_clusterSize ) // the borders between rows of clusters
+    {
+        for ( size_t column = 0; column < m_columnSize; column += m_clusterSize )
+        {
+            scanBorder( CellIndex( border - 1, column ), 1, static_cast<ptrdiff_t>( m_stride ), std::min( m_clusterSize, m_columnSize - column ) );
+        }
+    }
+
+    // lay out a square distance table per cluster, then fill the tables in parallel
+    m_clusterFirstDistance.assign( clusterCount + 1, 0 );
+    for ( size_t cluster = 0; cluster < clusterCount; ++cluster )
+    {
+        const size_t nodeCount = m_clusterFirstNode[cluster + 1] - m_clusterFirstNode[cluster]; // the nodes of the cluster
+        m_clusterFirstDistance[cluster + 1] = m_clusterFirstDistance[cluster] + nodeCount * nodeCount;
+    }
+    m_clusterDistances.assign( m_clusterFirstDistance[clusterCount], NO_CLUSTER_PATH );
+
+    std::atomic<size_t> nextCluster{ 0 }; // the next cluster no worker has claimed
+    pool.Run( [&]( const size_t )
+    {
+        ScratchVector<int> distances; // the distance of every cell of the cluster from the node being searched from
+        ScratchVector<uint32_t> queue; // the breadth first search queue
+        for ( size_t cluster = nextCluster++; cluster < clusterCount; cluster = nextCluster++ )
+        {
+            size_t firstRow, firstColumn, rows, columns;
+            ClusterBounds( cluster, firstRow, firstColumn, rows, columns );
+            const uint32_t firstNode = m_clusterFirstNode[cluster];
+            const uint32_t lastNode = m_clusterFirstNode[cluster + 1]; // one past the last node of the cluster
+            uint16_t * table = m_clusterDistances.data() + m_clusterFirstDistance[cluster]; // the distance table of the cluster
+            for ( uint32_t from = firstNode; from < lastNode; ++from )
+            {
+                m_hierarchyNodes[from].exitDistance = ClusterBFS( cluster, m_hierarchyNodes[from].index, distances, queue );
+                for ( uint32_t to = firstNode; to < lastNode; ++to )
+                {
+                    const size_t index = m_hierarchyNodes[to].index;
+                    const int distance = distances[( index / m_stride - 1 - firstRow ) * columns + ( index % m_stride - 1 - firstColumn )];
+                    table[( from - firstNode ) * ( lastNode - firstNode ) + ( to - firstNode )] = ( distance == PATH_UNREACHABLE ) ? NO_CLUSTER_PATH : static_cast<uint16_t>( distance );
+                }
+            }
+        }
+    } );
+}
+
+/** Checks whether the hierarchy has been built for the loaded maze.
+
+@retval true if the hierarchy is built.
+@retval false if the hierarchy needs to be built with BuildHierarchy.
+*/
+bool Maze::HierarchyBuilt() const
+{
+    return m_clusterSize != 0;
+}
+
+/** Retrieves the minimum number of spaces using the hierarchy built by BuildHierarchy.
+    Only the start's own cluster is searched cell by cell; the rest of the way is searched on the hierarchy nodes.
+    Exact searches use every node and give the same answers as MinimumNumberOfSpacesBFS. Near-optimal searches use
+    only the entrance nodes, so they expand far fewer nodes but may return a slightly longer distance; if they find
+    no exit, the search is redone exactly, so a reachable exit is never missed.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param exact Whether the distance must be the minimum rather than near it.
+
+@return The minimum number of spaces from the start to the closest end point (-1 if no end point could be reached from start, if start was invalid, or if the hierarchy isn't built), with the statistics of the search.
+*/
+SearchResult Maze::MinimumNumberOfSpacesHierarchical( const size_t start_row, const size_t start_column, const bool exact ) const
+{
+    return TimedSearch( start_row, start_column, exact ? SEARCH_ALGORITHM::HIERARCHICAL : SEARCH_ALGORITHM::HIERARCHICAL_APPROXIMATE );
+}
+
+/** Finds the minimum number of spaces to the nearest exit on the hierarchy.
+    The start's cluster is searched breadth first, giving the distance to any exit in it and to each of its nodes.
+    From there A* runs over the nodes, guided by ExitDistanceLowerBound: within a cluster a node reaches the others
+    at their table distance, a link to another cluster costs one space, and a node reaches the nearest exit of its
+    cluster at its exit distance. The first exit off the open list is the nearest.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param exact Whether to use every node rather than just the entrances.
+@param workspace The buffers to search with.
+@param result Receives the number of cells and nodes expanded and the largest the open list grew.
+
+@return The minimum number of spaces from the start to the closest end point, or -1 if no end point could be reached from start, if start was invalid, or if the hierarchy isn't built.
+*/
+int Maze::SearchHierarchical( const size_t start_row, const size_t start_column, const bool exact, SearchWorkspace & workspace, SearchResult & result ) const
+{
+    if ( start_row >= m_rowSize || start_column >= m_columnSize || !HierarchyBuilt() )
+    {
+        return PATH_UNREACHABLE;
+    }
+    const MAZE_DATA_TYPE * cells = Cells(); // the padded grid
+    const size_t startIndex = CellIndex( start_row, start_column ); // the index of the starting position
+    switch ( cells[startIndex] )
+    {
+        case MAZE_DATA_TYPE::BLOCKED: // a blocked start can't travel anywhere
+        {
+            return PATH_UNREACHABLE;
+        } break;
+        case MAZE_DATA_TYPE::EXIT: // the start is already an exit
+        {
+            return 0;
+        } break;
+        default:
+        {
+        } break;
+    }
+
+    using AbstractEntry = SearchWorkspace::AbstractEntry;
+    const auto later = []( const AbstractEntry & first, const AbstractEntry & second ) // orders the heap by estimate, farthest first on ties
+    {
+        return first.estimate > second.estimate || ( first.estimate == second.estimate && first.cost < second.cost );
+    };
+
+    ScratchVector<int> & nodeCosts = workspace.m_nodeCosts;
+    ScratchVector<uint32_t> & nodeStamps = workspace.m_nodeStamps;
+    ScratchVector<AbstractEntry> & heap = workspace.m_abstractHeap; // the nodes still to expand
+    if ( nodeStamps.size() != m_hierarchyNodes.size() )
+    {
+        nodeCosts.resize( m_hierarchyNodes.size() );
+        nodeStamps.assign( m_hierarchyNodes.size(), 0 );
+        workspace.m_nodeStamp = 0;
+    }
+    if ( ++workspace.m_nodeStamp == 0 ) // the stamp wrapped, so forget every stamp handed out before
+    {
+        std::fill( nodeStamps.begin(), nodeStamps.end(), 0 );
+        workspace.m_nodeStamp = 1;
+    }
+    const uint32_t stamp = workspace.m_nodeStamp; // marks the node costs written by this search
+    heap.clear();
+
+    const auto open = [&]( const uint32_t node, const int cost ) // opens a node if this is the shortest way to it yet
+    {
+        if ( nodeStamps[node] == stamp && nodeCosts[node] <= cost )
+        {
+            result.counters.RevisitAvoided();
+            return;
+        }
+        nodeStamps[node] = stamp;
+        nodeCosts[node] = cost;
+        heap.push_back( { node, cost, cost + ExitDistanceLowerBound( m_hierarchyNodes[node].index ) } );
+        std::push_heap( heap.begin(), heap.end(), later );
+        result.counters.Enqueue();
+        result.peakFrontier = std::max( result.peakFrontier, heap.size() );
+    };
+    const auto openExit = [&]( const int cost ) // opens the nearest exit, reached at the given distance
+    {
+        heap.push_back( { NO_NODE, cost, cost } );
+        std::push_heap( heap.begin(), heap.end(), later );
+    };
+
+    // search the start's cluster cell by cell
+    const size_t startCluster = ClusterOf( startIndex ); // the cluster of the start
+    size_t firstRow, firstColumn, rows, columns;
+    ClusterBounds( startCluster, firstRow, firstColumn, rows, columns );
+    const int clusterExit = ClusterBFS( startCluster, startIndex, workspace.m_clusterDistances, workspace.m_clusterQueue ); // the nearest exit without leaving the cluster
+    result.cellsExpanded += rows * columns;
+    if ( clusterExit != PATH_UNREACHABLE )
+    {
+        openExit( clusterExit );
+    }
+    for ( uint32_t node = m_clusterFirstNode[startCluster]; node < m_clusterFirstNode[startCluster + 1]; ++node )
+    {
+        const size_t index = m_hierarchyNodes[node].index;
+        const int distance = workspace.m_clusterDistances[( index / m_stride - 1 - firstRow ) * columns + ( index % m_stride - 1 - firstColumn )];
+        if ( distance != PATH_UNREACHABLE && ( exact || m_hierarchyNodes[node].entrance ) )
+        {
+            open( node, distance );
+        }
+    }
+
+    while ( !heap.empty() )
+    {
+        std::pop_heap( heap.begin(), heap.end(), later );
+        const AbstractEntry current = heap.back(); // the node to expand
+        heap.pop_back();
+        if ( current.node == NO_NODE ) // the first exit off the open list is the nearest
+        {
+            return current.cost;
+        }
+        if ( current.cost > nodeCosts[current.node] ) // reached at a smaller distance after being pushed
+        {
+            continue;
+        }
+        ++result.cellsExpanded;
+
+        const HierarchyNode & node = m_hierarchyNodes[current.node];
+        if ( node.exitDistance != PATH_UNREACHABLE )
+        {
+            openExit( current.cost + node.exitDistance );
+        }
+        for ( const uint32_t across : node.across )
+        {
+            if ( across != NO_NODE && ( exact || m_hierarchyNodes[across].entrance ) )
+            {
+                open( across, current.cost + 1 );
+            }
+        }
+        const uint32_t firstNode = m_clusterFirstNode[node.cluster];
+        const uint32_t nodeCount = m_clusterFirstNode[node.cluster + 1] - firstNode; // the nodes of the cluster
+        const uint16_t * distances = m_clusterDistances.data() + m_clusterFirstDistance[node.cluster] + ( current.node - firstNode ) * nodeCount; // the table row of the node
+        for ( uint32_t other = 0; other < nodeCount; ++other )
+        {
+            if ( distances[other] != NO_CLUSTER_PATH && other + firstNode != current.node && ( exact || m_hierarchyNodes[other + firstNode].entrance ) )
+            {
+                open( other + firstNode, current.cost + distances[other] );
+            }
+        }
+    }
+
+    if ( !exact && !ExitUnreachable( start_row, start_column ) ) // the entrances missed a way out that the full node set will find
+    {
+        return SearchHierarchical( start_row, start_column, true, workspace, result );
+    }
+    return PATH_UNREACHABLE;
+}
+
+/** Discards the hierarchy.
+*/
+void Maze::ClearHierarchy()
+{
+    m_clusterSize = 0;
+    m_clusterColumns = 0;
+    m_hierarchyNodes.clear();
+    m_clusterFirstNode.clear();
+    m_clusterFirstDistance.clear();
+    m_clusterDistances.clear();
+}
+
+/** Finds the cluster a cell belongs to.
+
+@param index The padded index of the cell.
+
+@return The cluster of the cell.
+*/
+size_t Maze::ClusterOf( const size_t index ) const
+{
+    const size_t row = index / m_stride - 1; // the maze row of the cell
+    const size_t column = index % m_stride - 1; // the maze column of the cell
+    return ( row / m_clusterSize ) * m_clusterColumns + column / m_clusterSize;
+}
+
+/** Finds the cells a cluster covers; clusters on the bottom and right edges of the maze may be smaller than the rest.
+
+@param cluster The cluster.
+@param first_row Receives the first maze row of the cluster.
+@param first_column Receives the first maze column of the cluster.
+@param rows Receives the number of rows in the cluster.
+@param columns Receives the number of columns in the cluster.
+*/
+void Maze::ClusterBounds( const size_t cluster, size_t & first_row, size_t & first_column, size_t & rows, size_t & columns ) const
+{
+    first_row = ( cluster / m_clusterColumns ) * m_clusterSize;
+    first_column = ( cluster % m_clusterColumns ) * m_clusterSize;
+    rows = std::min( m_clusterSize, m_rowSize - first_row );
+    columns = std::min( m_clusterSize, m_columnSize - first_column );
+}
+
+/** Runs a breadth first search that never leaves a cluster.
+
+@param cluster The cluster to search.
+@param start_index The padded index of the cell to search from, which must be in the cluster.
+@param distances Receives the distance of every cell of the cluster, row-major within the cluster, or -1 where unreachable.
+@param queue The buffer to queue cells in.
+
+@return The distance to the nearest exit in the cluster, or -1 if there is none reachable.
+*/
+int Maze::ClusterBFS( const size_t cluster, const size_t start_index, ScratchVector<int> & distances, ScratchVector<uint32_t> & queue ) const
+{
+    const MAZE_DATA_TYPE * cells = Cells(); // the padded grid
+    size_t firstRow, firstColumn, rows, columns;
+    ClusterBounds( cluster, firstRow, firstColumn, rows, columns );
+    distances.assign( rows * columns, PATH_UNREACHABLE );
+    queue.resize( rows * columns );
+
+    const size_t startLocal = ( start_index / m_stride - 1 - firstRow ) * columns + ( start_index % m_stride - 1 - firstColumn ); // the start within the cluster
+    distances[startLocal] = 0;
+    queue[0] = static_cast<uint32_t>( startLocal );
+    size_t head = 0; // the position of the next cell to process in the queue
+    size_t tail = 1; // the position to enqueue the next cell in the queue
+    int nearestExit = PATH_UNREACHABLE; // the distance of the first exit dequeued
+
+    while ( head < tail )
+    {
+        const size_t local = queue[head++]; // dequeue the current cell
+        const size_t row = local / columns; // the row within the cluster
+        const size_t column = local - row * columns; // the column within the cluster
+        const size_t index = CellIndex( firstRow + row, firstColumn + column );
+        if ( nearestExit == PATH_UNREACHABLE && cells[index] == MAZE_DATA_TYPE::EXIT )
+        {
+            nearestExit = distances[local];
+        }
+        if ( cells[index] == MAZE_DATA_TYPE::EXIT && index != start_index ) // paths end at an exit, as in the distance field
+        {
+            continue;
+        }
+
+        const int distance = distances[local] + 1; // the distance of the surrounding points
+        const auto visit = [&]( const size_t neighbourLocal, const size_t neighbourIndex )
+        {
+            if ( distances[neighbourLocal] == PATH_UNREACHABLE && cells[neighbourIndex] != MAZE_DATA_TYPE::BLOCKED )
+            {
+                distances[neighbourLocal] = distance;
+                queue[tail++] = static_cast<uint32_t>( neighbourLocal );
+            }
+        };
+        if ( row > 0 )
+        {
+            visit( local - columns, index - m_stride );
+        }
+        if ( row + 1 < rows )
+        {
+            visit( local + columns, index + m_stride );
+        }
+        if ( column > 0 )
+        {
+            visit( local - 1, index - 1 );
+        }
+        if ( column + 1 < columns )
+        {
+            visit( local + 1, index + 1 );
+        }
+    }
+    return nearestExit;
+}
@@ -0,0 +1,383 @@
+// Joseph Miller (c) 2019
+// Per-thread counters of the searches and maze loads, with optional hardware counter sampling through perf_event_open.
+
+#include "Instrumentation.h"
+#include "Maze.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum COUNTER : size_t
+{
+    SEARCHES=0,
+    CELLS_EXPANDED=1,
+    ENQUEUES=2,
+    REVISITS_AVOIDED=3,
+    FRONTIER_HIGH_WATER=4, ///< Combined by taking the largest rather than by adding.
+    SEARCH_NANOSECONDS=5,
+    LOADS=6,
+    LOAD_NANOSECONDS=7,
+    SAMPLED_SEARCHES=8,
+    CYCLES=9,
+    INSTRUCTIONS=10,
+    CACHE_MISSES=11,
+    COUNTER_COUNT=12
+};
+
+static constexpr size_t HARDWARE_EVENTS = 3; ///< The hardware counters in a sampling group: cycles, instructions, and cache misses.
+
+/** The counters of one thread. Only the owning thread writes them, so an update is a relaxed load and store rather
+    than a locked read-modify-write, and Collect may read them from any thread at any time.
+*/
+struct ThreadCounters
+{
+    ThreadCounters();
+    ~ThreadCounters();
+    ThreadCounters( const ThreadCounters & ) = delete;
+    ThreadCounters & operator=( const ThreadCounters & ) = delete;
+
+    void Add( const COUNTER counter, const uint64_t amount );
+    void Raise( const COUNTER counter, const uint64_t value );
+    bool OpenHardwareCounters();
+
+    alignas( 64 ) std::atomic<uint64_t> values[COUNTER_COUNT]; ///< The counts, on cache lines of their own.
+    int hardwareGroup[HARDWARE_EVENTS]{ -1, -1, -1 }; ///< The perf_event_open descriptors, the group leader first, or -1.
+    bool hardwareTried{ false }; ///< Whether opening the hardware counters has been attempted on this thread.
+    uint32_t searchesUntilSample{ 0 }; ///< The searches left before the next hardware counter sample.
+};
+
+/** Every thread's counters, and the totals of the threads that have exited.
+*/
+struct CounterRegistry
+{
+    std::mutex mutex; ///< Guards everything else.
+    std::vector<ThreadCounters *> threads; ///< The counters of every live thread that has counted something.
+    uint64_t retired[COUNTER_COUNT]{}; ///< The counts of the threads that have exited.
+};
+
+static std::atomic<uint32_t> s_samplePeriod{ 0 }; ///< The searches per hardware counter sample on each thread, or 0 when hardware counters are off.
+
+/** Retrieves the registry. It is created on first use, so before the first thread's counters, and so outlives them.
+
+@return the registry.
+*/
+static CounterRegistry & Registry()
+{
+    static CounterRegistry registry;
+    return registry;
+}
+
+/** Retrieves the calling thread's counters, registering them on first use.
+
+@return the counters.
+*/
+static ThreadCounters & LocalCounters()
+{
+    static thread_local ThreadCounters counters;
+    return counters;
+}
+
+/** Whether a counter is combined by taking the largest value rather than by adding.
+
+@param counter The counter.
+
+@return true for the high-water marks.
+*/
+static bool IsHighWater( const size_t counter )
+{
+    return counter == FRONTIER_HIGH_WATER;
+}
+
+/** Registers the counters of a thread.
+*/
+ThreadCounters::ThreadCounters()
+{
+    for ( std::atomic<uint64_t> & value : values )
+    {
+        value.store( 0, std::memory_order_relaxed );
+    }
+    CounterRegistry & registry = Registry();
+    std::lock_guard<std::mutex> lock( registry.mutex );
+    registry.threads.push_back( this );
+}
+
+/** Folds the counters of an exiting thread into the retired totals and closes its hardware counters.
+*/
+ThreadCounters::~ThreadCounters()
+{
+#ifdef __linux__
+    for ( const int descriptor : hardwareGroup )
+    {
+        if ( descriptor >= 0 )
+        {
+            close( descriptor );
+        }
+    }
+#endif
+    CounterRegistry & registry = Registry();
+    std::lock_guard<std::mutex> lock( registry.mutex );
+    for ( size_t counter = 0; counter < COUNTER_COUNT; ++counter )
+    {
+        const uint64_t value = values[counter].load( std::memory_order_relaxed ); // the thread's count
+        registry.retired[counter] = IsHighWater( counter ) ? std::max( registry.retired[counter], value ) : registry.retired[counter] + value;
+    }
+    registry.threads.erase( std::find( registry.threads.begin(), registry.threads.end(), this ) );
+}
+
+/** Adds to a counter of the calling thread, which must own the counters.
+
+@param counter The counter.
+@param amount The amount to add.
+*/
+void ThreadCounters::Add( const COUNTER counter, const uint64_t amount )
+{
+    values[counter].store( values[counter].load( std::memory_order_relaxed ) + amount, std::memory_order_relaxed );
+}
+
+/** Raises a high-water mark of the calling thread, which must own the counters.
+
+@param counter The counter.
+@param value The value to raise the mark to, if it is higher.
+*/
+void ThreadCounters::Raise( const COUNTER counter, const uint64_t value )
+{
+    if ( value > values[counter].load( std::memory_order_relaxed ) )
+    {
+        values[counter].store( value, std::memory_order_relaxed );
+    }
+}
+
+/** Opens a disabled group of hardware counters for the calling thread, once; later calls report the first outcome.
+    The counters only count in user space, so they work under the default perf_event_paranoid setting of 2.
+
+@retval true if the group is open.
+@retval false if hardware counters aren't available, e.g. in a container or on a virtual machine without a PMU.
+*/
+bool ThreadCounters::OpenHardwareCounters()
+{
+    if ( !hardwareTried )
+    {
+        hardwareTried = true;
+#ifdef __linux__
+        const uint64_t events[HARDWARE_EVENTS] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES };
+        for ( size_t event = 0; event < HARDWARE_EVENTS; ++event )
+        {
+            perf_event_attr attributes; // what to count
+            std::memset( &attributes, 0, sizeof( attributes ) );
+            attributes.size = sizeof( attributes );
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.config = events[event];
+            attributes.disabled = event == 0 ? 1 : 0; // the members follow the leader, which starts stopped
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            attributes.read_format = PERF_FORMAT_GROUP;
+            hardwareGroup[event] = static_cast<int>( syscall( SYS_perf_event_open, &attributes, 0, -1, hardwareGroup[0], 0 ) );
+            if ( hardwareGroup[event] < 0 )
+            {
+                for ( int & descriptor : hardwareGroup )
+                {
+                    if ( descriptor >= 0 )
+                    {
+                        close( descriptor );
+                    }
+                    descriptor = -1;
+                }
+                break;
+            }
+        }
+#endif
+    }
+    return hardwareGroup[0] >= 0;
+}
+
+/** Adds up the counters of every thread, live or exited.
+    A live thread's counters are read while it may still be counting, so the totals are a snapshot rather than an
+    instant: each counter is exact, but the counters of one search may be split between two snapshots.
+
+@return the totals.
+*/
+InstrumentationTotals Instrumentation::Collect()
+{
+    uint64_t values[COUNTER_COUNT]; // the totals, by counter
+    CounterRegistry & registry = Registry();
+    {
+        std::lock_guard<std::mutex> lock( registry.mutex );
+        std::copy( registry.retired, registry.retired + COUNTER_COUNT, values );
+        for ( const ThreadCounters * thread : registry.threads )
+        {
+            for ( size_t counter = 0; counter < COUNTER_COUNT; ++counter )
+            {
+                const uint64_t value = thread->values[counter].load( std::memory_order_relaxed ); // the thread's count
+                values[counter] = IsHighWater( counter ) ? std::max( values[counter], value ) : values[counter] + value;
+            }
+        }
+    }
+
+    InstrumentationTotals totals;
+    totals.searches = values[SEARCHES];
+    totals.cellsExpanded = values[CELLS_EXPANDED];
+    totals.enqueues = values[ENQUEUES];
+    totals.revisitsAvoided = values[REVISITS_AVOIDED];
+    totals.frontierHighWater = values[FRONTIER_HIGH_WATER];
+    totals.searchNanoseconds = values[SEARCH_NANOSECONDS];
+    totals.loads = values[LOADS];
+    totals.loadNanoseconds = values[LOAD_NANOSECONDS];
+    totals.sampledSearches = values[SAMPLED_SEARCHES];
+    totals.cycles = values[CYCLES];
+    totals.instructions = values[INSTRUCTIONS];
+    totals.cacheMisses = values[CACHE_MISSES];
+    return totals;
+}
+
+/** Sets every counter back to zero, e.g. between benchmark phases.
+    Counts made by other threads while the reset runs may survive it.
+*/
+void Instrumentation::Reset()
+{
+    CounterRegistry & registry = Registry();
+    std::lock_guard<std::mutex> lock( registry.mutex );
+    std::fill( registry.retired, registry.retired + COUNTER_COUNT, 0 );
+    for ( ThreadCounters * thread : registry.threads )
+    {
+        for ( std::atomic<uint64_t> & value : thread->values )
+        {
+            value.store( 0, std::memory_order_relaxed );
+        }
+    }
+}
+
+/** Starts sampling hardware counters: every samplePeriod-th search on each thread also counts its cycles,
+    instructions, and cache misses. Each sample costs four system calls, which the period spreads over many searches.
+    Does nothing unless the build is instrumented.
+
+@param samplePeriod The searches per sample on each thread; 1 samples every search, and 0 stops sampling.
+
+@retval true if sampling started or stopped as asked.
+@retval false if the build isn't instrumented or the calling thread can't open hardware counters.
+*/
+bool Instrumentation::EnableHardwareCounters( const uint32_t samplePeriod )
+{
+    if ( !INSTRUMENTATION_ENABLED )
+    {
+        return false;
+    }
+    if ( samplePeriod != 0 && !LocalCounters().OpenHardwareCounters() )
+    {
+        return false;
+    }
+    s_samplePeriod.store( samplePeriod, std::memory_order_relaxed );
+    return true;
+}
+
+/** Describes the totals for people, one counter per line.
+
+@return the description, or a note that the build isn't instrumented.
+*/
+std::string Instrumentation::Report()
+{
+    if ( !INSTRUMENTATION_ENABLED )
+    {
+        return "Instrumentation is compiled out; build with \"make INSTRUMENT=1\" to count the searches.\n";
+    }
+    const InstrumentationTotals totals = Collect();
+    std::ostringstream report;
+    report << "Searches: " << totals.searches << " in " << totals.searchNanoseconds / 1000000.0 << " ms\n"
+           << "Cells expanded: " << totals.cellsExpanded << "\n"
+           << "Enqueues: " << totals.enqueues << "\n"
+           << "Revisits avoided: " << totals.revisitsAvoided << "\n"
+           << "Frontier high water: " << totals.frontierHighWater << "\n"
+           << "Loads: " << totals.loads << " in " << totals.loadNanoseconds / 1000000.0 << " ms\n";
+    if ( totals.sampledSearches > 0 )
+    {
+        report << "Sampled searches: " << totals.sampledSearches << "\n"
+               << "Cycles: " << totals.cycles << " (" << totals.cycles / totals.sampledSearches << " per search)\n"
+               << "Instructions: " << totals.instructions << " (" << ( totals.cycles > 0 ? static_cast<double>( totals.instructions ) / totals.cycles : 0.0 ) << " per cycle)\n"
+               << "Cache misses: " << totals.cacheMisses << " (" << totals.cacheMisses / totals.sampledSearches << " per search)\n";
+    }
+    return report.str();
+}
+
+/** Starts counting a search on the calling thread, starting the hardware counters if this search is sampled.
+    Called by SearchProbe.
+
+@retval true if the hardware counters are running for the search.
+@retval false otherwise.
+*/
+bool Instrumentation::BeginSearch()
+{
+    const uint32_t samplePeriod = s_samplePeriod.load( std::memory_order_relaxed ); // the searches per sample
+    if ( samplePeriod == 0 )
+    {
+        return false;
+    }
+    ThreadCounters & counters = LocalCounters();
+    if ( counters.searchesUntilSample > 0 )
+    {
+        --counters.searchesUntilSample;
+        return false;
+    }
+    counters.searchesUntilSample = samplePeriod - 1;
+#ifdef __linux__
+    if ( counters.OpenHardwareCounters() )
+    {
+        ioctl( counters.hardwareGroup[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP );
+        ioctl( counters.hardwareGroup[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP );
+        return true;
+    }
+#endif
+    return false;
+}
+
+/** Records a finished search on the calling thread. Called by SearchProbe.
+
+@param result The search's result and counters.
+@param elapsed How long the search took.
+@param sampled Whether BeginSearch started the hardware counters for the search.
+*/
+void Instrumentation::EndSearch( const SearchResult & result, const std::chrono::nanoseconds elapsed, const bool sampled )
+{
+    ThreadCounters & counters = LocalCounters();
+#ifdef __linux__
+    if ( sampled )
+    {
+        ioctl( counters.hardwareGroup[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP );
+        uint64_t group[1 + HARDWARE_EVENTS]; // the number of counters, then their values in the order they were opened
+        if ( read( counters.hardwareGroup[0], group, sizeof( group ) ) == static_cast<ssize_t>( sizeof( group ) ) )
+        {
+            counters.Add( SAMPLED_SEARCHES, 1 );
+            counters.Add( CYCLES, group[1] );
+            counters.Add( INSTRUCTIONS, group[2] );
+            counters.Add( CACHE_MISSES, group[3] );
+        }
+    }
+#endif
+    counters.Add( SEARCHES, 1 );
+    counters.Add( CELLS_EXPANDED, result.cellsExpanded );
+#ifdef MAZEFINDER_INSTRUMENTATION
+    counters.Add( ENQUEUES, result.counters.enqueues );
+    counters.Add( REVISITS_AVOIDED, result.counters.revisitsAvoided );
+#endif
+    counters.Raise( FRONTIER_HIGH_WATER, result.peakFrontier );
+    counters.Add( SEARCH_NANOSECONDS, static_cast<uint64_t>( elapsed.count() ) );
+}
+
+/** Records a finished maze load on the calling thread. Called by LoadProbe.
+
+@param elapsed How long the load and parse took.
+*/
+void Instrumentation::RecordLoad( const std::chrono::nanoseconds elapsed )
+{
+    ThreadCounters & counters = LocalCounters();
+    counters.Add( LOADS, 1 );
+    counters.Add( LOAD_NANOSECONDS, static_cast<uint64_t>( elapsed.count() ) );
+}
@@ -0,0 +1,152 @@
+// Joseph Miller (c) 2019
+#ifndef __INSTRUMENTATION_H
+#define __INSTRUMENTATION_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef MAZEFINDER_INSTRUMENTATION
+static constexpr bool INSTRUMENTATION_ENABLED = true; ///< Whether the searches count their work, set by building with "make INSTRUMENT=1".
+#else
+static constexpr bool INSTRUMENTATION_ENABLED = false; ///< Whether the searches count their work, set by building with "make INSTRUMENT=1".
+#endif
+
+struct SearchResult;
+
+/** The work one search did beyond what SearchResult always reports, counted only in instrumented builds.
+    Compiled out, the counters are an empty struct and counting is an empty inline call, so the searches compile to
+    exactly the code they would without them.
+*/
+template <bool ENABLED>
+struct SearchCountersOf
+{
+    uint64_t enqueues{ 0 }; ///< The cells, jump points, or hierarchy nodes pushed onto the queue, stack, or open list after the start.
+    uint64_t revisitsAvoided{ 0 }; ///< The neighbours skipped because they had already been reached at least as cheaply.
+
+    void Enqueue() { ++enqueues; }
+    void RevisitAvoided() { ++revisitsAvoided; }
+    void Add( const SearchCountersOf & other ) { enqueues += other.enqueues; revisitsAvoided += other.revisitsAvoided; }
+};
+
+template <>
+struct SearchCountersOf<false>
+{
+    void Enqueue() {}
+    void RevisitAvoided() {}
+    void Add( const SearchCountersOf & ) {}
+};
+
+using SearchCounters = SearchCountersOf<INSTRUMENTATION_ENABLED>; ///< The counters the searches are built with.
+
+/** The work counted across every thread since the program started or the counters were last reset.
+*/
+struct InstrumentationTotals
+{
+    uint64_t searches{ 0 }; ///< The searches run.
+    uint64_t cellsExpanded{ 0 }; ///< The cells the searches expanded, as counted by SearchResult.
+    uint64_t enqueues{ 0 }; ///< The cells the searches pushed onto their queues, stacks, and open lists.
+    uint64_t revisitsAvoided{ 0 }; ///< The neighbours the searches skipped as already reached.
+    uint64_t frontierHighWater{ 0 }; ///< The largest frontier any search held.
+    uint64_t searchNanoseconds{ 0 }; ///< The time spent searching.
+    uint64_t loads{ 0 }; ///< The mazes loaded.
+    uint64_t loadNanoseconds{ 0 }; ///< The time spent loading and parsing mazes.
+    uint64_t sampledSearches{ 0 }; ///< The searches the hardware counters ran for.
+    uint64_t cycles{ 0 }; ///< The CPU cycles of the sampled searches.
+    uint64_t instructions{ 0 }; ///< The instructions retired by the sampled searches.
+    uint64_t cacheMisses{ 0 }; ///< The last level cache misses of the sampled searches.
+};
+
+/** Counters of the searches and maze loads, kept per thread and added up on demand.
+    Each thread counts into its own block of relaxed atomics, written only by that thread, so counting never shares a
+    cache line or takes a lock; Collect reads every live thread's block and adds the blocks of threads that have
+    exited. Hardware counters are optional and sampled: once enabled, every Nth search on each thread is bracketed
+    with a perf_event_open group counting cycles, instructions, and cache misses.
+    Without MAZEFINDER_INSTRUMENTATION the probes are empty and the searches never call into this class.
+*/
+class Instrumentation
+{
+    public:
+        static constexpr uint32_t DEFAULT_SAMPLE_PERIOD = 64; ///< The default number of searches per hardware counter sample.
+
+        static InstrumentationTotals Collect();
+        static void Reset();
+        static bool EnableHardwareCounters( const uint32_t samplePeriod = DEFAULT_SAMPLE_PERIOD );
+        static std::string Report();
+
+        static bool BeginSearch();
+        static void EndSearch( const SearchResult & result, const std::chrono::nanoseconds elapsed, const bool sampled );
+        static void RecordLoad( const std::chrono::nanoseconds elapsed );
+};
+
+/** Times a search and records its counters when it goes out of scope, in instrumented builds only.
+    The result is read when the probe is destroyed, so it must be declared after the result it measures.
+*/
+template <bool ENABLED>
+class SearchProbeOf
+{
+    public:
+        explicit SearchProbeOf( const SearchResult & result )
+            : m_result( result )
+            , m_sampled( Instrumentation::BeginSearch() )
+            , m_start( std::chrono::steady_clock::now() )
+        {
+        }
+
+        ~SearchProbeOf()
+        {
+            Instrumentation::EndSearch( m_result, std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - m_start ), m_sampled );
+        }
+
+        SearchProbeOf( const SearchProbeOf & ) = delete;
+        SearchProbeOf & operator=( const SearchProbeOf & ) = delete;
+
+    private:
+        const SearchResult & m_result; ///< The search being measured.
+        const bool m_sampled; ///< Whether the hardware counters are running for this search.
+        const std::chrono::steady_clock::time_point m_start; ///< When the search started.
+};
+
+template <>
+class SearchProbeOf<false>
+{
+    public:
+        explicit SearchProbeOf( const SearchResult & ) {}
+};
+
+using SearchProbe = SearchProbeOf<INSTRUMENTATION_ENABLED>; ///< The search probe the searches are built with.
+
+/** Times a maze load and parse and records it when it goes out of scope, in instrumented builds only.
+*/
+template <bool ENABLED>
+class LoadProbeOf
+{
+    public:
+        LoadProbeOf()
+            : m_start( std::chrono::steady_clock::now() )
+        {
+        }
+
+        ~LoadProbeOf()
+        {
+            Instrumentation::RecordLoad( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - m_start ) );
+        }
+
+        LoadProbeOf( const LoadProbeOf & ) = delete;
+        LoadProbeOf & operator=( const LoadProbeOf & ) = delete;
+
+    private:
+        const std::chrono::steady_clock::time_point m_start; ///< When the load started.
+};
+
+template <>
+class LoadProbeOf<false>
+{
+    public:
+        LoadProbeOf() {}
+};
+
+using LoadProbe = LoadProbeOf<INSTRUMENTATION_ENABLED>; ///< The load probe the loaders are built with.
+
+#endif // __INSTRUMENTATION_H
@@ -0,0 +1,265 @@
+// Joseph Miller (c) 2019
+// A load generator for the query server: pipelines random queries over several connections and reports throughput and latency.
+
+#include "Socket.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char * const DEFAULT_ADDRESS = "unix:/tmp/mazefinder.sock"; ///< Where the server listens unless told otherwise.
+static constexpr size_t DEFAULT_CONNECTIONS = 4; ///< The default number of connections querying at once.
+static constexpr size_t DEFAULT_QUERIES = 100000; ///< The default number of queries sent across all connections.
+static constexpr size_t DEFAULT_PIPELINE = 64; ///< The default number of queries sent before waiting for their answers.
+static constexpr size_t MAX_PIPELINE = 4096; ///< The deepest pipeline, small enough that a batch and its answers fit in the socket buffers.
+static constexpr uint32_t DEFAULT_SEED = 2019; ///< The default seed for the query coordinates.
+static constexpr size_t RECEIVE_BUFFER_BYTES = static_cast<size_t>( 1 ) << 16; ///< The most answer bytes read at once.
+
+/** What one connection measured.
+*/
+struct ConnectionResults
+{
+    std::vector<double> latencies; ///< The round trip of every batch, in microseconds.
+    size_t answers{ 0 }; ///< The answers received.
+    size_t errors{ 0 }; ///< The answers that were ERROR lines.
+    bool failed{ false }; ///< Whether the connection failed before every batch was answered.
+};
+
+/** Writes the command line options to std err.
+
+@param program The name the load generator was run as.
+*/
+static void PrintUsage( const char * program )
+{
+    std::cerr << "Usage: " << program << " --maze NAME [options]\n"
+              << "  --maze NAME            the served maze to query\n"
+              << "  --address A            unix:PATH or tcp:PORT on 127.0.0.1 (default " << DEFAULT_ADDRESS << ")\n"
+              << "  --algorithm A          bfs,dfs,idfs,bitbfs,field,astar,jps,hpa,hpa_approx,dijkstra (default field)\n"
+              << "  --connections N        connections querying at once (default " << DEFAULT_CONNECTIONS << ")\n"
+              << "  --queries N            queries across all connections (default " << DEFAULT_QUERIES << ")\n"
+              << "  --pipeline N           queries sent before waiting for their answers, at most " << MAX_PIPELINE << " (default " << DEFAULT_PIPELINE << ")\n"
+              << "  --seed N               seed for the query coordinates (default " << DEFAULT_SEED << ")" << std::endl;
+}
+
+/** Sends a request and waits for its single line answer.
+
+@param socket The connection to the server.
+@param request The request, without its newline.
+@param answer Receives the answer, without its newline.
+
+@retval true if an answer arrived.
+@retval false if the connection failed.
+*/
+static bool Ask( const Socket & socket, const std::string & request, std::string & answer )
+{
+    const std::string line = request + '\n';
+    if ( !socket.WriteAll( line.data(), line.size() ) )
+    {
+        return false;
+    }
+    answer.clear();
+    char character = 0; // the answer is short, so it is read a byte at a time to stop right at its end
+    while ( socket.Read( &character, 1 ) == 1 )
+    {
+        if ( character == '\n' )
+        {
+            return true;
+        }
+        answer += character;
+    }
+    return false;
+}
+
+/** Sends batches of random queries on one connection, waiting for each batch's answers before sending the next.
+
+@param address The server address.
+@param prefix The start of every query line: the maze name and algorithm, and a space.
+@param columns The number of columns of the maze.
+@param rows The number of rows of the maze.
+@param queries The number of queries to send.
+@param pipeline The number of queries per batch.
+@param seed The seed for this connection's coordinates.
+@param results Receives what the connection measured.
+*/
+static void RunConnection( const std::string & address, const std::string & prefix, const size_t columns, const size_t rows,
+                           const size_t queries, const size_t pipeline, const uint64_t seed, ConnectionResults & results )
+{
+    Socket socket;
+    if ( !socket.Connect( address ) )
+    {
+        results.failed = true;
+        return;
+    }
+    std::mt19937_64 random( seed );
+    std::uniform_int_distribution<size_t> column( 0, columns - 1 );
+    std::uniform_int_distribution<size_t> row( 0, rows - 1 );
+    std::string batch; // the query lines of a batch
+    std::vector<char> buffer( RECEIVE_BUFFER_BYTES ); // the answers being received
+    results.latencies.reserve( ( queries + pipeline - 1 ) / pipeline );
+    for ( size_t sent = 0; sent < queries; )
+    {
+        const size_t count = std::min( pipeline, queries - sent ); // the queries in this batch
+        batch.clear();
+        for ( size_t query = 0; query < count; ++query )
+        {
+            batch += prefix;
+            batch += std::to_string( column( random ) );
+            batch += ',';
+            batch += std::to_string( row( random ) );
+            batch += '\n';
+        }
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(); // when the batch was sent
+        if ( !socket.WriteAll( batch.data(), batch.size() ) )
+        {
+            results.failed = true;
+            return;
+        }
+        size_t answered = 0; // the answers of the batch received so far
+        bool lineStart = true; // whether the next byte starts an answer
+        while ( answered < count )
+        {
+            const ptrdiff_t bytes = socket.Read( buffer.data(), buffer.size() );
+            if ( bytes <= 0 )
+            {
+                results.failed = true;
+                return;
+            }
+            for ( ptrdiff_t byte = 0; byte < bytes; ++byte )
+            {
+                if ( lineStart && buffer[byte] == 'E' ) // only ERROR answers start with a letter
+                {
+                    ++results.errors;
+                }
+                lineStart = buffer[byte] == '\n';
+                answered += lineStart ? 1 : 0;
+            }
+        }
+        results.latencies.push_back( std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now() - start ).count() );
+        results.answers += answered;
+        sent += count;
+    }
+}
+
+/** Main. Asks the server for the maze size, runs every connection at once, and writes a summary to std out.
+    Latency is the round trip of a whole pipelined batch, from sending its first query to receiving its last answer.
+
+@param argc The number of command line arguments.
+@param argv The command line arguments.
+
+@return EXIT_SUCCESS, or EXIT_FAILURE if the arguments are invalid or any connection failed.
+*/
+int main( int argc, char ** argv )
+{
+    std::string address = DEFAULT_ADDRESS;
+    std::string mazeName;
+    std::string algorithmName = "field";
+    size_t connections = DEFAULT_CONNECTIONS;
+    size_t queries = DEFAULT_QUERIES;
+    size_t pipeline = DEFAULT_PIPELINE;
+    uint64_t seed = DEFAULT_SEED;
+    for ( int argument = 1; argument < argc; ++argument )
+    {
+        const std::string option = argv[argument];
+        if ( argument + 1 >= argc )
+        {
+            PrintUsage( argv[0] );
+            return EXIT_FAILURE;
+        }
+        const std::string value = argv[++argument];
+        if ( option == "--maze" )
+        {
+            mazeName = value;
+        }
+        else if ( option == "--address" )
+        {
+            address = value;
+        }
+        else if ( option == "--algorithm" )
+        {
+            algorithmName = value;
+        }
+        else if ( option == "--connections" )
+        {
+            connections = std::strtoull( value.c_str(), nullptr, 10 );
+        }
+        else if ( option == "--queries" )
+        {
+            queries = std::strtoull( value.c_str(), nullptr, 10 );
+        }
+        else if ( option == "--pipeline" )
+        {
+            pipeline = std::strtoull( value.c_str(), nullptr, 10 );
+        }
+        else if ( option == "--seed" )
+        {
+            seed = std::strtoull( value.c_str(), nullptr, 10 );
+        }
+        else
+        {
+            PrintUsage( argv[0] );
+            return EXIT_FAILURE;
+        }
+    }
+    if ( mazeName.empty() || connections == 0 || pipeline == 0 || pipeline > MAX_PIPELINE )
+    {
+        PrintUsage( argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    Socket socket;
+    std::string size; // the "columns,rows" answer
+    if ( !socket.Connect( address ) || !Ask( socket, "SIZE " + mazeName, size ) )
+    {
+        std::cerr << "Error querying: " << address << std::endl;
+        return EXIT_FAILURE;
+    }
+    socket.Close();
+    const size_t columns = std::strtoull( size.c_str(), nullptr, 10 );
+    const size_t separator = size.find( ',' ); // splits the columns from the rows
+    const size_t rows = separator == std::string::npos ? 0 : std::strtoull( size.c_str() + separator + 1, nullptr, 10 );
+    if ( columns == 0 || rows == 0 )
+    {
+        std::cerr << "The server has no maze " << mazeName << ": " << size << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string prefix = mazeName + ' ' + algorithmName + ' ';
+    std::vector<ConnectionResults> results( connections );
+    std::vector<std::thread> threads;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(); // when the first connection started
+    for ( size_t connection = 0; connection < connections; ++connection )
+    {
+        const size_t share = queries / connections + ( connection < queries % connections ? 1 : 0 ); // this connection's queries
+        threads.emplace_back( RunConnection, std::cref( address ), std::cref( prefix ), columns, rows, share, pipeline, seed + connection, std::ref( results[connection] ) );
+    }
+    for ( std::thread & thread : threads )
+    {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    std::vector<double> latencies; // every batch round trip
+    size_t answers = 0;
+    size_t errors = 0;
+    size_t failures = 0; // the connections that failed
+    for ( const ConnectionResults & result : results )
+    {
+        latencies.insert( latencies.end(), result.latencies.begin(), result.latencies.end() );
+        answers += result.answers;
+        errors += result.errors;
+        failures += result.failed ? 1 : 0;
+    }
+    std::sort( latencies.begin(), latencies.end() );
+    const double p50 = latencies.empty() ? 0.0 : latencies[latencies.size() / 2];
+    const double p99 = latencies.empty() ? 0.0 : latencies[std::min( latencies.size() - 1, latencies.size() * 99 / 100 )];
+    std::cout << "maze,algorithm,connections,pipeline,queries,errors,failed_connections,seconds,queries_per_second,p50_batch_us,p99_batch_us\n"
+              << mazeName << ',' << algorithmName << ',' << connections << ',' << pipeline << ',' << answers << ',' << errors << ','
+              << failures << ',' << seconds << ',' << ( seconds > 0.0 ? answers / seconds : 0.0 ) << ',' << p50 << ',' << p99 << std::endl;
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
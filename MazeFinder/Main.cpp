@@ -1,21 +1,63 @@
 // Joseph Miller (c) 2019
+#include <charconv>
+#include <chrono>
+#include <fstream>
 #include <iostream>
 #include <cstdlib>
+#include <limits>
 #include <string>
 #include <sstream>
+#include <utility>
+#include <vector>
+#include "Instrumentation.h"
 #include "Maze.h"
+#include "QueryCache.h"
+#include "ThreadPool.h"
 
 static constexpr char OPTION_LOAD_FILE = '1'; ///< The option to load a file.
 static constexpr char OPTION_PRINT_MAZE = '2'; ///< The option to print the maze.
 static constexpr char OPTION_EXECUTE_DFS = '3'; ///< The option to execute depth first search.
 static constexpr char OPTION_EXECUTE_BFS = '4'; ///< The option to execute breadth first search.
 static constexpr char OPTION_RELOAD_FILE = '5'; ///< The option to reload the file.
+static constexpr char OPTION_EXECUTE_ITERATIVE_DFS = '6'; ///< The option to execute iterative depth first search.
+static constexpr char OPTION_SAVE_BINARY_FILE = '7'; ///< The option to save the maze as a binary file.
+static constexpr char OPTION_EXECUTE_BIT_PARALLEL_BFS = '8'; ///< The option to execute bit-parallel breadth first search.
+static constexpr char OPTION_EXECUTE_DISTANCE_FIELD = '9'; ///< The option to look up the distance field.
+static constexpr char OPTION_EXECUTE_A_STAR = 'a'; ///< The option to execute A* search.
+static constexpr char OPTION_EXECUTE_JUMP_POINT = 'j'; ///< The option to execute jump point search.
+static constexpr char OPTION_EXECUTE_POINT_TO_POINT = 'p'; ///< The option to execute a bidirectional search between two points.
+static constexpr char OPTION_SET_CELL = 's'; ///< The option to change a cell of the loaded maze.
+static constexpr char OPTION_EXECUTE_HIERARCHICAL = 'h'; ///< The option to execute hierarchical search.
+static constexpr char OPTION_SHOW_ROUTE = 'r'; ///< The option to show the route to the nearest exit.
+static constexpr char OPTION_EXECUTE_DIJKSTRA = 'w'; ///< The option to execute the weighted Dijkstra search.
+static constexpr char OPTION_EXECUTE_PARALLEL_BFS = 'm'; ///< The option to execute multithreaded breadth first search.
+static constexpr char OPTION_SET_NEIGHBOURHOOD = 'n'; ///< The option to choose the moves the searches may make.
+static constexpr char OPTION_EXECUTE_CACHED_BFS = 'c'; ///< The option to execute breadth first search through the query cache.
+static constexpr char OPTION_SET_LAYOUT = 'l'; ///< The option to choose the order of the cells the searches walk.
+static constexpr char OPTION_SHOW_INSTRUMENTATION = 'i'; ///< The option to show the counters of every search so far.
 static constexpr char OPTION_QUIT = 'q'; ///< The option to quit.
 
 static constexpr size_t SINGLE_CHAR_SIZE = 1; ///< Single character size.
 static constexpr size_t FIRST_CHARACTER  = 0; ///< Used to denote the first character in an array.
 static constexpr char NULL_TERMINATOR = 0; ///< Used to denote a null terminator for a char.
-static constexpr int PATH_UNREACHABLE = -1; ///< Used to denote a path as unreachable.
+static constexpr size_t BATCH_BLOCK_QUERIES = 65536; ///< The number of queries batch mode reads, answers, and writes at a time.
+static constexpr size_t MAX_DISTANCE_CHARACTERS = 16; ///< Room for any distance written by batch mode, with its sign and newline.
+
+/** The searches batch mode can run, by the names the benchmark uses.
+*/
+static const std::pair<const char *, Maze::SEARCH_ALGORITHM> BATCH_ALGORITHMS[] =
+{
+    { "bfs", Maze::SEARCH_ALGORITHM::BFS },
+    { "dfs", Maze::SEARCH_ALGORITHM::DFS },
+    { "idfs", Maze::SEARCH_ALGORITHM::ITERATIVE_DFS },
+    { "bitbfs", Maze::SEARCH_ALGORITHM::BIT_PARALLEL_BFS },
+    { "field", Maze::SEARCH_ALGORITHM::DISTANCE_FIELD },
+    { "astar", Maze::SEARCH_ALGORITHM::A_STAR },
+    { "jps", Maze::SEARCH_ALGORITHM::JUMP_POINT },
+    { "hpa", Maze::SEARCH_ALGORITHM::HIERARCHICAL },
+    { "hpa_approx", Maze::SEARCH_ALGORITHM::HIERARCHICAL_APPROXIMATE },
+    { "dijkstra", Maze::SEARCH_ALGORITHM::DIJKSTRA },
+};
 
 /** Displays the main menu.
 
@@ -24,13 +66,29 @@ static constexpr int PATH_UNREACHABLE = -1; ///< Used to denote a path as unreac
 void DisplayMenu(const std::string & filename)
 {
     std::cout << "\n"
-        << OPTION_LOAD_FILE << ". Load file\n";
+        << OPTION_LOAD_FILE << ". Load file\n"
+        << OPTION_SHOW_INSTRUMENTATION << ". Show instrumentation\n";
     if ( !filename.empty() )
     {
         std::cout << OPTION_PRINT_MAZE << ". Print Maze\n"
                   << OPTION_EXECUTE_DFS << ". Execute DFS\n"
                   << OPTION_EXECUTE_BFS << ". Execute BFS\n"
-                  << OPTION_RELOAD_FILE << ". Reload file\n";
+                  << OPTION_RELOAD_FILE << ". Reload file\n"
+                  << OPTION_EXECUTE_ITERATIVE_DFS << ". Execute iterative DFS\n"
+                  << OPTION_SAVE_BINARY_FILE << ". Save binary file\n"
+                  << OPTION_EXECUTE_BIT_PARALLEL_BFS << ". Execute bit-parallel BFS\n"
+                  << OPTION_EXECUTE_DISTANCE_FIELD << ". Execute distance field lookup\n"
+                  << OPTION_EXECUTE_A_STAR << ". Execute A* search\n"
+                  << OPTION_EXECUTE_JUMP_POINT << ". Execute jump point search\n"
+                  << OPTION_EXECUTE_POINT_TO_POINT << ". Execute point to point search\n"
+                  << OPTION_SET_CELL << ". Set cell\n"
+                  << OPTION_EXECUTE_HIERARCHICAL << ". Execute hierarchical search\n"
+                  << OPTION_SHOW_ROUTE << ". Show route\n"
+                  << OPTION_EXECUTE_DIJKSTRA << ". Execute weighted Dijkstra search\n"
+                  << OPTION_EXECUTE_PARALLEL_BFS << ". Execute multithreaded BFS\n"
+                  << OPTION_SET_NEIGHBOURHOOD << ". Set neighbourhood\n"
+                  << OPTION_EXECUTE_CACHED_BFS << ". Execute cached BFS\n"
+                  << OPTION_SET_LAYOUT << ". Set layout\n";
         std::cout << "Currently loaded file: " << filename << "\n";
     }
 
@@ -54,6 +112,21 @@ bool ValidateUserInput( const char input, const bool mazeFileLoaded )
         case OPTION_EXECUTE_DFS: //intentional fallthrough
         case OPTION_EXECUTE_BFS: //intentional fallthrough
         case OPTION_RELOAD_FILE: //intentional fallthrough
+        case OPTION_EXECUTE_ITERATIVE_DFS: //intentional fallthrough
+        case OPTION_SAVE_BINARY_FILE: //intentional fallthrough
+        case OPTION_EXECUTE_BIT_PARALLEL_BFS: //intentional fallthrough
+        case OPTION_EXECUTE_DISTANCE_FIELD: //intentional fallthrough
+        case OPTION_EXECUTE_A_STAR: //intentional fallthrough
+        case OPTION_EXECUTE_JUMP_POINT: //intentional fallthrough
+        case OPTION_EXECUTE_POINT_TO_POINT: //intentional fallthrough
+        case OPTION_SET_CELL: //intentional fallthrough
+        case OPTION_EXECUTE_HIERARCHICAL: //intentional fallthrough
+        case OPTION_SHOW_ROUTE: //intentional fallthrough
+        case OPTION_EXECUTE_DIJKSTRA: //intentional fallthrough
+        case OPTION_EXECUTE_PARALLEL_BFS: //intentional fallthrough
+        case OPTION_SET_NEIGHBOURHOOD: //intentional fallthrough
+        case OPTION_EXECUTE_CACHED_BFS: //intentional fallthrough
+        case OPTION_SET_LAYOUT: //intentional fallthrough
         {
             if ( !mazeFileLoaded )
             {
@@ -61,6 +134,7 @@ bool ValidateUserInput( const char input, const bool mazeFileLoaded )
             }
         }
         case OPTION_LOAD_FILE: //intentional fallthrough
+        case OPTION_SHOW_INSTRUMENTATION: //intentional fallthrough
         case OPTION_QUIT:
         {
             return true;
@@ -84,6 +158,102 @@ std::string GetUserFilename()
     return filename;
 }
 
+/** Gets the binary encoding from the user.
+
+@return the user's chosen encoding for a binary maze file.
+*/
+Maze::BINARY_ENCODING GetUserEncoding()
+{
+    std::string encoding;
+    while ( encoding != "padded" && encoding != "packed" )
+    {
+        std::cout << "Please enter encoding [padded/packed]: ";
+        std::cin >> encoding;
+    }
+    return ( encoding == "packed" ) ? Maze::BINARY_ENCODING::PACKED_2BIT : Maze::BINARY_ENCODING::PADDED_BYTES;
+}
+
+/** Gets the type of a cell from the user.
+    Terrain is entered as its move cost.
+
+@return the user's chosen type for a maze cell.
+*/
+Maze::MAZE_DATA_TYPE GetUserCellType()
+{
+    const char firstTerrain = static_cast<char>( '0' + static_cast<int>( Maze::MAZE_DATA_TYPE::FIRST_TERRAIN ) ); // the cheapest terrain's digit
+    const char lastTerrain = static_cast<char>( '0' + static_cast<int>( Maze::MAZE_DATA_TYPE::LAST_TERRAIN ) ); // the slowest terrain's digit
+    std::string type;
+    while ( type != "clear" && type != "blocked" && type != "exit" &&
+            !( type.size() == SINGLE_CHAR_SIZE && type[FIRST_CHARACTER] >= firstTerrain && type[FIRST_CHARACTER] <= lastTerrain ) )
+    {
+        std::cout << "Please enter cell type [clear/blocked/exit/" << firstTerrain << '-' << lastTerrain << "]: ";
+        std::cin >> type;
+    }
+    if ( type.size() == SINGLE_CHAR_SIZE ) // terrain of the given move cost
+    {
+        return static_cast<Maze::MAZE_DATA_TYPE>( type[FIRST_CHARACTER] - '0' );
+    }
+    if ( type == "blocked" )
+    {
+        return Maze::MAZE_DATA_TYPE::BLOCKED;
+    }
+    return ( type == "exit" ) ? Maze::MAZE_DATA_TYPE::EXIT : Maze::MAZE_DATA_TYPE::CLEAR;
+}
+
+/** Gets the moves the searches may make from the user.
+
+@return the user's chosen neighbourhood.
+*/
+Maze::NEIGHBOURHOOD GetUserNeighbourhood()
+{
+    std::string neighbourhood;
+    while ( neighbourhood != "four" && neighbourhood != "eight" && neighbourhood != "eight_no_corner_cut" )
+    {
+        std::cout << "Please enter neighbourhood [four/eight/eight_no_corner_cut]: ";
+        std::cin >> neighbourhood;
+    }
+    if ( neighbourhood == "eight" )
+    {
+        return Maze::NEIGHBOURHOOD::EIGHT_WAY;
+    }
+    return ( neighbourhood == "four" ) ? Maze::NEIGHBOURHOOD::FOUR_WAY : Maze::NEIGHBOURHOOD::EIGHT_WAY_NO_CORNER_CUTTING;
+}
+
+/** Gets the order of the cells the searches walk from the user.
+
+@return the user's chosen layout.
+*/
+Maze::GRID_LAYOUT GetUserLayout()
+{
+    std::string layout;
+    while ( layout != "row_major" && layout != "tiled" && layout != "morton" )
+    {
+        std::cout << "Please enter layout [row_major/tiled/morton]: ";
+        std::cin >> layout;
+    }
+    if ( layout == "tiled" )
+    {
+        return Maze::GRID_LAYOUT::TILED;
+    }
+    return ( layout == "morton" ) ? Maze::GRID_LAYOUT::MORTON : Maze::GRID_LAYOUT::ROW_MAJOR;
+}
+
+/** Gets whether the user wants exact or near-optimal distances.
+
+@retval true if the user wants exact distances.
+@retval false if the user wants near-optimal distances.
+*/
+bool GetUserExactness()
+{
+    std::string exactness;
+    while ( exactness != "exact" && exactness != "approximate" )
+    {
+        std::cout << "Please enter distances [exact/approximate]: ";
+        std::cin >> exactness;
+    }
+    return exactness == "exact";
+}
+
 /** Get a valid option from the user.
 
 @param filename The filename of the currently loaded file.
@@ -125,10 +295,11 @@ bool LoadFile( Maze& maze, const std::string & filename )
 
 @param maxRow The maximum row index.
 @param maxColumn The maximum column index.
+@param description The coordinate being asked for, such as "starting" or "goal".
 
 @return a pair of starting coordinates in user X,Y order
 */
-std::pair<size_t, size_t> GetStartingCoordinates( const size_t maxRow, const size_t maxColumn )
+std::pair<size_t, size_t> GetStartingCoordinates( const size_t maxRow, const size_t maxColumn, const std::string & description = "starting" )
 {
     std::string userOption;
     int x;
@@ -136,7 +307,7 @@ std::pair<size_t, size_t> GetStartingCoordinates( const size_t maxRow, const siz
     char comma;
     while ( userOption.empty() )
     {
-        std::cout << "Please enter starting coordinate [0-" << maxColumn << ",0-" << maxRow << "] as X,Y: ";
+        std::cout << "Please enter " << description << " coordinate [0-" << maxColumn << ",0-" << maxRow << "] as X,Y: ";
         std::cin >> userOption;
         std::istringstream parseLine( userOption ); // used to parse user option
 
@@ -151,17 +322,287 @@ std::pair<size_t, size_t> GetStartingCoordinates( const size_t maxRow, const siz
     return { x, y };
 }
 
-/** Main. Runs the MazeFinder program.
+/** Reports the outcome of a search.
+
+@param result The result of the search.
+*/
+void ReportSearch( const SearchResult & result )
+{
+    std::cout << "Num Steps: " << result.cellsExpanded << "\n"
+              << "Peak frontier: " << result.peakFrontier << "\n"
+              << "Elapsed: " << std::chrono::duration<double, std::milli>( result.elapsed ).count() << " ms\n";
+#ifdef MAZEFINDER_INSTRUMENTATION
+    std::cout << "Enqueues: " << result.counters.enqueues << "\n"
+              << "Revisits avoided: " << result.counters.revisitsAvoided << "\n";
+#endif
+    if ( result.distance == Maze::PATH_UNREACHABLE )
+    {
+        std::cout << "No solvable minimum path..." << std::endl;
+    }
+    else
+    {
+        std::cout << "Minimum path in " << result.distance << " steps." << std::endl;
+    }
+}
+
+/** Prints the command line options of batch mode.
+
+@param program The name the program was run as.
+*/
+void PrintBatchUsage( const char * program )
+{
+    std::cerr << "Usage: " << program << " --map FILE --algorithm A [options]\n"
+              << "  --map FILE             the text or binary maze to load, kept loaded for the whole run\n"
+              << "  --algorithm A          bfs,dfs,idfs,bitbfs,field,astar,jps,hpa,hpa_approx,dijkstra\n"
+              << "  --queries FILE         X,Y lines to answer (default std in)\n"
+              << "  --threads N            workers answering each block of queries, 0 for one per hardware thread (default 1)\n"
+              << "  --neighbourhood N      four, eight, or eight_no_corner_cut moves (default four)\n"
+              << "  --layout L             row_major, tiled, or morton order of the cells the searches walk (default row_major)\n"
+              << "  --hardware-counters N  in instrumented builds, sample cycles, instructions, and cache misses every N searches per thread (default 0, off)\n"
+              << "Writes one distance per query line to std out, -1 where no exit can be reached or the line is invalid.\n"
+              << "Run without arguments for the interactive menu." << std::endl;
+}
+
+/** Parses a query line of batch mode.
+
+@param line The line, an X,Y coordinate pair; a trailing carriage return is ignored.
+@param start Receives the row and column of the coordinate.
+
+@retval true if the line holds a coordinate pair.
+@retval false if it is malformed.
+*/
+bool ParseQuery( const std::string & line, std::pair<size_t, size_t> & start )
+{
+    const char * end = line.data() + line.size(); // one past the last character of the line
+    if ( end != line.data() && end[-1] == '\r' )
+    {
+        --end;
+    }
+    size_t x = 0;
+    size_t y = 0;
+    const std::from_chars_result column = std::from_chars( line.data(), end, x ); // the X coordinate
+    if ( column.ec != std::errc() || column.ptr == end || *column.ptr != ',' )
+    {
+        return false;
+    }
+    const std::from_chars_result row = std::from_chars( column.ptr + 1, end, y ); // the Y coordinate
+    if ( row.ec != std::errc() || row.ptr != end )
+    {
+        return false;
+    }
+    start = { y, x };
+    return true;
+}
+
+/** Runs batch mode: loads a maze once, then answers a stream of queries without the menu.
+    Queries are read a block of BATCH_BLOCK_QUERIES lines at a time, answered across a thread pool with
+    Maze::MinimumNumberOfSpacesBatch on search buffers kept for the whole run, and written as one buffered block, so
+    output is flushed once per block rather than once per line. Blank lines are skipped. A summary goes to std err when the stream ends, with the search counters in instrumented builds.
+
+@param argc The number of command line arguments.
+@param argv The command line arguments.
+
+@return EXIT_SUCCESS, or EXIT_FAILURE if the options are invalid or the maze or query file can't be loaded.
+*/
+int RunBatch( int argc, char ** argv )
+{
+    std::string mapFilename;
+    std::string queryFilename; // the query file, or empty for std in
+    std::string algorithmName;
+    size_t threads = 1; // the workers answering each block, including this thread
+    Maze::NEIGHBOURHOOD neighbourhood = Maze::NEIGHBOURHOOD::FOUR_WAY; // the moves the searches may make
+    Maze::GRID_LAYOUT layout = Maze::GRID_LAYOUT::ROW_MAJOR; // the order of the cells the searches walk
+    uint32_t samplePeriod = 0; // the searches per hardware counter sample, or 0 for none
+    for ( int argument = 1; argument < argc; ++argument )
+    {
+        const std::string option = argv[argument];
+        if ( argument + 1 >= argc )
+        {
+            PrintBatchUsage( argv[0] );
+            return EXIT_FAILURE;
+        }
+        const std::string value = argv[++argument];
+        if ( option == "--map" )
+        {
+            mapFilename = value;
+        }
+        else if ( option == "--algorithm" )
+        {
+            algorithmName = value;
+        }
+        else if ( option == "--queries" )
+        {
+            queryFilename = value;
+        }
+        else if ( option == "--threads" )
+        {
+            threads = std::strtoull( value.c_str(), nullptr, 10 );
+        }
+        else if ( option == "--neighbourhood" && value == "four" )
+        {
+            neighbourhood = Maze::NEIGHBOURHOOD::FOUR_WAY;
+        }
+        else if ( option == "--neighbourhood" && value == "eight" )
+        {
+            neighbourhood = Maze::NEIGHBOURHOOD::EIGHT_WAY;
+        }
+        else if ( option == "--neighbourhood" && value == "eight_no_corner_cut" )
+        {
+            neighbourhood = Maze::NEIGHBOURHOOD::EIGHT_WAY_NO_CORNER_CUTTING;
+        }
+        else if ( option == "--layout" && value == "row_major" )
+        {
+            layout = Maze::GRID_LAYOUT::ROW_MAJOR;
+        }
+        else if ( option == "--layout" && value == "tiled" )
+        {
+            layout = Maze::GRID_LAYOUT::TILED;
+        }
+        else if ( option == "--layout" && value == "morton" )
+        {
+            layout = Maze::GRID_LAYOUT::MORTON;
+        }
+        else if ( option == "--hardware-counters" )
+        {
+            samplePeriod = static_cast<uint32_t>( std::strtoul( value.c_str(), nullptr, 10 ) );
+        }
+        else
+        {
+            PrintBatchUsage( argv[0] );
+            return EXIT_FAILURE;
+        }
+    }
+
+    const std::pair<const char *, Maze::SEARCH_ALGORITHM> * algorithm = nullptr; // the search chosen
+    for ( const std::pair<const char *, Maze::SEARCH_ALGORITHM> & candidate : BATCH_ALGORITHMS )
+    {
+        if ( algorithmName == candidate.first )
+        {
+            algorithm = &candidate;
+        }
+    }
+    if ( mapFilename.empty() || algorithm == nullptr )
+    {
+        PrintBatchUsage( argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    if ( samplePeriod != 0 && !Instrumentation::EnableHardwareCounters( samplePeriod ) )
+    {
+        std::cerr << "Hardware counters are unavailable; counting without them" << std::endl;
+    }
+    Maze maze;
+    if ( !maze.LoadMaze( mapFilename ) )
+    {
+        std::cerr << "Error loading file: " << mapFilename << std::endl;
+        return EXIT_FAILURE;
+    }
+    maze.SetNeighbourhood( neighbourhood );
+    if ( !maze.SetGridLayout( layout ) )
+    {
+        std::cerr << "The copy of the maze in the chosen layout exceeds the memory limit; searching the rows" << std::endl;
+    }
+    ThreadPool pool( threads );
+    switch ( algorithm->second )
+    {
+        case Maze::SEARCH_ALGORITHM::DISTANCE_FIELD:
+        {
+            maze.BuildDistanceField();
+        } break;
+        case Maze::SEARCH_ALGORITHM::HIERARCHICAL: //intentional fallthrough
+        case Maze::SEARCH_ALGORITHM::HIERARCHICAL_APPROXIMATE:
+        {
+            maze.BuildHierarchy( pool );
+        } break;
+        default:
+        {
+        } break;
+    }
+
+    std::ifstream queryFile;
+    std::istream * input = &std::cin; // where the queries come from
+    if ( !queryFilename.empty() )
+    {
+        queryFile.open( queryFilename );
+        if ( !queryFile )
+        {
+            std::cerr << "Error opening file: " << queryFilename << std::endl;
+            return EXIT_FAILURE;
+        }
+        input = &queryFile;
+    }
+    std::ios::sync_with_stdio( false ); // the streams are only used through C++, so they needn't stay in step with C stdio
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(); // when the first query was read
+    std::vector<std::pair<size_t, size_t>> starts; // the block of queries being answered, as rows and columns
+    starts.reserve( BATCH_BLOCK_QUERIES );
+    std::vector<SearchWorkspace> workspaces( pool.GetThreadCount() ); // the search buffers of each worker, kept across blocks
+    std::string line;
+    std::string output; // the distances of the block, written at once
+    size_t queries = 0; // the queries answered so far
+    size_t malformed = 0; // the query lines that weren't coordinate pairs
+    bool more = true; // whether the input may hold more lines
+    while ( more )
+    {
+        starts.clear();
+        while ( starts.size() < BATCH_BLOCK_QUERIES && ( more = static_cast<bool>( std::getline( *input, line ) ) ) )
+        {
+            if ( line.empty() || line == "\r" )
+            {
+                continue;
+            }
+            std::pair<size_t, size_t> query; // the row and column of the line
+            if ( !ParseQuery( line, query ) ) // answered as an invalid start, so every line still gets its answer
+            {
+                ++malformed;
+                query = { std::numeric_limits<size_t>::max(), std::numeric_limits<size_t>::max() };
+            }
+            starts.push_back( query );
+        }
+        if ( starts.empty() )
+        {
+            continue;
+        }
+
+        const std::vector<int> distances = maze.MinimumNumberOfSpacesBatch( starts, algorithm->second, pool, workspaces );
+        output.resize( distances.size() * MAX_DISTANCE_CHARACTERS );
+        char * next = &output[0]; // where the next distance is written
+        for ( const int distance : distances )
+        {
+            next = std::to_chars( next, next + MAX_DISTANCE_CHARACTERS - 1, distance ).ptr;
+            *next++ = '\n';
+        }
+        std::cout.write( output.data(), next - output.data() );
+        queries += distances.size();
+    }
+    std::cout.flush();
+
+    const double milliseconds = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count(); // how long the queries took
+    std::cerr << "Answered " << queries << " queries (" << malformed << " malformed) with " << algorithm->first << " in " << milliseconds << " ms" << std::endl;
+    if ( INSTRUMENTATION_ENABLED )
+    {
+        std::cerr << Instrumentation::Report();
+    }
+    return EXIT_SUCCESS;
+}
+
+/** Main. Runs the MazeFinder program: the interactive menu, or batch mode when given command line arguments.
 
-@param argc Unused.
-@param argv Unused.
+@param argc The number of command line arguments.
+@param argv The command line arguments, read by RunBatch.
 
-@return EXIT_SUCCESS.
+@return EXIT_SUCCESS, or what batch mode returns.
 */
 int main( int argc, char ** argv )
 {
+    if ( argc > 1 )
+    {
+        return RunBatch( argc, argv );
+    }
+
     std::string filename;
     Maze maze;
+    QueryCache cache; // answers repeated cached BFS queries without searching
     char choice = GetUserOption( filename );
 
     while ( choice != OPTION_QUIT )
@@ -178,6 +619,10 @@ int main( int argc, char ** argv )
                     filename.clear();
                 }
             } break;
+            case OPTION_SHOW_INSTRUMENTATION:
+            {
+                std::cout << Instrumentation::Report();
+            } break;
             case OPTION_PRINT_MAZE:
             {
                 std::cout << "Printing maze..." << std::endl;
@@ -187,28 +632,130 @@ int main( int argc, char ** argv )
             {
                 std::cout << "Executing Depth First Search..." << std::endl;
                 const std::pair<size_t, size_t> coordinates = GetStartingCoordinates( maze.GetRowSize() - 1, maze.GetColumnSize() - 1 );
-                const int minimumNumSteps = maze.MinimumNumberOfSpacesDFS( coordinates.second, coordinates.first );
-                if ( minimumNumSteps == PATH_UNREACHABLE )
+                ReportSearch( maze.MinimumNumberOfSpacesDFS( coordinates.second, coordinates.first ) );
+            } break;
+            case OPTION_EXECUTE_BFS:
+            {
+                std::cout << "Executing Breadth First Search..." << std::endl;
+                const std::pair<size_t, size_t> coordinates = GetStartingCoordinates( maze.GetRowSize() - 1, maze.GetColumnSize() - 1 );
+                ReportSearch( maze.MinimumNumberOfSpacesBFS( coordinates.second, coordinates.first ) );
+            } break;
+            case OPTION_EXECUTE_ITERATIVE_DFS:
+            {
+                std::cout << "Executing Iterative Depth First Search..." << std::endl;
+                const std::pair<size_t, size_t> coordinates = GetStartingCoordinates( maze.GetRowSize() - 1, maze.GetColumnSize() - 1 );
+                ReportSearch( maze.MinimumNumberOfSpacesIterativeDFS( coordinates.second, coordinates.first ) );
+            } break;
+            case OPTION_SAVE_BINARY_FILE:
+            {
+                std::cout << "Saving binary file..." << std::endl;
+                const std::string binaryFilename = GetUserFilename();
+                if ( !maze.SaveBinaryMaze( binaryFilename, GetUserEncoding() ) )
                 {
-                    std::cout << "No solvable minimum path..." << std::endl;
+                    std::cout << "Error saving file: " << binaryFilename << std::endl;
                 }
-                else
+            } break;
+            case OPTION_EXECUTE_BIT_PARALLEL_BFS:
+            {
+                std::cout << "Executing Bit-Parallel Breadth First Search..." << std::endl;
+                const std::pair<size_t, size_t> coordinates = GetStartingCoordinates( maze.GetRowSize() - 1, maze.GetColumnSize() - 1 );
+                ReportSearch( maze.MinimumNumberOfSpacesBitParallelBFS( coordinates.second, coordinates.first ) );
+            } break;
+            case OPTION_EXECUTE_DISTANCE_FIELD:
+            {
+                if ( !maze.DistanceFieldBuilt() )
                 {
-                    std::cout << "Minimum path in " << minimumNumSteps << " steps." << std::endl;
+                    std::cout << "Building distance field..." << std::endl;
+                    maze.BuildDistanceField();
                 }
+                std::cout << "Executing Distance Field Lookup..." << std::endl;
+                const std::pair<size_t, size_t> coordinates = GetStartingCoordinates( maze.GetRowSize() - 1, maze.GetColumnSize() - 1 );
+                ReportSearch( maze.MinimumNumberOfSpacesDistanceField( coordinates.second, coordinates.first ) );
             } break;
-            case OPTION_EXECUTE_BFS:
+            case OPTION_EXECUTE_A_STAR:
             {
-                std::cout << "Executing Breadth First Search..." << std::endl;
+                std::cout << "Executing A* Search..." << std::endl;
+                const std::pair<size_t, size_t> coordinates = GetStartingCoordinates( maze.GetRowSize() - 1, maze.GetColumnSize() - 1 );
+                ReportSearch( maze.MinimumNumberOfSpacesAStar( coordinates.second, coordinates.first ) );
+            } break;
+            case OPTION_EXECUTE_JUMP_POINT:
+            {
+                std::cout << "Executing Jump Point Search..." << std::endl;
                 const std::pair<size_t, size_t> coordinates = GetStartingCoordinates( maze.GetRowSize() - 1, maze.GetColumnSize() - 1 );
-                const int minimumNumSteps = maze.MinimumNumberOfSpacesBFS( coordinates.second, coordinates.first );
-                if ( minimumNumSteps == PATH_UNREACHABLE )
+                ReportSearch( maze.MinimumNumberOfSpacesJumpPoint( coordinates.second, coordinates.first ) );
+            } break;
+            case OPTION_EXECUTE_POINT_TO_POINT:
+            {
+                std::cout << "Executing Point to Point Search..." << std::endl;
+                const std::pair<size_t, size_t> start = GetStartingCoordinates( maze.GetRowSize() - 1, maze.GetColumnSize() - 1 );
+                const std::pair<size_t, size_t> goal = GetStartingCoordinates( maze.GetRowSize() - 1, maze.GetColumnSize() - 1, "goal" );
+                ReportSearch( maze.MinimumNumberOfSpacesBetween( start.second, start.first, goal.second, goal.first ) );
+            } break;
+            case OPTION_EXECUTE_HIERARCHICAL:
+            {
+                if ( !maze.HierarchyBuilt() )
                 {
-                    std::cout << "No solvable minimum path..." << std::endl;
+                    std::cout << "Building hierarchy..." << std::endl;
+                    ThreadPool pool;
+                    maze.BuildHierarchy( pool );
                 }
-                else
+                std::cout << "Executing Hierarchical Search..." << std::endl;
+                const bool exact = GetUserExactness();
+                const std::pair<size_t, size_t> coordinates = GetStartingCoordinates( maze.GetRowSize() - 1, maze.GetColumnSize() - 1 );
+                ReportSearch( maze.MinimumNumberOfSpacesHierarchical( coordinates.second, coordinates.first, exact ) );
+            } break;
+            case OPTION_SHOW_ROUTE:
+            {
+                std::cout << "Finding route with Breadth First Search..." << std::endl;
+                const std::pair<size_t, size_t> coordinates = GetStartingCoordinates( maze.GetRowSize() - 1, maze.GetColumnSize() - 1 );
+                std::vector<std::pair<size_t, size_t>> path; // the route, as rows and columns
+                ReportSearch( maze.MinimumPath( coordinates.second, coordinates.first, Maze::SEARCH_ALGORITHM::BFS, path ) );
+                if ( !path.empty() )
+                {
+                    std::cout << "Moves: " << Maze::EncodePath( path ) << std::endl;
+                    maze.PrintMaze( path );
+                }
+            } break;
+            case OPTION_EXECUTE_DIJKSTRA:
+            {
+                std::cout << "Executing Weighted Dijkstra Search..." << std::endl;
+                const std::pair<size_t, size_t> coordinates = GetStartingCoordinates( maze.GetRowSize() - 1, maze.GetColumnSize() - 1 );
+                ReportSearch( maze.MinimumMoveCostDijkstra( coordinates.second, coordinates.first ) );
+            } break;
+            case OPTION_EXECUTE_PARALLEL_BFS:
+            {
+                std::cout << "Executing Multithreaded Breadth First Search..." << std::endl;
+                const std::pair<size_t, size_t> coordinates = GetStartingCoordinates( maze.GetRowSize() - 1, maze.GetColumnSize() - 1 );
+                ThreadPool pool;
+                ReportSearch( maze.MinimumNumberOfSpacesParallelBFS( coordinates.second, coordinates.first, pool ) );
+            } break;
+            case OPTION_SET_NEIGHBOURHOOD:
+            {
+                std::cout << "Setting neighbourhood..." << std::endl;
+                maze.SetNeighbourhood( GetUserNeighbourhood() );
+            } break;
+            case OPTION_SET_LAYOUT:
+            {
+                std::cout << "Setting layout..." << std::endl;
+                if ( !maze.SetGridLayout( GetUserLayout() ) )
+                {
+                    std::cout << "Error setting layout: the copy of the maze exceeds the memory limit" << std::endl;
+                }
+            } break;
+            case OPTION_EXECUTE_CACHED_BFS:
+            {
+                std::cout << "Executing Cached Breadth First Search..." << std::endl;
+                const std::pair<size_t, size_t> coordinates = GetStartingCoordinates( maze.GetRowSize() - 1, maze.GetColumnSize() - 1 );
+                ReportSearch( cache.Query( maze, coordinates.second, coordinates.first, Maze::SEARCH_ALGORITHM::BFS ) );
+                std::cout << "Cache hits: " << cache.GetHits() << ", misses: " << cache.GetMisses() << std::endl;
+            } break;
+            case OPTION_SET_CELL:
+            {
+                std::cout << "Setting cell..." << std::endl;
+                const std::pair<size_t, size_t> coordinates = GetStartingCoordinates( maze.GetRowSize() - 1, maze.GetColumnSize() - 1, "cell" );
+                if ( !maze.SetCell( coordinates.second, coordinates.first, GetUserCellType() ) )
                 {
-                    std::cout << "Minimum path in " << minimumNumSteps << " steps." << std::endl;
+                    std::cout << "Error setting cell" << std::endl;
                 }
             } break;
             case OPTION_RELOAD_FILE:
@@ -0,0 +1,155 @@
+// Joseph Miller (c) 2019
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/** Unmaps the file if it is still open.
+*/
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+/** Maps a file read-only into memory.
+    An empty file opens successfully with no data.
+
+@param filename The path to the file to map.
+
+@retval true if the file was successfully mapped.
+@retval false if the file could not be opened or mapped.
+*/
+bool MappedFile::Open( const std::string & filename )
+{
+    Close(); // release any previously mapped file
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA( filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+    if ( file == INVALID_HANDLE_VALUE )
+    {
+        return false;
+    }
+    LARGE_INTEGER fileSize; // holds the size of the file in bytes
+    if ( !GetFileSizeEx( file, &fileSize ) )
+    {
+        CloseHandle( file );
+        return false;
+    }
+    m_fileHandle = file;
+    m_size = static_cast<size_t>( fileSize.QuadPart );
+    if ( m_size > 0 ) // a zero length file can't be mapped, but is still a valid open file
+    {
+        m_mappingHandle = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+        if ( m_mappingHandle == nullptr )
+        {
+            m_open = true;
+            Close();
+            return false;
+        }
+        m_data = static_cast<const char *>( MapViewOfFile( m_mappingHandle, FILE_MAP_READ, 0, 0, 0 ) );
+        if ( m_data == nullptr )
+        {
+            m_open = true;
+            Close();
+            return false;
+        }
+    }
+#else
+    const int file = open( filename.c_str(), O_RDONLY ); // the descriptor is only needed until the file is mapped
+    if ( file < 0 )
+    {
+        return false;
+    }
+    struct stat fileStatus; // holds the size of the file in bytes
+    if ( fstat( file, &fileStatus ) != 0 || !S_ISREG( fileStatus.st_mode ) )
+    {
+        close( file );
+        return false;
+    }
+    m_size = static_cast<size_t>( fileStatus.st_size );
+    if ( m_size > 0 ) // a zero length file can't be mapped, but is still a valid open file
+    {
+        void * mapping = mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0 );
+        if ( mapping == MAP_FAILED )
+        {
+            close( file );
+            m_size = 0;
+            return false;
+        }
+        madvise( mapping, m_size, MADV_SEQUENTIAL ); // the file is parsed front to back in one pass
+        m_data = static_cast<const char *>( mapping );
+    }
+    close( file );
+#endif
+
+    m_open = true;
+    return true;
+}
+
+/** Unmaps the file and releases its handles.
+*/
+void MappedFile::Close()
+{
+    if ( !m_open )
+    {
+        return;
+    }
+#ifdef _WIN32
+    if ( m_data != nullptr )
+    {
+        UnmapViewOfFile( m_data );
+    }
+    if ( m_mappingHandle != nullptr )
+    {
+        CloseHandle( m_mappingHandle );
+    }
+    CloseHandle( m_fileHandle );
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+#else
+    if ( m_data != nullptr )
+    {
+        munmap( const_cast<char *>( m_data ), m_size );
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+/** Checks whether a file is currently mapped.
+
+@retval true if a file is open.
+@retval false if no file is open.
+*/
+bool MappedFile::IsOpen() const
+{
+    return m_open;
+}
+
+/** Retrieves the mapped file contents.
+
+@return A pointer to the first byte of the file, or nullptr if the file is empty or not open.
+*/
+const char * MappedFile::Data() const
+{
+    return m_data;
+}
+
+/** Retrieves the size of the mapped file.
+
+@return The number of bytes in the file.
+*/
+size_t MappedFile::Size() const
+{
+    return m_size;
+}
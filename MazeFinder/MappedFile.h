@@ -0,0 +1,30 @@
+// Joseph Miller (c) 2019
+#ifndef __MAPPED_FILE_H
+#define __MAPPED_FILE_H
+
+#include <string>
+
+class MappedFile
+{
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+        MappedFile( const MappedFile & ) = delete;
+        MappedFile & operator=( const MappedFile & ) = delete;
+        bool Open( const std::string & filename );
+        void Close();
+        bool IsOpen() const;
+        const char * Data() const;
+        size_t Size() const;
+
+    private:
+        const char * m_data{ nullptr }; ///< The start of the mapped file contents.
+        size_t m_size{ 0 }; ///< The number of bytes mapped.
+        bool m_open{ false }; ///< Whether a file is currently open.
+#ifdef _WIN32
+        void * m_fileHandle{ nullptr }; ///< The Win32 handle of the open file.
+        void * m_mappingHandle{ nullptr }; ///< The Win32 handle of the file mapping object.
+#endif
+};
+
+#endif // __MAPPED_FILE_H
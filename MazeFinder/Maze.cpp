@@ -1,18 +1,160 @@
 // Joseph Miller (c) 2019
 
 #include "Maze.h"
-#include <fstream>
-#include <sstream>
+#include "GridLayout.h"
+#include "MappedFile.h"
+#include "Neighbourhood.h"
+#include "ThreadPool.h"
 #include <iostream>
+#include <fstream>
 #include <algorithm>
-#include <queue>
-#include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+static constexpr size_t MAX_RECURSIVE_ROWS = 256; ///< Mazes with more rows use the iterative depth first search so as not to likely run out of stack space.
+static constexpr size_t MAX_RECURSIVE_COLUMNS = 256; ///< Mazes with more columns use the iterative depth first search so as not to likely run out of stack space.
+static std::atomic<uint64_t> s_lastGeneration{ 0 }; ///< The last generation handed to any maze, so no two maze states share one.
+static constexpr char BINARY_MAGIC[4] = { 'M', 'A', 'Z', 'B' }; ///< Identifies a binary maze file.
+static constexpr uint16_t BINARY_VERSION = 1; ///< The binary maze format version written and understood.
+static constexpr size_t CELLS_PER_PACKED_BYTE = 4; ///< The number of 2-bit cells in a byte of PACKED_2BIT payload.
+static constexpr size_t BATCH_CHUNK_SIZE = 64; ///< The number of batch queries a worker claims at a time, large enough that workers rarely contend on the counter or share result cache lines.
+static constexpr size_t MAX_HEURISTIC_EXITS = 64; ///< Mazes with more exits don't estimate the distance to the nearest exit, since it would cost more than it saves.
+static constexpr uint32_t NO_COMPONENT = std::numeric_limits<uint32_t>::max(); ///< The component label of a blocked cell.
+
+/** Checks whether a character is whitespace the way stream extraction treats it.
+
+@param value The character to check.
+
+@retval true if the character is whitespace.
+@retval false if the character is not whitespace.
+*/
+static bool IsWhitespace( const char value )
+{
+    return value == ' ' || value == '\t' || value == '\n' || value == '\v' || value == '\f' || value == '\r';
+}
+
+/** Retrieves the next line from a buffer, the way std::getline does.
+
+@param cursor The current read position, advanced past the line and its newline.
+@param end The end of the buffer.
+@param lineBegin Set to the first character of the line.
+@param lineEnd Set to one past the last character of the line, excluding the newline.
+
+@retval true if a line was retrieved.
+@retval false if the buffer has no more data.
+*/
+static bool ReadLine( const char *& cursor, const char * end, const char *& lineBegin, const char *& lineEnd )
+{
+    if ( cursor == end ) // nothing left, so there is no line to get
+    {
+        return false;
+    }
+    lineBegin = cursor;
+    const char * newline = static_cast<const char *>( std::memchr( cursor, '\n', end - cursor ) ); // find the end of the line
+    lineEnd = ( newline != nullptr ) ? newline : end;
+    cursor = ( newline != nullptr ) ? newline + 1 : end;
+    return true;
+}
+
+/** Skips whitespace and retrieves the next character in a line, the way stream extraction of a char does.
+
+@param cursor The current read position, advanced past the character.
+@param end The end of the line.
+@param value Set to the character retrieved.
+
+@retval true if a character was retrieved.
+@retval false if the line has no more characters.
+*/
+static bool ReadCharacter( const char *& cursor, const char * end, char & value )
+{
+    while ( cursor != end && IsWhitespace( *cursor ) )
+    {
+        ++cursor;
+    }
+    if ( cursor == end )
+    {
+        return false;
+    }
+    value = *cursor++;
+    return true;
+}
+
+/** Skips whitespace and retrieves the next unsigned number in a line, the way stream extraction of a size_t does.
+
+@param cursor The current read position, advanced past the number.
+@param end The end of the line.
+@param value Set to the number retrieved.
+
+@retval true if a number was retrieved.
+@retval false if the line has no number or the number does not fit in a size_t.
+*/
+static bool ReadUnsigned( const char *& cursor, const char * end, size_t & value )
+{
+    while ( cursor != end && IsWhitespace( *cursor ) )
+    {
+        ++cursor;
+    }
+    if ( cursor != end && *cursor == '+' )
+    {
+        ++cursor;
+    }
+    const char * digitsBegin = cursor; // used to make sure there is at least one digit
+    value = 0;
+    while ( cursor != end && *cursor >= '0' && *cursor <= '9' )
+    {
+        const size_t digit = static_cast<size_t>( *cursor - '0' );
+        if ( value > ( std::numeric_limits<size_t>::max() - digit ) / 10 ) // the number would overflow
+        {
+            return false;
+        }
+        value = value * 10 + digit;
+        ++cursor;
+    }
+    return cursor != digitsBegin;
+}
 
-static constexpr size_t MAX_ROWS = 256; ///< Used to limit the number of rows so as not to likely run out of stack space for depth first search.
-static constexpr size_t MAX_COLUMNS = 256; ///< Used to limit the number of columns so as not to likely run out of stack space for depth first search.
-static constexpr int PATH_UNREACHABLE = -1; ///< Used to denote a path as unreachable
+/** The fixed size header at the start of a binary maze file, stored in native (little-endian) byte order.
+    The payload follows the header directly.
+*/
+struct BinaryMazeHeader
+{
+    char magic[4]; ///< Always BINARY_MAGIC.
+    uint16_t version; ///< Always BINARY_VERSION.
+    uint8_t encoding; ///< The Maze::BINARY_ENCODING of the payload.
+    uint8_t reserved; ///< Unused, written as 0.
+    uint32_t checksum; ///< FNV-1a hash of the payload.
+    uint32_t reservedPadding; ///< Unused, written as 0.
+    uint64_t columns; ///< The number of maze columns, excluding the border.
+    uint64_t rows; ///< The number of maze rows, excluding the border.
+};
+static_assert( sizeof( BinaryMazeHeader ) == 32, "The binary maze header must not contain compiler padding." );
+
+/** Computes the 32-bit FNV-1a hash of a block of data.
+
+@param data The data to hash.
+@param size The number of bytes to hash.
+
+@return The hash of the data.
+*/
+static uint32_t Checksum( const char * data, const size_t size )
+{
+    uint32_t hash = 2166136261u; // FNV offset basis
+    for ( size_t byte = 0; byte < size; ++byte )
+    {
+        hash ^= static_cast<uint8_t>( data[byte] );
+        hash *= 16777619u; // FNV prime
+    }
+    return hash;
+}
 
 /** Loads the maze into memory via filename.
+    The file is memory-mapped. Text mazes are parsed straight into the grid in a single pass, and
+    binary mazes (see SaveBinaryMaze) are recognised by their header and loaded without parsing.
 
 @param filename The path to the maze to load.
 
@@ -21,35 +163,221 @@ static constexpr int PATH_UNREACHABLE = -1; ///< Used to denote a path as unreac
 */
 bool Maze::LoadMaze( const std::string & filename )
 {
+    const LoadProbe probe; // times the load in instrumented builds
+    ClearMaze(); // clear the maze if there is existing maze data
+
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(); // holds the file to get map data from
+
+    if ( !file->Open( filename ) ) // check that the file could be sucessfully accessed
+    {
+        return false;
+    }
+
+    if ( file->Size() >= sizeof( BINARY_MAGIC ) && std::memcmp( file->Data(), BINARY_MAGIC, sizeof( BINARY_MAGIC ) ) == 0 ) // binary maze files start with the magic
+    {
+        return LoadBinaryMaze( file );
+    }
+
+    return ParseMaze( file->Data(), file->Size() );
+}
+
+/** Loads the maze from text in the map file format, as if it had been read from a file.
+
+@param text The text of the maze.
+
+@retval true if the maze was successfully loaded.
+@retval false if the maze was not successfully loaded.
+*/
+bool Maze::LoadMazeFromText( const std::string & text )
+{
+    const LoadProbe probe; // times the load in instrumented builds
     ClearMaze(); // clear the maze if there is existing maze data
+    return ParseMaze( text.data(), text.size() );
+}
+
+/** Saves the maze in the binary maze format.
+    PADDED_BYTES files hold the padded grid exactly as it is kept in memory, so LoadMaze searches them in place without copying.
+    PACKED_2BIT files hold two bits per maze cell and are a quarter of the size, but are decoded on load.
+    Terrain doesn't fit in two bits, so a maze with terrain can only be saved as PADDED_BYTES.
+
+@param filename The path to write the binary maze to.
+@param encoding The encoding of the cell payload.
+
+@retval true if the maze was successfully saved.
+@retval false if no maze is loaded, the encoding can't hold the maze's terrain, or the file could not be written.
+*/
+bool Maze::SaveBinaryMaze( const std::string & filename, const BINARY_ENCODING encoding ) const
+{
+    if ( !MazeLoaded() || ( encoding == BINARY_ENCODING::PACKED_2BIT && HasTerrain() ) )
+    {
+        return false;
+    }
+
+    const MAZE_DATA_TYPE * cells = Cells(); // the padded grid
+    std::vector<char> packedPayload; // holds the payload when it has to be converted
+    const char * payload = reinterpret_cast<const char *>( cells ); // the payload to write
+    size_t payloadSize = m_cellCount; // the number of payload bytes
+
+    if ( encoding == BINARY_ENCODING::PACKED_2BIT )
+    {
+        payloadSize = ( m_rowSize * m_columnSize + CELLS_PER_PACKED_BYTE - 1 ) / CELLS_PER_PACKED_BYTE;
+        packedPayload.assign( payloadSize, 0 );
+        size_t cell = 0; // the position of the cell within the packed payload
+        for ( size_t row = 0; row < m_rowSize; ++row )
+        {
+            for ( size_t column = 0; column < m_columnSize; ++column, ++cell )
+            {
+                const uint8_t value = static_cast<uint8_t>( cells[CellIndex( row, column )] ); // CLEAR, BLOCKED, and EXIT all fit in two bits
+                packedPayload[cell / CELLS_PER_PACKED_BYTE] |= static_cast<char>( value << ( ( cell % CELLS_PER_PACKED_BYTE ) * 2 ) );
+            }
+        }
+        payload = packedPayload.data();
+    }
+
+    BinaryMazeHeader header{}; // the header describing the payload
+    std::memcpy( header.magic, BINARY_MAGIC, sizeof( BINARY_MAGIC ) );
+    header.version = BINARY_VERSION;
+    header.encoding = static_cast<uint8_t>( encoding );
+    header.checksum = Checksum( payload, payloadSize );
+    header.columns = m_columnSize;
+    header.rows = m_rowSize;
+
+    std::ofstream file( filename, std::ios::binary | std::ios::trunc ); // the file to write the maze to
+    file.write( reinterpret_cast<const char *>( &header ), sizeof( header ) );
+    file.write( payload, payloadSize );
+    return file.good();
+}
+
+/** Loads a binary maze from a mapped file.
+    PADDED_BYTES payloads are used in place: the maze keeps the mapping open and searches the mapped cells directly.
+
+@param file The mapped binary maze file.
 
-    std::ifstream file( filename ); // holds the file to get map data from
+@retval true if the maze was successfully loaded.
+@retval false if the header, payload size, checksum, or cell data are invalid.
+*/
+bool Maze::LoadBinaryMaze( const std::shared_ptr<MappedFile> & file )
+{
+    BinaryMazeHeader header; // the header describing the payload
+    if ( file->Size() < sizeof( header ) )
+    {
+        return false;
+    }
+    std::memcpy( &header, file->Data(), sizeof( header ) );
+    if ( header.version != BINARY_VERSION || header.columns > std::numeric_limits<size_t>::max() || header.rows > std::numeric_limits<size_t>::max() )
+    {
+        return false;
+    }
 
-    if ( !file.good() ) // check that the file could be sucessfully accessed
+    const size_t rows = static_cast<size_t>( header.rows ); // holds the number of rows from the map
+    const size_t columns = static_cast<size_t>( header.columns ); // holds the number of columns from the map
+    if ( !FitsMemoryLimit( rows, columns ) ) // make sure the grid fits within the memory limit
     {
         return false;
     }
 
+    const char * payload = file->Data() + sizeof( header ); // the cell data following the header
+    const size_t payloadSize = file->Size() - sizeof( header ); // the number of bytes of cell data
+    const size_t stride = columns + 2; // the padded row size
+    switch ( static_cast<BINARY_ENCODING>( header.encoding ) )
+    {
+        case BINARY_ENCODING::PADDED_BYTES:
+        {
+            if ( payloadSize != ( rows + 2 ) * stride || Checksum( payload, payloadSize ) != header.checksum )
+            {
+                return false;
+            }
+            const MAZE_DATA_TYPE * cells = reinterpret_cast<const MAZE_DATA_TYPE *>( payload ); // the padded grid in the file
+            for ( size_t column = 0; column < stride; ++column ) // the searches rely on the border being blocked
+            {
+                if ( cells[column] != MAZE_DATA_TYPE::BLOCKED || cells[( rows + 1 ) * stride + column] != MAZE_DATA_TYPE::BLOCKED )
+                {
+                    return false;
+                }
+            }
+            for ( size_t row = 1; row <= rows; ++row )
+            {
+                if ( cells[row * stride] != MAZE_DATA_TYPE::BLOCKED || cells[row * stride + stride - 1] != MAZE_DATA_TYPE::BLOCKED )
+                {
+                    return false;
+                }
+                for ( size_t column = 1; column <= columns; ++column ) // the searches index tables by the cells, so every cell must be a known type
+                {
+                    if ( static_cast<uint8_t>( cells[row * stride + column] ) > static_cast<uint8_t>( MAZE_DATA_TYPE::LAST_TERRAIN ) )
+                    {
+                        return false;
+                    }
+                }
+            }
+            m_stride = stride;
+            m_cellCount = payloadSize;
+            m_mappedFile = file; // keep the mapping alive while the maze uses it
+            m_mappedCells = cells;
+        } break;
+        case BINARY_ENCODING::PACKED_2BIT:
+        {
+            if ( payloadSize != ( rows * columns + CELLS_PER_PACKED_BYTE - 1 ) / CELLS_PER_PACKED_BYTE || Checksum( payload, payloadSize ) != header.checksum )
+            {
+                return false;
+            }
+            ReallocateMaze( rows, columns ); // allocate the underlying data structure
+            size_t cell = 0; // the position of the cell within the packed payload
+            for ( size_t row = 0; row < rows; ++row )
+            {
+                for ( size_t column = 0; column < columns; ++column, ++cell )
+                {
+                    const char value = static_cast<char>( '0' + ( ( static_cast<uint8_t>( payload[cell / CELLS_PER_PACKED_BYTE] ) >> ( ( cell % CELLS_PER_PACKED_BYTE ) * 2 ) ) & 3 ) );
+                    if ( value > '2' || !SetPositionalData( row, column, value ) ) // the fourth two bit value is not a valid cell
+                    {
+                        return false;
+                    }
+                }
+            }
+        } break;
+        default:
+        {
+            return false;
+        } break;
+    }
+
+    m_rowSize = rows; // set the number of rows
+    m_columnSize = columns; // set the number of columns
+    BuildIndexes(); // build the search indexes for the new maze
+
+    return true;
+}
+
+/** Parses text maze data into the grid.
+
+@param data The text of the maze file.
+@param size The number of bytes of text.
+
+@retval true if the maze was successfully parsed.
+@retval false if the maze was not successfully parsed.
+*/
+bool Maze::ParseMaze( const char * data, const size_t size )
+{
+    const char * cursor = data; // the current read position
+    const char * end = data + size; // the end of the data
+    const char * lineBegin; // the start of the current line
+    const char * lineEnd; // the end of the current line
+
     size_t rows = 0; // holds the number of rows from the map
     size_t columns = 0; // holds the number of columns from the map
     char commaCheck = 0; // used to make sure there is a comma between the row and column
-    std::string line; // used to hold line data
 
-    if ( !std::getline( file, line ) ) // get the first line of the file which should contain the "rows, columns" data
+    if ( !ReadLine( cursor, end, lineBegin, lineEnd ) ) // get the first line of the file which should contain the "rows, columns" data
     {
         return false;
     }
 
-    std::istringstream parseLine( line ); // used to parse each line
-
-    parseLine >> columns >> commaCheck >> rows; // get the columns, the comma, and rows
-
-    if ( parseLine.fail() || ',' != commaCheck ) // check that the data retrieval did not fail and that the comma exists
+    // get the columns, the comma, and rows, and check that the comma exists
+    if ( !ReadUnsigned( lineBegin, lineEnd, columns ) || !ReadCharacter( lineBegin, lineEnd, commaCheck ) || ',' != commaCheck || !ReadUnsigned( lineBegin, lineEnd, rows ) )
     {
         return false;
     }
 
-    if ( ( columns > MAX_COLUMNS ) || ( rows > MAX_ROWS ) ) // make sure we didn't go over the MAX limit
+    if ( !FitsMemoryLimit( rows, columns ) ) // make sure the grid fits within the memory limit
     {
         return false;
     }
@@ -60,16 +388,13 @@ bool Maze::LoadMaze( const std::string & filename )
 
     for ( size_t row = 0; row < rows; ++row ) // iterate over the map row by row
     {
-        if ( !std::getline( file, line ) ) // check that we could get the line
+        if ( !ReadLine( cursor, end, lineBegin, lineEnd ) ) // check that we could get the line
         {
             return false;
         }
-        parseLine.clear(); // clear the parseline data
-        parseLine.str( line ); // import the next row
         for ( size_t column = 0; column < columns; ++column ) // for each column value in the row
         {
-            parseLine >> fieldValue; // get the byte of data
-            if ( parseLine.fail() ) // check that the retrieval was successful
+            if ( !ReadCharacter( lineBegin, lineEnd, fieldValue ) ) // get the byte of data
             {
                 return false;
             }
@@ -82,6 +407,7 @@ bool Maze::LoadMaze( const std::string & filename )
 
     m_rowSize = rows; // set the number of rows
     m_columnSize = columns; // set the number of columns
+    BuildIndexes(); // build the search indexes for the new maze
 
     return true; // map successfully parsed
 }
@@ -96,170 +422,1047 @@ bool Maze::MazeLoaded() const
     return m_rowSize;
 }
 
+/** Retrieves the minimum number of spaces with the chosen search.
+    The multithreaded search needs a thread pool, so it has only its own method.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param algorithm The search to run.
+
+@return The minimum number of spaces from the start to the closest end point (-1 if no end point could be reached from start or if start was invalid), with the statistics of the search.
+*/
+SearchResult Maze::MinimumNumberOfSpaces( const size_t start_row, const size_t start_column, const SEARCH_ALGORITHM algorithm ) const
+{
+    return TimedSearch( start_row, start_column, algorithm );
+}
+
+/** Retrieves the minimum number of spaces with the chosen search, searching with the caller's buffers.
+    Once the workspace has searched the maze, repeating queries on it makes no heap allocations.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param algorithm The search to run.
+@param workspace The buffers to search with, kept for the next query.
+
+@return The minimum number of spaces from the start to the closest end point (-1 if no end point could be reached from start or if start was invalid), with the statistics of the search.
+*/
+SearchResult Maze::MinimumNumberOfSpaces( const size_t start_row, const size_t start_column, const SEARCH_ALGORITHM algorithm, SearchWorkspace & workspace ) const
+{
+    return TimedSearch( start_row, start_column, algorithm, workspace );
+}
+
 /** Retrieves the minimum number of spaces using breadth first search.
-    @note This function has the side effect of reporting the number of steps taken via std out for reporting purposes.
 
 @param start_row the row the start location begins with.
 @param start_column the column the start location begins with.
 
+@return The minimum number of spaces from the start to the closest end point (-1 if no end point could be reached from start or if start was invalid), with the statistics of the search.
+*/
+SearchResult Maze::MinimumNumberOfSpacesBFS( const size_t start_row, const size_t start_column ) const
+{
+    return TimedSearch( start_row, start_column, SEARCH_ALGORITHM::BFS );
+}
+
+/** Finds the minimum number of spaces to the nearest exit using breadth first search with the maze's neighbourhood and layout.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param workspace The buffers to search with.
+@param result Receives the number of cells expanded and the largest the queue grew.
+
+@return The minimum number of spaces from the start to the closest end point, or -1 if no end point could be reached from start or if start was invalid.
+*/
+template <bool RECORD_PATH>
+int Maze::SearchBFS( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const
+{
+    return WithNeighbourhood( m_neighbourhood, [&]( auto policy )
+    {
+        return WithLayout( SearchLayout(), [&]( auto layout )
+        {
+            return BreadthFirstSearch<decltype( policy ), decltype( layout ), RECORD_PATH>( start_row, start_column, workspace, result );
+        } );
+    } );
+}
+
+template int Maze::SearchBFS<false>( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const;
+template int Maze::SearchBFS<true>( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const;
+
+/** Finds the minimum number of spaces to the nearest exit using breadth first search.
+    Visited cells are stamped in a flat array indexed like the grid and the frontier is a preallocated array of 32-bit cell indices.
+    Each cell enters the frontier at most once, so the frontier never has to grow or wrap, and the frontier holds one
+    layer after another, so the distance is counted per layer rather than stored per cell.
+    When RECORD_PATH is set the direction each cell is reached in and the exit found are kept in the workspace for
+    TracePath; otherwise that bookkeeping is compiled out. Cells, stamps, and parents are all indexed in the
+    layout's order, so a blocked layout keeps the cells around each one on the same cache lines.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param workspace The buffers to search with.
+@param result Receives the number of cells expanded and the largest the queue grew.
+
 @return The minimum number of spaces from the start to the closest end point, or -1 if no end point could be reached from start or if start was invalid.
 */
-int Maze::MinimumNumberOfSpacesBFS( const size_t start_row, const size_t start_column ) const
+template <typename NEIGHBOURHOOD_POLICY, typename LAYOUT_POLICY, bool RECORD_PATH>
+int Maze::BreadthFirstSearch( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const
 {
-    if ( start_row > m_rowSize || start_column > m_columnSize ) // check that the row and column for start is within bounds
+    if ( start_row >= m_rowSize || start_column >= m_columnSize ) // check that the row and column for start is within bounds
     {
         return PATH_UNREACHABLE;
     }
-    if ( GetPositionalData( start_row, start_column ) == MAZE_DATA_TYPE::EXIT ) // If the start is the exit, the end point costs 0 spaces
+    const LayoutGrid<LAYOUT_POLICY> grid = Grid<LAYOUT_POLICY>(); // the padded grid in the layout's order
+    const MAZE_DATA_TYPE * cells = grid.cells;
+    const size_t startIndex = grid.Index( start_row, start_column ); // the index of the starting position
+    switch ( cells[startIndex] )
     {
-        return 0;
+        case MAZE_DATA_TYPE::EXIT: // If the start is the exit, the end point costs 0 spaces
+        {
+            return 0;
+        } break;
+        case MAZE_DATA_TYPE::BLOCKED: // a blocked start can't travel anywhere
+        {
+            return PATH_UNREACHABLE;
+        } break;
+        default:
+        {
+        } break;
     }
 
-    std::unordered_map<size_t, int> distanceMap; // holds the distance from start
-    std::queue<std::pair<size_t, size_t>> mazeQueue; // the queue of points for breadth first search
+    const NeighbourOffsets<NEIGHBOURHOOD_POLICY, LAYOUT_POLICY> neighbourOffsets( grid.rowCells ); // steps to the cells a move reaches; the blocked border keeps these in bounds
 
-    mazeQueue.push( { start_row, start_column } ); // enqueue the starting position
-    distanceMap[ mazeQueue.front().first * m_columnSize + mazeQueue.front().second ] = 0; // the first point is 0 from itself
+    const uint32_t stamp = workspace.NextStamp(); // marks the cells this search has visited
+    workspace.m_cellStamps.resize( grid.cellCount, 0 );
+    uint32_t * visited = workspace.m_cellStamps.data();
+    ScratchVector<uint32_t> & frontier = workspace.m_frontier; // the queue of cell indices for breadth first search
+    frontier.resize( m_rowSize * m_columnSize );
+    size_t head = 0; // the position of the next cell to process in the frontier
+    size_t tail = 0; // the position to enqueue the next cell in the frontier
+
+    frontier[tail++] = static_cast<uint32_t>( startIndex ); // enqueue the starting position
+    visited[startIndex] = stamp;
+    if ( RECORD_PATH )
+    {
+        workspace.m_parents.resize( ( grid.cellCount * NEIGHBOURHOOD_POLICY::PARENT_BITS + 7 ) / 8 );
+    }
 
-    size_t currentRow; // holds the currently selected row
-    size_t currentColumn; // holds the currently selected column
-    int distance; // holds the distance traveled from the starting coordinate
-    int numSteps = 0; // holds the number of steps
-    while ( !mazeQueue.empty() ) // while there are spaces in the queue to process...
+    size_t peakFrontier = 1; // the most cells the queue has held
+    size_t layerEnd = tail; // the end of the layer being expanded; the queue holds one layer after another
+    int distance = 1; // the distance of the neighbours of the layer being expanded
+    while ( head < tail ) // while there are spaces in the queue to process...
     {
-        ++numSteps; // increase the number of steps taken
-        currentRow = mazeQueue.front().first; // set the current row from the front of the queue
-        currentColumn = mazeQueue.front().second; // set the current column from the front of the queue
-        distance = distanceMap[ currentRow * m_columnSize + currentColumn ]; // get the distance of the current point
-        switch( GetPositionalData( currentRow, currentColumn ) ) // get the value of the current point
+        if ( head == layerEnd ) // the layer is done, so its neighbours are one space further
+        {
+            layerEnd = tail;
+            ++distance;
+        }
+        peakFrontier = std::max( peakFrontier, tail - head );
+        ++result.cellsExpanded; // increase the number of steps taken
+        const size_t currentIndex = frontier[head++]; // dequeue the current cell
+
+        // visit each neighbour we haven't traveled to, stopping at an exit
+        const bool exitFound = VisitNeighbours( cells, currentIndex, neighbourOffsets, [&]( const uint8_t direction, const size_t neighbourIndex )
         {
-            case MAZE_DATA_TYPE::EXIT: // exit found, report number of steps and return distance from start
+            if ( visited[neighbourIndex] == stamp ) // already visited
             {
-                std::cout << "Num Steps: " << numSteps << std::endl;
-                return distance;
-            } break;
-            case MAZE_DATA_TYPE::BLOCKED: // this is a blocked point, dequeue since we can't travel to it
+                result.counters.RevisitAvoided();
+                return false;
+            }
+            switch ( cells[neighbourIndex] )
             {
-                mazeQueue.pop();
-                continue;
+                case MAZE_DATA_TYPE::EXIT: // exit found, return distance from start
+                {
+                    if ( RECORD_PATH )
+                    {
+                        workspace.SetParent<NEIGHBOURHOOD_POLICY::PARENT_BITS>( neighbourIndex, direction );
+                        workspace.m_pathEnd = static_cast<uint32_t>( neighbourIndex );
+                    }
+                    return true;
+                } break;
+                case MAZE_DATA_TYPE::BLOCKED: // blocked points are never enqueued
+                {
+                } break;
+                default: // cleared point
+                {
+                    visited[neighbourIndex] = stamp;
+                    frontier[tail++] = static_cast<uint32_t>( neighbourIndex );
+                    result.counters.Enqueue();
+                    if ( RECORD_PATH )
+                    {
+                        workspace.SetParent<NEIGHBOURHOOD_POLICY::PARENT_BITS>( neighbourIndex, direction );
+                    }
+                } break;
             }
-            default: // cleared point
+            return false;
+        } );
+        if ( exitFound )
+        {
+            result.peakFrontier = peakFrontier;
+            return distance;
+        }
+    }
+
+    // could not find an end point
+    result.peakFrontier = peakFrontier;
+    return PATH_UNREACHABLE;
+}
+
+/** Retrieves the minimum number of spaces to the nearest exit along with the route itself.
+    Breadth first search and A* record the direction each cell is reached in, 2 bits per cell (4 with diagonal
+    moves), and the route is traced back from the exit; the distance field route walks downhill from the start.
+    Other algorithms, and A* and the distance field when the neighbourhood has diagonal moves, are answered with
+    breadth first search. The distance-only searches never pay for the recording.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param algorithm The search to run: BFS, A_STAR, or DISTANCE_FIELD.
+@param path Receives the row and column of every space on the route, from the start to the exit, or nothing if there is no route.
+
+@return The minimum number of spaces from the start to the closest end point (-1 if no end point could be reached from start or if start was invalid), with the statistics of the search.
+*/
+SearchResult Maze::MinimumPath( const size_t start_row, const size_t start_column, const SEARCH_ALGORITHM algorithm, std::vector<std::pair<size_t, size_t>> & path ) const
+{
+    SearchWorkspace workspace; // the buffers for this search
+    return MinimumPath( start_row, start_column, algorithm, path, workspace );
+}
+
+/** Retrieves the minimum number of spaces to the nearest exit along with the route itself, searching with the caller's buffers.
+    Once the workspace has searched the maze, and path holds the longest route asked for, repeating queries on them
+    makes no heap allocations.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param algorithm The search to run: BFS, A_STAR, or DISTANCE_FIELD.
+@param path Receives the row and column of every space on the route, from the start to the exit, or nothing if there is no route.
+@param workspace The buffers to search with, kept for the next query.
+
+@return The minimum number of spaces from the start to the closest end point (-1 if no end point could be reached from start or if start was invalid), with the statistics of the search.
+*/
+SearchResult Maze::MinimumPath( const size_t start_row, const size_t start_column, const SEARCH_ALGORITHM algorithm, std::vector<std::pair<size_t, size_t>> & path, SearchWorkspace & workspace ) const
+{
+    path.clear();
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(); // when the search started
+    SearchResult result; // the distance and counters of the search
+    const SearchProbe probe( result ); // counts the search in instrumented builds
+    const SEARCH_ALGORITHM pathAlgorithm = NeighbourhoodAlgorithm( algorithm ); // the search that can answer in the maze's neighbourhood
+    if ( !ExitUnreachable( start_row, start_column ) )
+    {
+        switch ( pathAlgorithm )
+        {
+            case SEARCH_ALGORITHM::A_STAR:
+            {
+                result.distance = SearchAStar<true>( start_row, start_column, workspace, result );
+            } break;
+            case SEARCH_ALGORITHM::DISTANCE_FIELD:
             {
+                result.distance = DistanceFieldLookup( start_row, start_column );
             } break;
+            default:
+            {
+                result.distance = SearchBFS<true>( start_row, start_column, workspace, result );
+            } break;
+        }
+    }
+    if ( result.distance != PATH_UNREACHABLE )
+    {
+        TracePath( start_row, start_column, result.distance, pathAlgorithm == SEARCH_ALGORITHM::DISTANCE_FIELD, workspace, path );
+    }
+    result.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start );
+    return result;
+}
+
+/** Writes a route as a run-length encoded string of moves, e.g. "3R2D1L" for three spaces right, two down, and one left.
+    A diagonal move is written with both of its letters, e.g. "2DR" for two spaces down and to the right.
+
+@param path The row and column of every space on the route, as MinimumPath gives it.
+
+@return The encoded moves, or an empty string if the route has no moves.
+*/
+std::string Maze::EncodePath( const std::vector<std::pair<size_t, size_t>> & path )
+{
+    std::string moves;
+    std::string previousMove; // the move being counted
+    size_t count = 0; // the number of times in a row the move was made
+    for ( size_t step = 1; step <= path.size(); ++step )
+    {
+        std::string move; // the move from the previous space, or empty past the end of the route
+        if ( step < path.size() )
+        {
+            const std::pair<size_t, size_t> & from = path[step - 1];
+            const std::pair<size_t, size_t> & to = path[step];
+            if ( to.first != from.first )
+            {
+                move.push_back( ( to.first < from.first ) ? 'U' : 'D' );
+            }
+            if ( to.second != from.second )
+            {
+                move.push_back( ( to.second < from.second ) ? 'L' : 'R' );
+            }
+        }
+        if ( move == previousMove )
+        {
+            ++count;
+            continue;
         }
+        if ( count > 0 )
+        {
+            moves += std::to_string( count );
+            moves += previousMove;
+        }
+        previousMove = move;
+        count = 1;
+    }
+    return moves;
+}
+
+/** Lists the spaces of a route found by a path recording search or along the distance field.
+    The distance field is kept in row-major order; the recorded directions are in the order of the layout searched.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param distance The length of the route.
+@param followField Whether to walk down the distance field rather than back along the recorded directions.
+@param workspace The buffers of the path recording search.
+@param path Receives the row and column of every space on the route, from the start to the exit.
+*/
+void Maze::TracePath( const size_t start_row, const size_t start_column, const int distance, const bool followField, const SearchWorkspace & workspace, std::vector<std::pair<size_t, size_t>> & path ) const
+{
+    const bool diagonalMoves = ( m_neighbourhood != NEIGHBOURHOOD::FOUR_WAY ); // whether the directions were recorded in 4 bits rather than 2
+    path.resize( static_cast<size_t>( distance ) + 1 );
+
+    if ( followField ) // every space but an exit has a neighbour one closer
+    {
+        const NeighbourOffsets<FourWayNeighbourhood> neighbourOffsets( m_stride ); // steps of the moves down the field
+        size_t index = CellIndex( start_row, start_column ); // the space reached so far
+        for ( size_t step = 0; step < path.size(); ++step )
+        {
+            path[step] = { index / m_stride - 1, index % m_stride - 1 };
+            for ( size_t direction = 0; direction < ORTHOGONAL_MOVES; ++direction )
+            {
+                const size_t neighbourIndex = neighbourOffsets.Move( index, direction );
+                if ( m_distanceField[neighbourIndex] == m_distanceField[index] - 1 )
+                {
+                    index = neighbourIndex;
+                    break;
+                }
+            }
+        }
+        return;
+    }
+
+    WithLayout( SearchLayout(), [&]( auto layout )
+    {
+        const LayoutGrid<decltype( layout )> grid = Grid<decltype( layout )>(); // the grid the directions were recorded in
+        const NeighbourOffsets<EightWayNeighbourhood, decltype( layout )> neighbourOffsets( grid.rowCells ); // steps of every move, indexed by the recorded direction
+        size_t index = ( distance == 0 ) ? grid.Index( start_row, start_column ) : workspace.m_pathEnd; // the space traced back to so far
+        for ( size_t step = path.size(); step-- > 0; )
+        {
+            path[step] = { grid.Row( index ) - 1, grid.Column( index ) - 1 };
+            if ( step > 0 )
+            {
+                const uint8_t direction = diagonalMoves ? workspace.GetParent<EightWayNeighbourhood::PARENT_BITS>( index ) : workspace.GetParent<FourWayNeighbourhood::PARENT_BITS>( index ); // the move that reached the space
+                index = neighbourOffsets.Move( index, REVERSE_MOVES[direction] );
+            }
+        }
+    } );
+}
+
+/** Retrieves the minimum number of spaces between two positions using a bidirectional breadth first search.
+    Exits are ordinary clear spaces for this query; only blocked spaces are in the way.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param goal_row the row of the goal location.
+@param goal_column the column of the goal location.
+
+@return The minimum number of spaces from the start to the goal (-1 if the goal can't be reached or either position is invalid or blocked), with the statistics of the search.
+*/
+SearchResult Maze::MinimumNumberOfSpacesBetween( const size_t start_row, const size_t start_column, const size_t goal_row, const size_t goal_column ) const
+{
+    SearchWorkspace workspace; // the buffers for this search
+    return MinimumNumberOfSpacesBetween( start_row, start_column, goal_row, goal_column, workspace );
+}
+
+/** Retrieves the minimum number of spaces between two positions, searching with the caller's buffers.
+    Once the workspace has searched the maze, repeating queries on it makes no heap allocations.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param goal_row the row of the goal location.
+@param goal_column the column of the goal location.
+@param workspace The buffers to search with, kept for the next query.
+
+@return The minimum number of spaces from the start to the goal (-1 if the goal can't be reached or either position is invalid or blocked), with the statistics of the search.
+*/
+SearchResult Maze::MinimumNumberOfSpacesBetween( const size_t start_row, const size_t start_column, const size_t goal_row, const size_t goal_column, SearchWorkspace & workspace ) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(); // when the search started
+    SearchResult result; // the distance and counters of the search
+    const SearchProbe probe( result ); // counts the search in instrumented builds
+    result.distance = SearchBidirectional( start_row, start_column, goal_row, goal_column, workspace, result );
+    result.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start );
+    return result;
+}
+
+/** Finds the minimum number of spaces between two positions with a bidirectional breadth first search in the maze's neighbourhood and layout.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param goal_row the row of the goal location.
+@param goal_column the column of the goal location.
+@param workspace The buffers to search with.
+@param result Receives the number of cells expanded and the largest the two queues grew together.
+
+@return The minimum number of spaces from the start to the goal, or -1 if the goal can't be reached or either position is invalid or blocked.
+*/
+int Maze::SearchBidirectional( const size_t start_row, const size_t start_column, const size_t goal_row, const size_t goal_column, SearchWorkspace & workspace, SearchResult & result ) const
+{
+    return WithNeighbourhood( m_neighbourhood, [&]( auto policy )
+    {
+        return WithLayout( SearchLayout(), [&]( auto layout )
+        {
+            return BidirectionalSearch<decltype( policy ), decltype( layout )>( start_row, start_column, goal_row, goal_column, workspace, result );
+        } );
+    } );
+}
+
+/** Finds the minimum number of spaces between two positions with a breadth first search grown from both ends.
+    Each side keeps its own flat distance array and preallocated index queue, like SearchBFS. Whole layers are
+    expanded at a time, always on the side with the smaller frontier. The first layer that touches the other side
+    holds the shortest path, so that layer is finished and the shortest meeting is returned.
+    On open maps the two searches each cover a disc of half the radius, about half the area of a one-sided search.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param goal_row the row of the goal location.
+@param goal_column the column of the goal location.
+@param workspace The buffers to search with.
+@param result Receives the number of cells expanded and the largest the two queues grew together.
+
+@return The minimum number of spaces from the start to the goal, or -1 if the goal can't be reached or either position is invalid or blocked.
+*/
+template <typename NEIGHBOURHOOD_POLICY, typename LAYOUT_POLICY>
+int Maze::BidirectionalSearch( const size_t start_row, const size_t start_column, const size_t goal_row, const size_t goal_column, SearchWorkspace & workspace, SearchResult & result ) const
+{
+    if ( start_row >= m_rowSize || start_column >= m_columnSize || goal_row >= m_rowSize || goal_column >= m_columnSize )
+    {
+        return PATH_UNREACHABLE;
+    }
+    const LayoutGrid<LAYOUT_POLICY> grid = Grid<LAYOUT_POLICY>(); // the padded grid in the layout's order
+    const MAZE_DATA_TYPE * cells = grid.cells;
+    const size_t startIndex = grid.Index( start_row, start_column ); // the index of the starting position
+    const size_t goalIndex = grid.Index( goal_row, goal_column ); // the index of the goal position
+    if ( cells[startIndex] == MAZE_DATA_TYPE::BLOCKED || cells[goalIndex] == MAZE_DATA_TYPE::BLOCKED )
+    {
+        return PATH_UNREACHABLE;
+    }
+    if ( startIndex == goalIndex )
+    {
+        return 0;
+    }
+    if ( m_neighbourhood != NEIGHBOURHOOD::EIGHT_WAY && m_componentLabels[CellIndex( start_row, start_column )] != m_componentLabels[CellIndex( goal_row, goal_column )] ) // the goal is in another region, so neither side would ever meet the other
+    {
+        return PATH_UNREACHABLE;
+    }
+
+    const NeighbourOffsets<NEIGHBOURHOOD_POLICY, LAYOUT_POLICY> neighbourOffsets( grid.rowCells ); // steps to the cells a move reaches; the blocked border keeps these in bounds
+
+    using StampedValue = SearchWorkspace::StampedValue;
+    const uint32_t stamp = workspace.NextStamp(); // marks the cells each side has visited
+    ScratchVector<StampedValue> * distances[2] = { &workspace.m_distances, &workspace.m_reverseDistances }; // the distance from each end, where stamped
+    ScratchVector<uint32_t> * frontiers[2] = { &workspace.m_frontier, &workspace.m_reverseFrontier }; // the queue of each end
+    size_t head[2] = { 0, 0 }; // the position of the next cell to process in each queue
+    size_t tail[2] = { 1, 1 }; // the position to enqueue the next cell in each queue
+    const size_t ends[2] = { startIndex, goalIndex };
+    for ( size_t side = 0; side < 2; ++side )
+    {
+        distances[side]->resize( grid.cellCount, StampedValue{ 0, 0 } );
+        frontiers[side]->resize( m_rowSize * m_columnSize );
+        ( *distances[side] )[ends[side]] = { stamp, 0 };
+        ( *frontiers[side] )[0] = static_cast<uint32_t>( ends[side] );
+    }
+    result.peakFrontier = 2;
+
+    while ( head[0] < tail[0] && head[1] < tail[1] ) // both sides still have spaces to grow into
+    {
+        const size_t side = ( tail[0] - head[0] <= tail[1] - head[1] ) ? 0 : 1; // grow the smaller frontier
+        StampedValue * near = distances[side]->data(); // the distances of the side being grown
+        const StampedValue * far = distances[1 - side]->data(); // the distances of the other side
+        uint32_t * frontier = frontiers[side]->data();
+
+        const size_t layerEnd = tail[side]; // the end of the layer being expanded
+        int shortest = std::numeric_limits<int>::max(); // the shortest path through a meeting found in this layer
+        while ( head[side] < layerEnd )
+        {
+            ++result.cellsExpanded;
+            const size_t currentIndex = frontier[head[side]++]; // dequeue the current cell
+            const int distance = near[currentIndex].value + 1; // the distance of the surrounding points
+            VisitNeighbours( cells, currentIndex, neighbourOffsets, [&]( const uint8_t, const size_t neighbourIndex )
+            {
+                if ( cells[neighbourIndex] == MAZE_DATA_TYPE::BLOCKED )
+                {
+                    return false;
+                }
+                if ( far[neighbourIndex].stamp == stamp ) // the other side has been here, so the two meet
+                {
+                    shortest = std::min( shortest, distance + far[neighbourIndex].value );
+                    return false;
+                }
+                if ( near[neighbourIndex].stamp != stamp )
+                {
+                    near[neighbourIndex] = { stamp, distance };
+                    frontier[tail[side]++] = static_cast<uint32_t>( neighbourIndex );
+                    result.counters.Enqueue();
+                }
+                else
+                {
+                    result.counters.RevisitAvoided();
+                }
+                return false;
+            } );
+        }
+        result.peakFrontier = std::max( result.peakFrontier, ( tail[0] - head[0] ) + ( tail[1] - head[1] ) );
+
+        if ( shortest != std::numeric_limits<int>::max() )
+        {
+            return shortest;
+        }
+    }
+
+    // one side ran out of spaces before meeting the other
+    return PATH_UNREACHABLE;
+}
+
+/** Retrieves the minimum number of spaces using a bit-parallel breadth first search.
+    Gives the same answers as MinimumNumberOfSpacesBFS, but expands a whole layer at a time over packed bit rows,
+    which is much faster on large open mazes. Its statistics count layers and frontier words rather than cells.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+
+@return The minimum number of spaces from the start to the closest end point (-1 if no end point could be reached from start or if start was invalid), with the statistics of the search.
+*/
+SearchResult Maze::MinimumNumberOfSpacesBitParallelBFS( const size_t start_row, const size_t start_column ) const
+{
+    return TimedSearch( start_row, start_column, SEARCH_ALGORITHM::BIT_PARALLEL_BFS );
+}
+
+/** Builds the distance from every cell to its nearest exit.
+    A single breadth first search is seeded with every exit at once and walks outward through clear cells,
+    after which MinimumNumberOfSpacesDistanceField answers any start in constant time.
+    The field is discarded when a maze is loaded.
+*/
+void Maze::BuildDistanceField()
+{
+    AdvanceGeneration();
+    const MAZE_DATA_TYPE * cells = Cells(); // the padded grid
+    const ptrdiff_t neighbourOffsets[] = { -static_cast<ptrdiff_t>( m_stride ), -1, static_cast<ptrdiff_t>( m_stride ), 1 }; // offsets to the surrounding cells
+
+    m_distanceField.assign( m_cellCount, PATH_UNREACHABLE );
+    std::vector<uint32_t> frontier( m_rowSize * m_columnSize ); // the queue of cell indices, each enqueued at most once
+    size_t head = 0; // the position of the next cell to process in the frontier
+    size_t tail = 0; // the position to enqueue the next cell in the frontier
+
+    for ( const std::pair<size_t, size_t> & exit : m_exits ) // every exit is 0 from itself
+    {
+        const size_t exitIndex = exit.first * m_stride + exit.second;
+        m_distanceField[exitIndex] = 0;
+        frontier[tail++] = static_cast<uint32_t>( exitIndex );
+    }
+
+    while ( head < tail )
+    {
+        const size_t currentIndex = frontier[head++]; // dequeue the current cell
+        const int distance = m_distanceField[currentIndex] + 1; // the distance of the surrounding points
+        for ( const ptrdiff_t offset : neighbourOffsets )
+        {
+            const size_t neighbourIndex = currentIndex + offset;
+            // only clear and terrain cells travel on toward an exit; blocked cells stay unreachable
+            if ( cells[neighbourIndex] != MAZE_DATA_TYPE::BLOCKED && m_distanceField[neighbourIndex] == PATH_UNREACHABLE )
+            {
+                m_distanceField[neighbourIndex] = distance;
+                frontier[tail++] = static_cast<uint32_t>( neighbourIndex );
+            }
+        }
+    }
+}
+
+/** Checks whether the distance field has been built for the loaded maze.
+
+@retval true if the distance field is built.
+@retval false if the distance field needs to be built with BuildDistanceField.
+*/
+bool Maze::DistanceFieldBuilt() const
+{
+    return !m_distanceField.empty();
+}
+
+/** Retrieves the minimum number of spaces by looking the start up in the distance field.
+    Gives the same answers as MinimumNumberOfSpacesBFS once BuildDistanceField has been called.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+
+@return The minimum number of spaces from the start to the closest end point, or -1 if no end point could be reached from start, if start was invalid, or if the distance field isn't built.
+*/
+SearchResult Maze::MinimumNumberOfSpacesDistanceField( const size_t start_row, const size_t start_column ) const
+{
+    return TimedSearch( start_row, start_column, SEARCH_ALGORITHM::DISTANCE_FIELD );
+}
+
+/** Looks the start up in the distance field.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+
+@return The minimum number of spaces from the start to the closest end point, or -1 if no end point could be reached from start, if start was invalid, or if the distance field isn't built.
+*/
+int Maze::DistanceFieldLookup( const size_t start_row, const size_t start_column ) const
+{
+    if ( start_row >= m_rowSize || start_column >= m_columnSize || !DistanceFieldBuilt() )
+    {
+        return PATH_UNREACHABLE;
+    }
+    return m_distanceField[CellIndex( start_row, start_column )];
+}
+
+/** Retrieves the minimum number of spaces for many starting points at once, spread across the workers of a thread pool.
+    The workers search on workspaces made for this batch alone; callers running many batches should keep their own
+    and pass them to the overload taking workspaces.
+    The maze must not be loaded or reloaded while the batch runs.
+
+@param starts The row and column of each starting point.
+@param algorithm The search to answer every query with.
+@param pool The thread pool to run the queries on.
+
+@return The minimum number of spaces for each starting point in the same order, with -1 where no end point could be reached or the start was invalid.
+*/
+std::vector<int> Maze::MinimumNumberOfSpacesBatch( const std::vector<std::pair<size_t, size_t>> & starts, const SEARCH_ALGORITHM algorithm, ThreadPool & pool ) const
+{
+    std::vector<SearchWorkspace> workspaces; // one set of scratch buffers per worker, dropped with the batch
+    return MinimumNumberOfSpacesBatch( starts, algorithm, pool, workspaces );
+}
+
+/** Retrieves the minimum number of spaces for many starting points at once, spread across the workers of a thread pool.
+    Each worker claims chunks of BATCH_CHUNK_SIZE queries and runs them on its own SearchWorkspace, so the workers share
+    nothing mutable but the chunk counter and their own slices of the results. Kept between batches, the workspaces
+    stop growing once they fit the largest maze searched, so later batches search without allocating buffers.
+    The maze must not be loaded or reloaded while the batch runs, and nothing else may use the workspaces; batches on
+    the same pool never overlap, so they can share one set.
+
+@param starts The row and column of each starting point.
+@param algorithm The search to answer every query with.
+@param pool The thread pool to run the queries on.
+@param workspaces The scratch buffers of each worker, added to first if there are fewer than the pool has workers.
+
+@return The minimum number of spaces for each starting point in the same order, with -1 where no end point could be reached or the start was invalid.
+*/
+std::vector<int> Maze::MinimumNumberOfSpacesBatch( const std::vector<std::pair<size_t, size_t>> & starts, const SEARCH_ALGORITHM algorithm, ThreadPool & pool, std::vector<SearchWorkspace> & workspaces ) const
+{
+    std::vector<int> distances( starts.size(), PATH_UNREACHABLE ); // the answer to each query
+    if ( workspaces.size() < pool.GetThreadCount() )
+    {
+        workspaces.resize( pool.GetThreadCount() );
+    }
+    std::atomic<size_t> nextQuery{ 0 }; // the first query of the next unclaimed chunk
+
+    pool.Run( [&]( const size_t worker )
+    {
+        SearchWorkspace & workspace = workspaces[worker];
+        for ( size_t first = nextQuery.fetch_add( BATCH_CHUNK_SIZE ); first < starts.size(); first = nextQuery.fetch_add( BATCH_CHUNK_SIZE ) )
+        {
+            const size_t last = std::min( first + BATCH_CHUNK_SIZE, starts.size() ); // one past the last query of the chunk
+            for ( size_t query = first; query < last; ++query )
+            {
+                distances[query] = Search( starts[query].first, starts[query].second, algorithm, workspace ).distance;
+            }
+        }
+    } );
+
+    return distances;
+}
+
+/** Times a single search run on its own workspace.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param algorithm The search to run.
+
+@return The result of the search, including the time it took.
+*/
+SearchResult Maze::TimedSearch( const size_t start_row, const size_t start_column, const SEARCH_ALGORITHM algorithm ) const
+{
+    SearchWorkspace workspace; // the buffers for this search
+    return TimedSearch( start_row, start_column, algorithm, workspace );
+}
+
+/** Times a single search run on the given workspace.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param algorithm The search to run.
+@param workspace The buffers to search with.
+
+@return The result of the search, including the time it took.
+*/
+SearchResult Maze::TimedSearch( const size_t start_row, const size_t start_column, const SEARCH_ALGORITHM algorithm, SearchWorkspace & workspace ) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(); // when the search started
+    SearchResult result = Search( start_row, start_column, algorithm, workspace );
+    result.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start );
+    return result;
+}
+
+/** Finds the minimum number of spaces to the nearest exit with the chosen search.
+    Searches do no I/O and are only timed here in instrumented builds, so this is what batches call for every query.
+    Searches that only move four ways are answered with breadth first search when the neighbourhood has diagonal moves.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param algorithm The search to run.
+@param workspace The buffers to search with.
+
+@return The minimum number of spaces from the start to the closest end point (-1 if no end point could be reached from start or if start was invalid), with the counters of the search.
+*/
+SearchResult Maze::Search( const size_t start_row, const size_t start_column, const SEARCH_ALGORITHM algorithm, SearchWorkspace & workspace ) const
+{
+    SearchResult result; // the distance and counters of the search
+    const SearchProbe probe( result ); // counts the search in instrumented builds
+    if ( ExitUnreachable( start_row, start_column ) ) // no search could find an exit, so don't walk the whole region to prove it
+    {
+        return result;
+    }
+    switch ( NeighbourhoodAlgorithm( algorithm ) )
+    {
+        case SEARCH_ALGORITHM::BFS:
+        {
+            result.distance = SearchBFS<false>( start_row, start_column, workspace, result );
+        } break;
+        case SEARCH_ALGORITHM::DFS:
+        {
+            result.distance = SearchDFS( start_row, start_column, workspace, result );
+        } break;
+        case SEARCH_ALGORITHM::ITERATIVE_DFS:
+        {
+            result.distance = SearchIterativeDFS( start_row, start_column, workspace, result );
+        } break;
+        case SEARCH_ALGORITHM::BIT_PARALLEL_BFS:
+        {
+            result.distance = m_bitGrid.ExitDistance( start_row, start_column, result.cellsExpanded, result.peakFrontier, workspace.m_bitGrid );
+        } break;
+        case SEARCH_ALGORITHM::DISTANCE_FIELD:
+        {
+            result.distance = DistanceFieldLookup( start_row, start_column );
+        } break;
+        case SEARCH_ALGORITHM::A_STAR:
+        {
+            result.distance = SearchAStar<false>( start_row, start_column, workspace, result );
+        } break;
+        case SEARCH_ALGORITHM::JUMP_POINT:
+        {
+            result.distance = SearchJumpPoint( start_row, start_column, workspace, result );
+        } break;
+        case SEARCH_ALGORITHM::HIERARCHICAL:
+        {
+            result.distance = SearchHierarchical( start_row, start_column, true, workspace, result );
+        } break;
+        case SEARCH_ALGORITHM::HIERARCHICAL_APPROXIMATE:
+        {
+            result.distance = SearchHierarchical( start_row, start_column, false, workspace, result );
+        } break;
+        case SEARCH_ALGORITHM::DIJKSTRA:
+        {
+            result.distance = SearchDijkstra( start_row, start_column, workspace, result );
+        } break;
+        default:
+        {
+        } break;
+    }
+    return result;
+}
+
+/** Chooses the search that answers for an algorithm in the maze's neighbourhood.
+    Breadth first search, depth first search, and Dijkstra's algorithm take the neighbourhood as a policy; the others
+    rely on four-way moves (the heuristics, jumps, packed rows, field, and hierarchy all assume them), so with
+    diagonal moves they are answered with breadth first search.
+
+@param algorithm The search asked for.
+
+@return The search to run.
+*/
+Maze::SEARCH_ALGORITHM Maze::NeighbourhoodAlgorithm( const SEARCH_ALGORITHM algorithm ) const
+{
+    if ( m_neighbourhood == NEIGHBOURHOOD::FOUR_WAY )
+    {
+        return algorithm;
+    }
+    switch ( algorithm )
+    {
+        case SEARCH_ALGORITHM::BFS: //intentional fallthrough
+        case SEARCH_ALGORITHM::DFS: //intentional fallthrough
+        case SEARCH_ALGORITHM::DIJKSTRA:
+        {
+            return algorithm;
+        } break;
+        default:
+        {
+            return SEARCH_ALGORITHM::BFS;
+        } break;
+    }
+}
+
+/** Retrieves the minimum number of spaces using a depth first search.
+    Mazes larger than MAX_RECURSIVE_ROWS by MAX_RECURSIVE_COLUMNS are searched with the iterative depth first search instead,
+    since the recursion could otherwise run out of stack space.
+
+@param start_row The row of the starting point.
+@param start_column The column of the starting point.
+
+@return the minimum number of spaces from the starting point to the nearest exit point, or -1 if no exit point could be found or the starting point is invalid.
+*/
+SearchResult Maze::MinimumNumberOfSpacesDFS( const size_t start_row, const size_t start_column ) const
+{
+    return TimedSearch( start_row, start_column, SEARCH_ALGORITHM::DFS );
+}
+
+/** Finds the minimum number of spaces to the nearest exit using a depth first search in the maze's neighbourhood.
+    Falls back to the iterative depth first search on mazes larger than MAX_RECURSIVE_ROWS by MAX_RECURSIVE_COLUMNS,
+    or to breadth first search there if the neighbourhood has diagonal moves.
+
+@param start_row The row of the starting point.
+@param start_column The column of the starting point.
+@param workspace The buffers to search with.
+@param result Receives the number of steps traversed and the deepest the recursion went.
+
+@return the minimum number of spaces from the starting point to the nearest exit point, or -1 if no exit point could be found or the starting point is invalid.
+*/
+int Maze::SearchDFS( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const
+{
+    // if out of bounds, report that the end can't be found
+    if ( start_row >= m_rowSize || start_column >= m_columnSize )
+    {
+        return PATH_UNREACHABLE;
+    }
+    // if the starting point is the exit, the number of spaces is 0
+    if ( Cells()[CellIndex( start_row, start_column )] == MAZE_DATA_TYPE::EXIT )
+    {
+        return 0;
+    }
+
+    // protect the call stack on large mazes
+    if ( m_rowSize > MAX_RECURSIVE_ROWS || m_columnSize > MAX_RECURSIVE_COLUMNS )
+    {
+        return ( m_neighbourhood == NEIGHBOURHOOD::FOUR_WAY ) ? SearchIterativeDFS( start_row, start_column, workspace, result ) : SearchBFS<false>( start_row, start_column, workspace, result );
+    }
+
+    const uint32_t stamp = workspace.NextStamp(); // marks the spaces on the current path
+    int shortest = PATH_UNREACHABLE; // the smallest path found so far
+
+    WithNeighbourhood( m_neighbourhood, [&]( auto policy )
+    {
+        return WithLayout( SearchLayout(), [&]( auto layout )
+        {
+            const LayoutGrid<decltype( layout )> grid = Grid<decltype( layout )>(); // the padded grid in the layout's order
+            const size_t startIndex = grid.Index( start_row, start_column ); // the index of the starting position
+            const NeighbourOffsets<decltype( policy ), decltype( layout )> neighbourOffsets( grid.rowCells ); // steps to the cells a move reaches
+            workspace.m_cellStamps.resize( grid.cellCount, 0 );
+            uint32_t * traversed = workspace.m_cellStamps.data(); // holds the stamp on every traversed space
+            traversed[startIndex] = stamp; // the starting position is traversed
+            return VisitNeighbours( grid.cells, startIndex, neighbourOffsets, [&]( const uint8_t, const size_t neighbourIndex )
+            {
+                KeepShortestPath( shortest, DepthFirstRecursion( grid.cells, neighbourIndex, traversed, stamp, 0, neighbourOffsets, result ) );
+                return false;
+            } );
+        } );
+    } );
+
+    // the smallest path, or -1 if there was no valid path
+    return shortest;
+}
+
+/** Retrieves the minimum number of spaces using an iterative depth first search.
+    Uses an explicit stack instead of recursion, so the call stack does not limit the maze size.
+    A branch is abandoned once it can no longer beat the best exit distance found so far, and a cell
+    is only expanded again when it is reached at a smaller depth than before, which keeps the search polynomial.
+    Neighbours closest to an exit are explored first so a short path is found early and the bound prunes sooner.
+
+@param start_row The row of the starting point.
+@param start_column The column of the starting point.
+
+@return the minimum number of spaces from the starting point to the nearest exit point, or -1 if no exit point could be found or the starting point is invalid.
+*/
+SearchResult Maze::MinimumNumberOfSpacesIterativeDFS( const size_t start_row, const size_t start_column ) const
+{
+    return TimedSearch( start_row, start_column, SEARCH_ALGORITHM::ITERATIVE_DFS );
+}
 
-        ++distance; // increase distance for surrounding points
-        // if we haven't traveled to the left, enqueue the point
-        if ( ( currentRow > 0 ) && ( distanceMap.find( ( currentRow - 1 ) * m_columnSize + currentColumn )  == distanceMap.cend() ) )
-        {
-            distanceMap[ ( currentRow - 1 ) * m_columnSize + currentColumn ] = distance;
-            mazeQueue.push( { currentRow - 1, currentColumn } );
-        }
-        // if we haven't traveled up, enqueue the point
-        if ( ( currentColumn > 0 ) && ( distanceMap.find( currentRow * m_columnSize + ( currentColumn - 1 ) ) == distanceMap.cend() ) )
-        {
-            distanceMap[ currentRow * m_columnSize + ( currentColumn - 1 ) ] = distance;
-            mazeQueue.push( { currentRow, currentColumn - 1 } );
-        }
-        // if we haven't traveled right, enqueue the point
-        if ( ( currentRow + 1 < m_rowSize ) && ( distanceMap.find( ( currentRow + 1 ) * m_columnSize + currentColumn ) == distanceMap.cend() ) )
-        {
-            distanceMap[ ( currentRow + 1 ) * m_columnSize + currentColumn ] = distance;
-            mazeQueue.push( { currentRow + 1, currentColumn } );
-        }
-        // if we haven't traveled down, enqueue the point
-        if ( ( currentColumn + 1 < m_columnSize ) && ( distanceMap.find( currentRow * m_columnSize + ( currentColumn + 1 ) ) == distanceMap.cend() ) )
-        {
-            distanceMap[currentRow * m_columnSize + ( currentColumn + 1 )] = distance;
-            mazeQueue.push({ currentRow, currentColumn + 1 });
-        }
+/** Finds the minimum number of spaces to the nearest exit using the iterative depth first search.
 
-        // finished processing
-        mazeQueue.pop();
-    }
+@param start_row The row of the starting point.
+@param start_column The column of the starting point.
+@param workspace The buffers to search with.
+@param result Receives the number of steps traversed and the largest the stack grew.
 
-    // could not find an end point, so report the number of steps attempted and return -1
-    std::cout << "Num Steps: " << numSteps << std::endl;
-    return PATH_UNREACHABLE;
+@return the minimum number of spaces from the starting point to the nearest exit point, or -1 if no exit point could be found or the starting point is invalid.
+*/
+int Maze::SearchIterativeDFS( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const
+{
+    return WithLayout( SearchLayout(), [&]( auto layout )
+    {
+        return IterativeDepthFirstSearch<decltype( layout )>( start_row, start_column, workspace, result );
+    } );
 }
 
-/** Retrieves the minimum number of spaces using a depth first search.
+/** Finds the minimum number of spaces to the nearest exit using the iterative depth first search in the maze's layout.
 
 @param start_row The row of the starting point.
 @param start_column The column of the starting point.
+@param workspace The buffers to search with.
+@param result Receives the number of steps traversed and the largest the stack grew.
 
 @return the minimum number of spaces from the starting point to the nearest exit point, or -1 if no exit point could be found or the starting point is invalid.
 */
-int Maze::MinimumNumberOfSpacesDFS( const size_t start_row, const size_t start_column ) const
+template <typename LAYOUT_POLICY>
+int Maze::IterativeDepthFirstSearch( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const
 {
     // if out of bounds, report that the end can't be found
-    if ( start_row > m_rowSize || start_column > m_columnSize )
+    if ( start_row >= m_rowSize || start_column >= m_columnSize )
     {
         return PATH_UNREACHABLE;
     }
+    const LayoutGrid<LAYOUT_POLICY> grid = Grid<LAYOUT_POLICY>(); // the padded grid in the layout's order
+    const MAZE_DATA_TYPE * cells = grid.cells;
+    const size_t startIndex = grid.Index( start_row, start_column ); // the index of the starting position
     // if the starting point is the exit, the number of spaces is 0
-    if ( GetPositionalData( start_row, start_column ) == MAZE_DATA_TYPE::EXIT )
+    if ( cells[startIndex] == MAZE_DATA_TYPE::EXIT )
     {
         return 0;
     }
+    // without an exit there is nothing to search for
+    if ( m_exits.empty() )
+    {
+        return PATH_UNREACHABLE;
+    }
+
+    using StackEntry = SearchWorkspace::StackEntry;
+
+    const NeighbourOffsets<FourWayNeighbourhood, LAYOUT_POLICY> neighbourOffsets( grid.rowCells ); // steps to the surrounding cells; the blocked border keeps these in bounds
+    static constexpr uint8_t MOVE_ORDER[] = { 0, 1, 3, 2 }; // tries the cell above, to the left, to the right, and below
+
+    const uint32_t base = workspace.NextDepthBase( grid.cellCount ); // the depth base of this search
+    uint32_t * bestDepth = workspace.m_bestDepth.data(); // the smallest depth each cell has been reached at, plus the base
+    ScratchVector<StackEntry> & stack = workspace.m_stack; // the cells still to expand
+    stack.clear();
+    const auto depthOf = [&]( const size_t index ) // the smallest depth a cell has been reached at, or the largest int if it hasn't been
+    {
+        return ( bestDepth[index] >= base ) ? static_cast<int>( bestDepth[index] - base ) : std::numeric_limits<int>::max();
+    };
+
+    bestDepth[startIndex] = base; // the starting position is 0 from itself
+    stack.push_back( { static_cast<uint32_t>( startIndex ), 0, ExitDistanceLowerBound( grid, startIndex ) } );
 
-    std::vector<std::vector<bool>> traversed( m_rowSize, std::vector<bool>( m_columnSize, false ) );  // holds the list of traversed spaces
+    int bestDistance = std::numeric_limits<int>::max(); // the shortest distance to an exit found so far
+    while ( !stack.empty() )
+    {
+        const StackEntry current = stack.back(); // the cell to expand
+        stack.pop_back();
 
-    traversed[start_row][start_column] = true; // the starting position is traversed
-    
-    std::vector<int> smallest_path; // holds the smallest paths
+        // skip cells that were reached at a smaller depth after being pushed, and branches that can't beat the best distance
+        if ( current.depth > depthOf( current.index ) || current.estimate >= bestDistance )
+        {
+            continue;
+        }
 
-    int numSteps = 0; // holds the number of steps traversed
+        ++result.cellsExpanded; // increase the number of steps
+        const int depth = current.depth + 1; // the depth of the surrounding points
 
-    AddValueToPathSizeVectorIfPositive( smallest_path, DepthFirstRecursion( start_row - 1, start_column, traversed, 0, numSteps ) );
-    AddValueToPathSizeVectorIfPositive( smallest_path, DepthFirstRecursion( start_row, start_column - 1, traversed, 0, numSteps ) );
-    AddValueToPathSizeVectorIfPositive( smallest_path, DepthFirstRecursion( start_row, start_column + 1, traversed, 0, numSteps ) );
-    AddValueToPathSizeVectorIfPositive( smallest_path, DepthFirstRecursion( start_row + 1, start_column, traversed, 0, numSteps ) );
+        StackEntry children[4]; // the neighbours worth exploring
+        size_t childCount = 0; // the number of neighbours worth exploring
+        for ( const uint8_t direction : MOVE_ORDER )
+        {
+            const size_t neighbourIndex = neighbourOffsets.Move( current.index, direction );
+            switch ( cells[neighbourIndex] )
+            {
+                case MAZE_DATA_TYPE::EXIT: // exit found, keep it if it is the shortest so far
+                {
+                    bestDistance = std::min( bestDistance, depth );
+                } break;
+                case MAZE_DATA_TYPE::BLOCKED: // blocked spaces can't reach the exit
+                {
+                } break;
+                default: // only continue through a space if this path reaches it sooner than before
+                {
+                    if ( depth < depthOf( neighbourIndex ) )
+                    {
+                        children[childCount++] = { static_cast<uint32_t>( neighbourIndex ), depth, depth + ExitDistanceLowerBound( grid, neighbourIndex ) };
+                    }
+                    else
+                    {
+                        result.counters.RevisitAvoided();
+                    }
+                } break;
+            }
+        }
 
-    std::cout << "Num Steps: " << numSteps << std::endl; // report the number of total steps taken
+        // push the most promising neighbour last so it is explored first; an insertion sort suits the four neighbours
+        for ( size_t child = 1; child < childCount; ++child )
+        {
+            for ( size_t position = child; position > 0 && children[position - 1].estimate < children[position].estimate; --position )
+            {
+                std::swap( children[position - 1], children[position] );
+            }
+        }
+        for ( size_t child = 0; child < childCount; ++child )
+        {
+            if ( children[child].estimate < bestDistance ) // the neighbour could still lead to a shorter path
+            {
+                bestDepth[children[child].index] = base + depth;
+                stack.push_back( children[child] );
+                result.counters.Enqueue();
+            }
+        }
+        result.peakFrontier = std::max( result.peakFrontier, stack.size() );
+    }
 
     // if there was no valid path, return -1
-    if ( smallest_path.empty() )
+    if ( bestDistance == std::numeric_limits<int>::max() )
     {
         return PATH_UNREACHABLE;
     }
 
-    // return the smallest path from the path list
-    return *std::min_element( smallest_path.cbegin(), smallest_path.cend() );
+    return bestDistance;
 }
 
 /** The recursive DFS function for determining the shortest path.
+    @note The blocked border around the maze stops the recursion at the edges, so no bounds check is needed.
 
-@param current_row The starting row of the current space to check.
-@param current_column The starting column of the current space to check.
-@param traversed The vector of currently traversed spaces.
+@param cells The padded grid, in the layout's order.
+@param current_index The cell index of the current space to check.
+@param traversed The stamps marking the currently traversed spaces.
+@param stamp The stamp of a traversed space in this search.
 @param nodesInPath, the number of nodes currently in the path.
-@param numSteps, the number of steps used.
+@param offsets, the steps to the cells a move reaches.
+@param result, receives the number of steps used and the deepest path.
 
 @return The shortest number of steps from this point on, or -1 if the point cannot reach an exit.
 */
-int Maze::DepthFirstRecursion( const size_t current_row, const size_t current_column, std::vector<std::vector<bool>>& traversed, const int nodesInPath, int & numSteps ) const
+template <typename NEIGHBOURHOOD_POLICY, typename LAYOUT_POLICY>
+int Maze::DepthFirstRecursion( const MAZE_DATA_TYPE * cells, const size_t current_index, uint32_t * traversed, const uint32_t stamp, const int nodesInPath, const NeighbourOffsets<NEIGHBOURHOOD_POLICY, LAYOUT_POLICY> & offsets, SearchResult & result ) const
 {
-    // if the point is outside of bounds, return -1
-    if ( current_row >= m_rowSize || current_column >= m_columnSize )
-    {
-        return PATH_UNREACHABLE;
-    }
-
     // if the point has been traversed, return -1
-    if ( traversed[current_row][current_column] )
+    if ( traversed[current_index] == stamp )
     {
+        result.counters.RevisitAvoided();
         return PATH_UNREACHABLE;
     }
 
-    ++numSteps; // increase the number of steps
+    ++result.cellsExpanded; // increase the number of steps
+    result.peakFrontier = std::max( result.peakFrontier, static_cast<size_t>( nodesInPath ) + 1 );
 
     // check the current space
-    switch ( GetPositionalData( current_row, current_column ) )
+    switch ( cells[current_index] )
     {
         case MAZE_DATA_TYPE::BLOCKED: // if blocked, this space won't be able to get to the exit
         {
-            traversed[current_row][current_column] = true; // only traverse this space once
+            traversed[current_index] = stamp; // only traverse this space once
             return PATH_UNREACHABLE;
         } break;
         case MAZE_DATA_TYPE::EXIT: // exit found, return the path size
@@ -271,35 +1474,32 @@ int Maze::DepthFirstRecursion( const size_t current_row, const size_t current_co
         } break;
     }
 
-    traversed[current_row][current_column] = true; // this space is traversed
+    traversed[current_index] = stamp; // this space is traversed
+    result.counters.Enqueue();
 
-    std::vector<int> smallest_path;
+    int shortest = PATH_UNREACHABLE; // the smallest path found through this space
 
-    AddValueToPathSizeVectorIfPositive( smallest_path, DepthFirstRecursion( current_row - 1, current_column, traversed, nodesInPath + 1, numSteps ) );
-    AddValueToPathSizeVectorIfPositive( smallest_path, DepthFirstRecursion( current_row, current_column - 1, traversed, nodesInPath + 1, numSteps ) );
-    AddValueToPathSizeVectorIfPositive( smallest_path, DepthFirstRecursion( current_row, current_column + 1, traversed, nodesInPath + 1, numSteps ) );
-    AddValueToPathSizeVectorIfPositive( smallest_path, DepthFirstRecursion( current_row + 1, current_column, traversed, nodesInPath + 1, numSteps ) );
-    
-    traversed[current_row][current_column] = false; // remove this space from the path
-
-    if ( smallest_path.empty() ) // if there is no path, return -1
+    VisitNeighbours( cells, current_index, offsets, [&]( const uint8_t, const size_t neighbourIndex )
     {
-        return PATH_UNREACHABLE;
-    }
+        KeepShortestPath( shortest, DepthFirstRecursion( cells, neighbourIndex, traversed, stamp, nodesInPath + 1, offsets, result ) );
+        return false;
+    } );
 
-    return *std::min_element( smallest_path.cbegin(), smallest_path.cend() ); // return the minimum path size
+    traversed[current_index] = 0; // remove this space from the path; no search is stamped 0
+
+    return shortest; // return the minimum path size, or -1 if there is no path
 }
 
-/** Helper function for pushing only positive non-zero values into a vector.
+/** Helper function for keeping the smallest positive non-zero path size, so no recursion frame needs a list of them.
 
-@param pathSizes the path vector to add positive non-zero values to.
+@param shortest the smallest path size so far, or -1 if there is none yet.
 @param value the value to check
 */
-void Maze::AddValueToPathSizeVectorIfPositive( std::vector<int>& pathSizes, const int value ) const
+void Maze::KeepShortestPath( int & shortest, const int value ) const
 {
-    if ( value > 0 )
+    if ( value > 0 && ( shortest == PATH_UNREACHABLE || value < shortest ) )
     {
-        pathSizes.push_back( value );
+        shortest = value;
     }
 }
 
@@ -321,40 +1521,233 @@ size_t Maze::GetColumnSize() const
     return m_columnSize;
 }
 
+/** Sets the maximum number of bytes a loaded maze may occupy: the padded grid and the indexes built with it on every
+    load (the component labels, the bit planes, and the copy in a blocked layout). Mazes that would need more are
+    rejected by LoadMaze, and a layout copy that would pass the limit isn't made, leaving the searches on the rows.
+    What is built or allocated later isn't counted: the distance field and hierarchy, which grow with the maze when
+    built, the list of exits, and the buffers of every search, which each take several bytes a cell per workspace.
+
+@param bytes The memory limit in bytes.
+*/
+void Maze::SetMemoryLimit( const size_t bytes )
+{
+    m_memoryLimit = bytes;
+}
+
+/** Retrieves the maximum number of bytes a loaded maze and its indexes may occupy.
+
+@return the memory limit in bytes.
+*/
+size_t Maze::GetMemoryLimit() const
+{
+    return m_memoryLimit;
+}
+
+/** Sets the moves the searches may make.
+    Breadth first search, depth first search, Dijkstra's algorithm, the bidirectional and parallel searches, and
+    MinimumPath search with the neighbourhood; the other searches are answered with breadth first search when it
+    has diagonal moves.
+
+@param neighbourhood The moves to search with.
+*/
+void Maze::SetNeighbourhood( const NEIGHBOURHOOD neighbourhood )
+{
+    if ( m_neighbourhood != neighbourhood )
+    {
+        m_neighbourhood = neighbourhood;
+        AdvanceGeneration();
+    }
+}
+
+/** Retrieves the moves the searches may make.
+
+@return the neighbourhood searched with.
+*/
+Maze::NEIGHBOURHOOD Maze::GetNeighbourhood() const
+{
+    return m_neighbourhood;
+}
+
+/** Retrieves the generation of the maze, which changes whenever a search could give a different answer:
+    on every load, SetCell, and SetNeighbourhood, and when the distance field or hierarchy is built.
+    Generations are unique across every Maze, so an answer tagged with one can't be mistaken for another maze's.
+
+@return the current generation.
+*/
+uint64_t Maze::GetGeneration() const
+{
+    return m_generation;
+}
+
+/** Gives the maze a new generation after a change that could alter answers.
+*/
+void Maze::AdvanceGeneration()
+{
+    m_generation = s_lastGeneration.fetch_add( 1, std::memory_order_relaxed ) + 1;
+}
+
 /** Prints the maze to std output.
+
+@param path The row and column of every space on a route to overlay, as MinimumPath gives it; the start is shown as
+    'S' and the clear spaces along the way as '*'.
 */
-void Maze::PrintMaze() const
+void Maze::PrintMaze( const std::vector<std::pair<size_t, size_t>> & path ) const
 {
     if ( !MazeLoaded() )
     {
         std::cout << "Error: Maze not in a valid state." << std::endl;
     }
+    std::vector<std::string> lines( m_rowSize, std::string( m_columnSize, '?' ) ); // the printed rows
     for ( size_t row = 0; row < m_rowSize; ++row )
     {
         for ( size_t column = 0; column < m_columnSize; ++column )
         {
-            switch ( GetPositionalData( row, column ) )
+            const MAZE_DATA_TYPE cell = GetPositionalData( row, column );
+            switch ( cell )
             {
                 case MAZE_DATA_TYPE::BLOCKED:
                 {
-                    std::cout << 'B';
+                    lines[row][column] = 'B';
                 } break;
                 case MAZE_DATA_TYPE::CLEAR:
                 {
-                    std::cout << '.';
+                    lines[row][column] = '.';
                 } break;
                 case MAZE_DATA_TYPE::EXIT:
                 {
-                    std::cout << 'X';
+                    lines[row][column] = 'X';
                 } break;
-                default:
+                default: // terrain is shown as its move cost
                 {
-                    std::cout << '?';
+                    if ( IsTerrain( cell ) )
+                    {
+                        lines[row][column] = static_cast<char>( '0' + static_cast<int>( cell ) );
+                    }
                 } break;
             }
         }
-        std::cout << '\n';
     }
+    for ( size_t step = 0; step < path.size(); ++step )
+    {
+        const std::pair<size_t, size_t> & space = path[step];
+        if ( space.first < m_rowSize && space.second < m_columnSize && lines[space.first][space.second] == '.' )
+        {
+            lines[space.first][space.second] = ( step == 0 ) ? 'S' : '*';
+        }
+    }
+    for ( const std::string & line : lines )
+    {
+        std::cout << line << '\n';
+    }
+}
+
+/** Retrieves the number of heap allocations search buffers have made on the calling thread.
+    A workspace that keeps answering queries of the same maze stops adding to it after its first search.
+
+@return the allocation count.
+*/
+uint64_t SearchWorkspace::GetAllocationCount()
+{
+    return ScratchAllocationCount();
+}
+
+/** Starts a search, resetting every stamped per-cell array in constant time.
+    A cell's entry belongs to the new search only once the search stamps it, so nothing from an earlier search is
+    ever read. The arrays are only cleared when the stamp wraps around, once every four billion searches.
+
+@return The stamp of the new search, never 0.
+*/
+uint32_t SearchWorkspace::NextStamp()
+{
+    if ( ++m_stamp == 0 ) // the stamp wrapped, so forget every stamp handed out before
+    {
+        std::fill( m_cellStamps.begin(), m_cellStamps.end(), 0 );
+        for ( ScratchVector<StampedValue> * values : { &m_distances, &m_reverseDistances } )
+        {
+            std::fill( values->begin(), values->end(), StampedValue{ 0, 0 } );
+        }
+        m_stamp = 1;
+    }
+    return m_stamp;
+}
+
+/** Starts a search that records the smallest depth it reaches every cell at, resetting the depths in constant time.
+    Depths are stored offset by a base that moves past every depth of the previous search, so the stale entries all
+    read as unreached while each entry stays 4 bytes, half the size of a stamped value, which the deep searches of a
+    large maze notice. The depths are only cleared when the bases run out, once every four billion cells searched.
+
+@param cellCount The number of cells in the padded grid being searched, which no depth can reach.
+
+@return The depth base of the new search: an entry below it is unreached, and any other holds the base plus the depth.
+*/
+uint32_t SearchWorkspace::NextDepthBase( const size_t cellCount )
+{
+    m_bestDepth.resize( cellCount, 0 );
+    if ( m_nextDepthBase > std::numeric_limits<uint32_t>::max() - cellCount ) // the bases ran out, so forget every depth written before
+    {
+        std::fill( m_bestDepth.begin(), m_bestDepth.end(), 0 );
+        m_nextDepthBase = 1;
+    }
+    const uint32_t base = m_nextDepthBase; // the base of the new search
+    m_nextDepthBase += static_cast<uint32_t>( cellCount );
+    return base;
+}
+
+/** Records the direction a cell was reached in for a path recording search.
+    BITS is 2 for four-way searches and 4 once there are diagonal moves.
+
+@param index The index of the cell.
+@param direction The direction of the move into the cell: 0 up, 1 left, 2 down, 3 right, then the diagonals up-left, up-right, down-left, and down-right.
+*/
+template <unsigned BITS>
+void SearchWorkspace::SetParent( const size_t index, const uint8_t direction )
+{
+    constexpr size_t CELLS_PER_BYTE = 8 / BITS; // the number of directions packed into each byte
+    constexpr unsigned MASK = ( 1u << BITS ) - 1; // the bits of one direction
+    const unsigned shift = static_cast<unsigned>( index % CELLS_PER_BYTE ) * BITS; // the position of the cell's bits within its byte
+    uint8_t & packed = m_parents[index / CELLS_PER_BYTE];
+    packed = static_cast<uint8_t>( ( packed & ~( MASK << shift ) ) | ( static_cast<unsigned>( direction ) << shift ) );
+}
+
+template void SearchWorkspace::SetParent<2>( const size_t index, const uint8_t direction );
+template void SearchWorkspace::SetParent<4>( const size_t index, const uint8_t direction );
+
+/** Retrieves the direction a cell was reached in by a path recording search.
+
+@param index The index of the cell.
+
+@return The direction of the move into the cell, numbered as for SetParent.
+*/
+template <unsigned BITS>
+uint8_t SearchWorkspace::GetParent( const size_t index ) const
+{
+    constexpr size_t CELLS_PER_BYTE = 8 / BITS; // the number of directions packed into each byte
+    constexpr unsigned MASK = ( 1u << BITS ) - 1; // the bits of one direction
+    return static_cast<uint8_t>( ( m_parents[index / CELLS_PER_BYTE] >> ( ( index % CELLS_PER_BYTE ) * BITS ) ) & MASK );
+}
+
+template uint8_t SearchWorkspace::GetParent<2>( const size_t index ) const;
+template uint8_t SearchWorkspace::GetParent<4>( const size_t index ) const;
+
+/** Retrieves the padded grid, either from memory or in place from a mapped binary maze file.
+
+@return A pointer to the first cell of the padded grid.
+*/
+const Maze::MAZE_DATA_TYPE * Maze::Cells() const
+{
+    return ( m_mappedCells != nullptr ) ? m_mappedCells : m_mapData.data();
+}
+
+/** Converts a maze position into an index of the padded grid.
+
+@param row The row of the position.
+@param column The column of the position.
+
+@return The index of the position within the padded grid.
+*/
+size_t Maze::CellIndex( const size_t row, const size_t column ) const
+{
+    return ( row + 1 ) * m_stride + ( column + 1 );
 }
 
 /** Retrieves the value set in the maze at the position.
@@ -369,7 +1762,19 @@ Maze::MAZE_DATA_TYPE Maze::GetPositionalData( const size_t row, const size_t col
         throw std::runtime_error( "Cannot get positional data where row or column exceeds size." );
     }
 
-    return m_mapData[row][column];
+    return Cells()[CellIndex( row, column )];
+}
+
+/** Checks whether a cell type is terrain.
+
+@param type The cell type to check.
+
+@retval true if the type is passable terrain costing more than one move to enter.
+@retval false if the type is clear, blocked, or an exit.
+*/
+bool Maze::IsTerrain( const MAZE_DATA_TYPE type )
+{
+    return type >= MAZE_DATA_TYPE::FIRST_TERRAIN && type <= MAZE_DATA_TYPE::LAST_TERRAIN;
 }
 
 /** Sets the position in the maze to be a specific value.
@@ -383,19 +1788,30 @@ Maze::MAZE_DATA_TYPE Maze::GetPositionalData( const size_t row, const size_t col
 */
 bool Maze::SetPositionalData( const size_t row, const size_t column, const char value )
 {
+    const size_t index = CellIndex( row, column ); // the index of the position within the padded grid
     switch ( value )
     {
         case '0':
         {
-            m_mapData[row][column] = MAZE_DATA_TYPE::CLEAR;
+            m_mapData[index] = MAZE_DATA_TYPE::CLEAR;
         } break;
         case '1':
         {
-            m_mapData[row][column] = MAZE_DATA_TYPE::BLOCKED;
+            m_mapData[index] = MAZE_DATA_TYPE::BLOCKED;
         } break;
         case '2':
         {
-            m_mapData[row][column] = MAZE_DATA_TYPE::EXIT;
+            m_mapData[index] = MAZE_DATA_TYPE::EXIT;
+        } break;
+        case '3': //intentional fallthrough
+        case '4': //intentional fallthrough
+        case '5': //intentional fallthrough
+        case '6': //intentional fallthrough
+        case '7': //intentional fallthrough
+        case '8': //intentional fallthrough
+        case '9': // terrain costing its digit to enter
+        {
+            m_mapData[index] = static_cast<MAZE_DATA_TYPE>( value - '0' );
         } break;
         default:
         {
@@ -406,25 +1822,257 @@ bool Maze::SetPositionalData( const size_t row, const size_t column, const char
     return true;
 }
 
+/** Builds the indexes the searches use from the grid.
+*/
+void Maze::BuildIndexes()
+{
+    IndexExits();
+    BuildBitGrid();
+    LabelComponents();
+    BuildLayoutGrid();
+}
+
+/** Records the position of every exit in the maze, and counts the terrain cells.
+*/
+void Maze::IndexExits()
+{
+    m_exits.clear();
+    m_terrainCells = 0;
+    const MAZE_DATA_TYPE * cells = Cells(); // the padded grid
+    for ( size_t row = 1; row <= m_rowSize; ++row )
+    {
+        for ( size_t column = 1; column <= m_columnSize; ++column )
+        {
+            const MAZE_DATA_TYPE cell = cells[row * m_stride + column];
+            if ( cell == MAZE_DATA_TYPE::EXIT )
+            {
+                m_exits.push_back( { row, column } );
+            }
+            else if ( IsTerrain( cell ) )
+            {
+                ++m_terrainCells;
+            }
+        }
+    }
+}
+
+/** Packs the grid into the bit planes used by the bit-parallel breadth first search.
+*/
+void Maze::BuildBitGrid()
+{
+    m_bitGrid.Reset( m_rowSize, m_columnSize );
+    const MAZE_DATA_TYPE * cells = Cells(); // the padded grid
+    for ( size_t row = 0; row < m_rowSize; ++row )
+    {
+        for ( size_t column = 0; column < m_columnSize; ++column )
+        {
+            const MAZE_DATA_TYPE cell = cells[CellIndex( row, column )];
+            m_bitGrid.SetCell( row, column, cell != MAZE_DATA_TYPE::BLOCKED, cell == MAZE_DATA_TYPE::EXIT );
+        }
+    }
+}
+
+/** Labels the connected regions of clear and exit cells with a two pass scanline labelling.
+    The first pass gives each cell the label of the cell above or to the left of it, joining the two labels in a
+    union-find when they differ, and the second pass replaces every label with a dense id for its region.
+    Each region also records whether it holds an exit, so a start in a region without one is answered without searching.
+*/
+void Maze::LabelComponents()
+{
+    const MAZE_DATA_TYPE * cells = Cells(); // the padded grid
+    m_componentLabels.assign( m_cellCount, NO_COMPONENT );
+    std::vector<uint32_t> parents; // the union-find parent of every provisional label; roots are the smallest label of their set
+
+    const auto findRoot = [&parents]( uint32_t label )
+    {
+        while ( parents[label] != label )
+        {
+            parents[label] = parents[parents[label]]; // path halving
+            label = parents[label];
+        }
+        return label;
+    };
+
+    for ( size_t row = 1; row <= m_rowSize; ++row )
+    {
+        for ( size_t index = row * m_stride + 1; index <= row * m_stride + m_columnSize; ++index )
+        {
+            if ( cells[index] == MAZE_DATA_TYPE::BLOCKED )
+            {
+                continue;
+            }
+            const uint32_t above = m_componentLabels[index - m_stride]; // the border keeps these in bounds
+            const uint32_t left = m_componentLabels[index - 1];
+            if ( above == NO_COMPONENT && left == NO_COMPONENT ) // the first cell seen of what may be a new region
+            {
+                m_componentLabels[index] = static_cast<uint32_t>( parents.size() );
+                parents.push_back( m_componentLabels[index] );
+            }
+            else if ( above == NO_COMPONENT || left == NO_COMPONENT )
+            {
+                m_componentLabels[index] = std::min( above, left );
+            }
+            else
+            {
+                const uint32_t aboveRoot = findRoot( above );
+                const uint32_t leftRoot = findRoot( left );
+                parents[std::max( aboveRoot, leftRoot )] = std::min( aboveRoot, leftRoot );
+                m_componentLabels[index] = std::min( aboveRoot, leftRoot );
+            }
+        }
+    }
+
+    // roots are smaller than every label in their set, so a single ascending pass can number the regions densely
+    uint32_t componentCount = 0; // the number of regions found
+    for ( uint32_t label = 0; label < parents.size(); ++label )
+    {
+        parents[label] = ( parents[label] == label ) ? componentCount++ : parents[parents[label]];
+    }
+    m_componentHasExit.assign( componentCount, false );
+    for ( size_t index = 0; index < m_cellCount; ++index )
+    {
+        if ( m_componentLabels[index] != NO_COMPONENT )
+        {
+            m_componentLabels[index] = parents[m_componentLabels[index]];
+            if ( cells[index] == MAZE_DATA_TYPE::EXIT )
+            {
+                m_componentHasExit[m_componentLabels[index]] = true;
+            }
+        }
+    }
+}
+
+/** Checks whether a start lies in a region of the maze that holds no exit.
+    Invalid and blocked starts are left for the searches to handle. The regions are those of four-way moves, which
+    diagonal moves that don't cut corners never leave; moves that cut corners can, so they are never ruled out here.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+
+@retval true if the start is a clear cell with no exit reachable from it.
+@retval false otherwise.
+*/
+bool Maze::ExitUnreachable( const size_t start_row, const size_t start_column ) const
+{
+    if ( start_row >= m_rowSize || start_column >= m_columnSize || m_neighbourhood == NEIGHBOURHOOD::EIGHT_WAY )
+    {
+        return false;
+    }
+    const uint32_t component = m_componentLabels[CellIndex( start_row, start_column )]; // the region of the start
+    return component != NO_COMPONENT && !m_componentHasExit[component];
+}
+
+/** Estimates the distance from a cell to the nearest exit without ever overestimating it.
+    Uses the Manhattan distance to the closest exit, or 0 when there are too many exits to check cheaply.
+
+@param index The padded grid index of the cell to estimate from.
+
+@return A lower bound on the number of spaces from the cell to the nearest exit.
+*/
+int Maze::ExitDistanceLowerBound( const size_t index ) const
+{
+    return ExitDistanceLowerBound( Grid<RowMajorLayout>(), index );
+}
+
+/** Estimates the distance from a cell of a layout's grid to the nearest exit without ever overestimating it.
+    Uses the Manhattan distance to the closest exit, or 0 when there are too many exits to check cheaply.
+
+@param grid The grid the index is in.
+@param index The cell index to estimate from.
+
+@return A lower bound on the number of spaces from the cell to the nearest exit.
+*/
+template <typename LAYOUT_POLICY>
+int Maze::ExitDistanceLowerBound( const LayoutGrid<LAYOUT_POLICY> & grid, const size_t index ) const
+{
+    if ( m_exits.size() > MAX_HEURISTIC_EXITS )
+    {
+        return 0;
+    }
+    const size_t row = grid.Row( index ); // the padded row of the cell
+    const size_t column = grid.Column( index ); // the padded column of the cell
+    size_t lowerBound = std::numeric_limits<size_t>::max(); // the distance to the closest exit
+    for ( const std::pair<size_t, size_t> & exit : m_exits )
+    {
+        const size_t rowDistance = ( row > exit.first ) ? row - exit.first : exit.first - row;
+        const size_t columnDistance = ( column > exit.second ) ? column - exit.second : exit.second - column;
+        lowerBound = std::min( lowerBound, rowDistance + columnDistance );
+    }
+    return static_cast<int>( lowerBound );
+}
+
+template int Maze::ExitDistanceLowerBound<RowMajorLayout>( const LayoutGrid<RowMajorLayout> & grid, const size_t index ) const;
+template int Maze::ExitDistanceLowerBound<TiledLayout>( const LayoutGrid<TiledLayout> & grid, const size_t index ) const;
+template int Maze::ExitDistanceLowerBound<MortonLayout>( const LayoutGrid<MortonLayout> & grid, const size_t index ) const;
+
+/** Works out the memory a maze of the given size occupies once loaded: the padded grid, the component label of every
+    padded cell, and the bit planes. The copy in a blocked layout is counted by BuildLayoutGrid.
+
+@param rows The number of rows in the maze.
+@param columns The number of columns in the maze.
+
+@return The bytes of the grid and its indexes.
+*/
+size_t Maze::LoadedBytes( const size_t rows, const size_t columns )
+{
+    const size_t paddedCells = ( rows + 2 ) * ( columns + 2 ); // the cells including the border
+    return paddedCells * ( sizeof( MAZE_DATA_TYPE ) + sizeof( uint32_t ) ) + BitGrid::PlaneBytes( rows, columns ); // a cell and its component label
+}
+
+/** Checks that a maze of the given size fits within the memory limit, counting the indexes built on load.
+    The padded grid must also be addressable with 32-bit cell indices.
+
+@param rows The number of rows in the maze.
+@param columns The number of columns in the maze.
+
+@retval true if the maze can be allocated.
+@retval false if the maze is too large.
+*/
+bool Maze::FitsMemoryLimit( const size_t rows, const size_t columns ) const
+{
+    const size_t maxCells = std::numeric_limits<uint32_t>::max(); // the largest padded grid 32-bit indices address
+    if ( rows > maxCells || columns > maxCells ) // also keeps the padding from overflowing
+    {
+        return false;
+    }
+    const size_t paddedRows = rows + 2; // the rows including the top and bottom border
+    const size_t paddedColumns = columns + 2; // the columns including the left and right border
+    return paddedColumns <= maxCells / paddedRows && LoadedBytes( rows, columns ) <= m_memoryLimit;
+}
+
 /** Clears the maze data from the object.
 */
 void Maze::ClearMaze()
 {
+    AdvanceGeneration();
     m_rowSize = 0;
     m_columnSize = 0;
+    m_stride = 0;
+    m_cellCount = 0;
     m_mapData.clear();
+    m_mappedFile.reset();
+    m_mappedCells = nullptr;
+    m_distanceField.clear();
+    m_exits.clear();
+    m_terrainCells = 0;
+    m_componentLabels.clear();
+    m_componentHasExit.clear();
+    m_regionMarks.clear();
+    m_layoutCells.clear();
+    m_layoutRowCells = 0;
+    ClearHierarchy();
 }
 
 /** Sets up the internal data structure for maze data.
+    The grid is a single row-major allocation with a one cell BLOCKED border on every side,
+    so searches can step to any neighbour of a maze cell without a bounds check.
 
 @param rows The number of rows in the maze.
 @param columns The number of columns in the maze.
 */
 void Maze::ReallocateMaze( const size_t rows, const size_t columns )
 {
-    m_mapData.resize( rows );
-    for ( size_t row = 0; row < rows; ++row )
-    {
-        m_mapData[row].resize( columns );
-    }
+    m_stride = columns + 2;
+    m_cellCount = ( rows + 2 ) * m_stride;
+    m_mapData.assign( m_cellCount, MAZE_DATA_TYPE::BLOCKED );
 }
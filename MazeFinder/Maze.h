@@ -2,41 +2,313 @@
 #ifndef __MAZE_H
 #define __MAZE_H
 
+#include "BitGrid.h"
+#include "Instrumentation.h"
+#include "ScratchAllocator.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
+class MappedFile;
+class ThreadPool;
+struct FourWayNeighbourhood;
+struct RowMajorLayout;
+template <typename LAYOUT_POLICY> struct LayoutGrid;
+template <typename NEIGHBOURHOOD_POLICY, typename LAYOUT_POLICY = RowMajorLayout> struct NeighbourOffsets;
+
+/** The outcome of a Maze search.
+*/
+struct SearchResult
+{
+    int distance{ -1 }; ///< The minimum number of spaces to the nearest exit, or -1 if none could be reached or the start was invalid.
+    SearchCounters counters; ///< The enqueues and avoided revisits, counted only in instrumented builds and empty otherwise.
+    size_t cellsExpanded{ 0 }; ///< The cells the search expanded; the bit-parallel search counts the layers it expanded, and jump point search the jump points.
+    size_t peakFrontier{ 0 }; ///< The most cells the queue or stack held, or the deepest the recursion went; the bit-parallel search counts frontier words.
+    std::chrono::nanoseconds elapsed{ 0 }; ///< How long the search took.
+};
+
+/** Scratch buffers for the Maze searches.
+    The buffers grow to the size of the maze on first use and keep their capacity between searches, and the per-cell
+    arrays are reset by advancing a stamp rather than by clearing them, so a workspace reused for many queries of the
+    same maze neither allocates nor touches more cells than each search visits. Every buffer is allocated through
+    ScratchAllocator, so GetAllocationCount shows whether that holds.
+    A workspace may only be used by one search at a time.
+*/
+class SearchWorkspace
+{
+    public:
+        SearchWorkspace() = default;
+        SearchWorkspace( SearchWorkspace && ) = default;
+        SearchWorkspace & operator=( SearchWorkspace && ) = default;
+        ~SearchWorkspace() = default;
+        static uint64_t GetAllocationCount();
+
+    private:
+        friend class Maze;
+
+        struct StampedValue
+        {
+            uint32_t stamp; ///< The search that wrote the value; any other stamp means the cell hasn't been reached yet.
+            int value; ///< The distance or cost of the cell, kept beside its stamp so checking a cell reads one cache line.
+        };
+
+        struct StackEntry
+        {
+            uint32_t index; ///< The cell to expand.
+            int depth; ///< The depth the cell was reached at.
+            int estimate; ///< The smallest distance to an exit a path through the cell could have.
+        };
+
+        struct JumpEntry
+        {
+            uint32_t index; ///< The jump point to expand.
+            int depth; ///< The depth the jump point was reached at.
+            int estimate; ///< The smallest distance to an exit a path through the jump point could have.
+            uint8_t direction; ///< The direction the jump point was reached in, or JUMP_FROM_START.
+        };
+
+        struct AbstractEntry
+        {
+            uint32_t node; ///< The hierarchy node to expand, or NO_NODE for the nearest exit itself.
+            int cost; ///< The distance the node was reached at.
+            int estimate; ///< The smallest distance to an exit a path through the node could have.
+        };
+
+        /** The frontier cells one worker of the parallel search found, and the cursor every worker claims them through.
+            The worker's enqueues and avoided revisits are counted in its SearchCounters base, which takes no space unless the
+            build is instrumented, so the frontier still fits the one 64 byte cache line it is aligned to.
+        */
+        struct alignas( 64 ) WorkerFrontier : SearchCounters
+        {
+            ScratchVector<uint32_t> levels[2]; ///< The cells of the level being expanded and of the next level, swapping roles every level.
+            std::atomic<size_t> cursor{ 0 }; ///< The first unclaimed cell of the level being expanded.
+            size_t cellsExpanded{ 0 }; ///< The cells this worker expanded.
+        };
+
+        uint32_t NextStamp();
+        uint32_t NextDepthBase( const size_t cellCount );
+        template <unsigned BITS> void SetParent( const size_t index, const uint8_t direction );
+        template <unsigned BITS> uint8_t GetParent( const size_t index ) const;
+
+        uint32_t m_stamp{ 0 }; ///< The stamp of the latest search, carried across searches so the stamped arrays never need clearing.
+        ScratchVector<uint32_t> m_cellStamps; ///< The search that last visited every cell, for the searches that only need to know whether a cell was reached.
+        ScratchVector<StampedValue> m_distances; ///< The distance or move cost of every cell from the start.
+        ScratchVector<uint32_t> m_frontier; ///< The breadth first search queue of cell indices.
+        ScratchVector<StampedValue> m_reverseDistances; ///< The bidirectional breadth first search distance of every cell from the goal.
+        ScratchVector<uint32_t> m_reverseFrontier; ///< The bidirectional breadth first search queue growing from the goal.
+        ScratchVector<uint32_t> m_bestDepth; ///< The smallest depth the iterative depth first search and A* reached every cell at, plus the search's depth base.
+        uint32_t m_nextDepthBase{ 1 }; ///< The depth base of the next search; every depth written so far is below it, so it reads as unreached.
+        ScratchVector<StackEntry> m_stack; ///< The cells the iterative depth first search still has to expand.
+        ScratchVector<StackEntry> m_openBuckets[3]; ///< The A* open list, bucketed by estimate modulo 3.
+        ScratchVector<int> m_jumpDepth; ///< The smallest depth jump point search reached every cell at, per direction of arrival, where stamped.
+        ScratchVector<JumpEntry> m_jumpHeap; ///< The jump point search open list, as a min-heap on the estimate.
+        BitGridWorkspace m_bitGrid; ///< The planes for the bit-parallel breadth first search.
+        ScratchVector<int> m_clusterDistances; ///< The distance of every cell of the start's cluster from the start.
+        ScratchVector<uint32_t> m_clusterQueue; ///< The breadth first search queue within the start's cluster.
+        ScratchVector<int> m_nodeCosts; ///< The smallest distance each hierarchy node has been reached at, valid where the stamp matches.
+        ScratchVector<uint32_t> m_nodeStamps; ///< The search each entry of m_nodeCosts was written by.
+        uint32_t m_nodeStamp{ 0 }; ///< The stamp of the latest hierarchical search, carried across searches so m_nodeStamps never needs clearing.
+        ScratchVector<AbstractEntry> m_abstractHeap; ///< The hierarchical search open list, as a min-heap on the estimate.
+        ScratchVector<uint8_t> m_parents; ///< The direction every cell was last reached in, 2 bits per cell or 4 with diagonal moves, written only by searches recording a path.
+        uint32_t m_pathEnd{ 0 }; ///< The exit a path recording search stopped at.
+        ScratchVector<ScratchVector<uint32_t>> m_costBuckets; ///< The Dijkstra open list, a ring of buckets indexed by path cost modulo the ring size.
+        ScratchVector<std::atomic<uint64_t>> m_visitedWords; ///< The parallel search's visited bitmap, one bit per cell, cleared by each search for the cells it covers.
+        ScratchVector<WorkerFrontier> m_workerFrontiers; ///< The frontier of every worker of the parallel search's pool; each worker grows its own buffers, on its own thread.
+};
+
 class Maze
 {
     public:
+        static constexpr size_t DEFAULT_MEMORY_LIMIT = static_cast<size_t>( 1 ) << 30; ///< The default number of bytes a loaded maze and its indexes may occupy.
+        static constexpr size_t DEFAULT_CLUSTER_SIZE = 16; ///< The default width and height of a hierarchy cluster.
+        static constexpr int PATH_UNREACHABLE = -1; ///< The distance answered when no exit can be reached or the start is invalid.
+
+        enum class BINARY_ENCODING : uint8_t
+        {
+            PADDED_BYTES=0, ///< One byte per cell including the border, searched in place without copying.
+            PACKED_2BIT=1 ///< Two bits per maze cell, decoded into memory on load.
+        };
+
+        enum class MAZE_DATA_TYPE : char
+        {
+            CLEAR=0,
+            BLOCKED=1,
+            EXIT=2,
+            FIRST_TERRAIN=3, ///< Slow terrain costing 3 moves to enter; every value up to LAST_TERRAIN is terrain costing its value.
+            LAST_TERRAIN=9 ///< The slowest terrain, costing 9 moves to enter.
+        };
+
+        enum class SEARCH_ALGORITHM : uint8_t
+        {
+            BFS=0, ///< MinimumNumberOfSpacesBFS.
+            DFS=1, ///< MinimumNumberOfSpacesDFS.
+            ITERATIVE_DFS=2, ///< MinimumNumberOfSpacesIterativeDFS.
+            BIT_PARALLEL_BFS=3, ///< MinimumNumberOfSpacesBitParallelBFS.
+            DISTANCE_FIELD=4, ///< MinimumNumberOfSpacesDistanceField.
+            A_STAR=5, ///< MinimumNumberOfSpacesAStar.
+            JUMP_POINT=6, ///< MinimumNumberOfSpacesJumpPoint.
+            HIERARCHICAL=7, ///< MinimumNumberOfSpacesHierarchical with exact distances.
+            HIERARCHICAL_APPROXIMATE=8, ///< MinimumNumberOfSpacesHierarchical with near-optimal distances.
+            DIJKSTRA=9 ///< MinimumMoveCostDijkstra.
+        };
+
+        enum class NEIGHBOURHOOD : uint8_t
+        {
+            FOUR_WAY=0, ///< Moves up, down, left, and right.
+            EIGHT_WAY=1, ///< Also moves diagonally, even past blocked corners.
+            EIGHT_WAY_NO_CORNER_CUTTING=2 ///< Also moves diagonally, but only where both cells beside the move are passable.
+        };
+
+        enum class GRID_LAYOUT : uint8_t
+        {
+            ROW_MAJOR=0, ///< Searches the padded grid itself, one row after another.
+            TILED=1, ///< Searches a copy stored in 8 by 8 tiles, a cache line each.
+            MORTON=2 ///< Searches a copy stored in 64 by 64 blocks, a page each, in Z-order.
+        };
+
         Maze() = default;
         ~Maze() = default;
         bool LoadMaze( const std::string & filename );
+        bool LoadMazeFromText( const std::string & text );
+        bool SaveBinaryMaze( const std::string & filename, const BINARY_ENCODING encoding ) const;
         bool MazeLoaded() const;
-        int MinimumNumberOfSpacesBFS( const size_t start_row, const size_t start_column ) const;
-        int MinimumNumberOfSpacesDFS( const size_t start_row, const size_t start_column ) const;
+        bool SetCell( const size_t row, const size_t column, const MAZE_DATA_TYPE type );
+        SearchResult MinimumNumberOfSpaces( const size_t start_row, const size_t start_column, const SEARCH_ALGORITHM algorithm ) const;
+        SearchResult MinimumNumberOfSpaces( const size_t start_row, const size_t start_column, const SEARCH_ALGORITHM algorithm, SearchWorkspace & workspace ) const;
+        SearchResult MinimumNumberOfSpacesBFS( const size_t start_row, const size_t start_column ) const;
+        SearchResult MinimumNumberOfSpacesDFS( const size_t start_row, const size_t start_column ) const;
+        SearchResult MinimumNumberOfSpacesIterativeDFS( const size_t start_row, const size_t start_column ) const;
+        SearchResult MinimumNumberOfSpacesBitParallelBFS( const size_t start_row, const size_t start_column ) const;
+        SearchResult MinimumNumberOfSpacesParallelBFS( const size_t start_row, const size_t start_column, ThreadPool & pool ) const;
+        SearchResult MinimumNumberOfSpacesParallelBFS( const size_t start_row, const size_t start_column, ThreadPool & pool, SearchWorkspace & workspace ) const;
+        SearchResult MinimumNumberOfSpacesAStar( const size_t start_row, const size_t start_column ) const;
+        SearchResult MinimumNumberOfSpacesJumpPoint( const size_t start_row, const size_t start_column ) const;
+        SearchResult MinimumMoveCostDijkstra( const size_t start_row, const size_t start_column ) const;
+        bool HasTerrain() const;
+        SearchResult MinimumPath( const size_t start_row, const size_t start_column, const SEARCH_ALGORITHM algorithm, std::vector<std::pair<size_t, size_t>> & path ) const;
+        SearchResult MinimumPath( const size_t start_row, const size_t start_column, const SEARCH_ALGORITHM algorithm, std::vector<std::pair<size_t, size_t>> & path, SearchWorkspace & workspace ) const;
+        static std::string EncodePath( const std::vector<std::pair<size_t, size_t>> & path );
+        SearchResult MinimumNumberOfSpacesBetween( const size_t start_row, const size_t start_column, const size_t goal_row, const size_t goal_column ) const;
+        SearchResult MinimumNumberOfSpacesBetween( const size_t start_row, const size_t start_column, const size_t goal_row, const size_t goal_column, SearchWorkspace & workspace ) const;
+        void BuildDistanceField();
+        bool DistanceFieldBuilt() const;
+        SearchResult MinimumNumberOfSpacesDistanceField( const size_t start_row, const size_t start_column ) const;
+        void BuildHierarchy( ThreadPool & pool, const size_t clusterSize = DEFAULT_CLUSTER_SIZE );
+        bool HierarchyBuilt() const;
+        SearchResult MinimumNumberOfSpacesHierarchical( const size_t start_row, const size_t start_column, const bool exact ) const;
+        std::vector<int> MinimumNumberOfSpacesBatch( const std::vector<std::pair<size_t, size_t>> & starts, const SEARCH_ALGORITHM algorithm, ThreadPool & pool ) const;
+        std::vector<int> MinimumNumberOfSpacesBatch( const std::vector<std::pair<size_t, size_t>> & starts, const SEARCH_ALGORITHM algorithm, ThreadPool & pool, std::vector<SearchWorkspace> & workspaces ) const;
         size_t GetRowSize() const;
         size_t GetColumnSize() const;
-        void PrintMaze() const;
+        void SetMemoryLimit( const size_t bytes );
+        size_t GetMemoryLimit() const;
+        void SetNeighbourhood( const NEIGHBOURHOOD neighbourhood );
+        NEIGHBOURHOOD GetNeighbourhood() const;
+        bool SetGridLayout( const GRID_LAYOUT layout );
+        GRID_LAYOUT GetGridLayout() const;
+        uint64_t GetGeneration() const;
+        void PrintMaze( const std::vector<std::pair<size_t, size_t>> & path = {} ) const;
 
     private:
-        enum class MAZE_DATA_TYPE : char
+        struct HierarchyNode
         {
-            CLEAR=0,
-            BLOCKED=1,
-            EXIT=2
+            uint32_t index; ///< The padded index of the cell.
+            uint32_t cluster; ///< The cluster the cell belongs to.
+            uint32_t across[2]; ///< The nodes next to this one in neighbouring clusters, or NO_NODE.
+            int exitDistance; ///< The distance to the nearest exit without leaving the cluster, or -1 if there is none.
+            bool entrance; ///< Whether the node is kept for near-optimal searches.
         };
 
+        const MAZE_DATA_TYPE * Cells() const;
+        size_t CellIndex( const size_t row, const size_t column ) const;
+        template <typename LAYOUT_POLICY> LayoutGrid<LAYOUT_POLICY> Grid() const;
+        GRID_LAYOUT SearchLayout() const;
+        void BuildLayoutGrid();
+        void SetLayoutCell( const size_t row, const size_t column, const MAZE_DATA_TYPE type );
         MAZE_DATA_TYPE GetPositionalData( const size_t row, const size_t column ) const;
+        static bool IsTerrain( const MAZE_DATA_TYPE type );
         bool SetPositionalData( const size_t row, const size_t column, const char value );
+        bool ParseMaze( const char * data, const size_t size );
+        bool LoadBinaryMaze( const std::shared_ptr<MappedFile> & file );
+        static size_t LoadedBytes( const size_t rows, const size_t columns );
+        bool FitsMemoryLimit( const size_t rows, const size_t columns ) const;
         void ClearMaze();
+        void AdvanceGeneration();
         void ReallocateMaze( const size_t rows, const size_t columns );
+        void BuildIndexes();
+        void IndexExits();
+        void BuildBitGrid();
+        void LabelComponents();
+        bool ExitUnreachable( const size_t start_row, const size_t start_column ) const;
+        void RelabelAroundCell( const size_t index );
+        bool ComponentHoldsExit( const uint32_t component ) const;
+        void RepairCloserDistances( const size_t index );
+        void RepairFartherDistances( const size_t index );
+        void ClearHierarchy();
+        size_t ClusterOf( const size_t index ) const;
+        void ClusterBounds( const size_t cluster, size_t & first_row, size_t & first_column, size_t & rows, size_t & columns ) const;
+        int ClusterBFS( const size_t cluster, const size_t start_index, ScratchVector<int> & distances, ScratchVector<uint32_t> & queue ) const;
+        int ExitDistanceLowerBound( const size_t index ) const;
+        template <typename LAYOUT_POLICY> int ExitDistanceLowerBound( const LayoutGrid<LAYOUT_POLICY> & grid, const size_t index ) const;
 
-        int DepthFirstRecursion( const size_t current_row, const size_t current_column, std::vector<std::vector<bool>> & traversed, const int nodesInPath, int& numSteps) const;
-        void AddValueToPathSizeVectorIfPositive( std::vector<int>& pathSizes, const int value ) const;
+        SearchResult TimedSearch( const size_t start_row, const size_t start_column, const SEARCH_ALGORITHM algorithm ) const;
+        SearchResult TimedSearch( const size_t start_row, const size_t start_column, const SEARCH_ALGORITHM algorithm, SearchWorkspace & workspace ) const;
+        SearchResult Search( const size_t start_row, const size_t start_column, const SEARCH_ALGORITHM algorithm, SearchWorkspace & workspace ) const;
+        SEARCH_ALGORITHM NeighbourhoodAlgorithm( const SEARCH_ALGORITHM algorithm ) const;
+        template <bool RECORD_PATH> int SearchBFS( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const;
+        template <typename NEIGHBOURHOOD_POLICY, typename LAYOUT_POLICY, bool RECORD_PATH> int BreadthFirstSearch( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const;
+        int SearchDFS( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const;
+        int SearchIterativeDFS( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const;
+        template <typename LAYOUT_POLICY> int IterativeDepthFirstSearch( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const;
+        int SearchBidirectional( const size_t start_row, const size_t start_column, const size_t goal_row, const size_t goal_column, SearchWorkspace & workspace, SearchResult & result ) const;
+        template <typename NEIGHBOURHOOD_POLICY, typename LAYOUT_POLICY> int BidirectionalSearch( const size_t start_row, const size_t start_column, const size_t goal_row, const size_t goal_column, SearchWorkspace & workspace, SearchResult & result ) const;
+        template <bool RECORD_PATH> int SearchAStar( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const;
+        template <typename LAYOUT_POLICY, bool RECORD_PATH> int AStarSearch( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const;
+        int SearchJumpPoint( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const;
+        template <typename LAYOUT_POLICY> int JumpPointSearch( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const;
+        template <typename LAYOUT_POLICY> size_t JumpVertical( const MAZE_DATA_TYPE * cells, const NeighbourOffsets<FourWayNeighbourhood, LAYOUT_POLICY> & moves, const size_t from, const uint8_t step, int & distance ) const;
+        template <typename LAYOUT_POLICY> size_t JumpHorizontal( const MAZE_DATA_TYPE * cells, const NeighbourOffsets<FourWayNeighbourhood, LAYOUT_POLICY> & moves, const size_t from, const uint8_t step, int & distance ) const;
+        template <typename LAYOUT_POLICY> bool VerticalForced( const MAZE_DATA_TYPE * cells, const NeighbourOffsets<FourWayNeighbourhood, LAYOUT_POLICY> & moves, const size_t index, const uint8_t step, const uint8_t side ) const;
+        int DistanceFieldLookup( const size_t start_row, const size_t start_column ) const;
+        void TracePath( const size_t start_row, const size_t start_column, const int distance, const bool followField, const SearchWorkspace & workspace, std::vector<std::pair<size_t, size_t>> & path ) const;
+        int SearchParallelBFS( const size_t start_row, const size_t start_column, ThreadPool & pool, SearchWorkspace & workspace, SearchResult & result ) const;
+        template <typename NEIGHBOURHOOD_POLICY, typename LAYOUT_POLICY> int ParallelBreadthFirstSearch( const size_t start_row, const size_t start_column, ThreadPool & pool, SearchWorkspace & workspace, SearchResult & result ) const;
+        int SearchDijkstra( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const;
+        template <typename NEIGHBOURHOOD_POLICY, typename LAYOUT_POLICY> int DijkstraSearch( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const;
+        int SearchHierarchical( const size_t start_row, const size_t start_column, const bool exact, SearchWorkspace & workspace, SearchResult & result ) const;
+        template <typename NEIGHBOURHOOD_POLICY, typename LAYOUT_POLICY> int DepthFirstRecursion( const MAZE_DATA_TYPE * cells, const size_t current_index, uint32_t * traversed, const uint32_t stamp, const int nodesInPath, const NeighbourOffsets<NEIGHBOURHOOD_POLICY, LAYOUT_POLICY> & offsets, SearchResult & result ) const;
+        void KeepShortestPath( int & shortest, const int value ) const;
 
         size_t m_rowSize{ 0 };
         size_t m_columnSize{ 0 };
-        std::vector<std::vector<MAZE_DATA_TYPE>> m_mapData;
+        size_t m_stride{ 0 }; ///< The number of cells in one padded row (columns plus the left and right border).
+        size_t m_cellCount{ 0 }; ///< The number of cells in the padded grid.
+        std::vector<MAZE_DATA_TYPE> m_mapData; ///< Row-major grid surrounded by a one cell border of BLOCKED cells.
+        std::shared_ptr<MappedFile> m_mappedFile; ///< The binary maze file the grid is read from in place, if any.
+        const MAZE_DATA_TYPE * m_mappedCells{ nullptr }; ///< The padded grid inside the mapped file, or nullptr when the grid is in m_mapData.
+        std::vector<std::pair<size_t, size_t>> m_exits; ///< The padded row and column of every exit.
+        size_t m_terrainCells{ 0 }; ///< The number of terrain cells, which cost more than one move to enter.
+        std::vector<int> m_distanceField; ///< The distance from every cell to the nearest exit, or empty if not built.
+        std::vector<uint32_t> m_componentLabels; ///< The connected region of clear and exit cells every padded cell belongs to, or NO_COMPONENT for blocked cells.
+        std::vector<bool> m_componentHasExit; ///< Whether each connected region holds an exit.
+        std::vector<uint8_t> m_regionMarks; ///< Which flood fill of RelabelAroundCell reached each cell, or 0; all 0 between calls.
+        size_t m_clusterSize{ 0 }; ///< The width and height of a hierarchy cluster, or 0 if the hierarchy isn't built.
+        size_t m_clusterColumns{ 0 }; ///< The number of clusters across a row of the maze.
+        std::vector<HierarchyNode> m_hierarchyNodes; ///< Every passable cell next to a passable cell of another cluster, cluster by cluster.
+        std::vector<uint32_t> m_clusterFirstNode; ///< The first node of every cluster, and the node count at the end.
+        std::vector<size_t> m_clusterFirstDistance; ///< Where the distance table of every cluster starts in m_clusterDistances.
+        std::vector<uint16_t> m_clusterDistances; ///< Per cluster, the distance between every pair of its nodes without leaving the cluster.
+        BitGrid m_bitGrid; ///< Packed passable and exit bits for the bit-parallel breadth first search.
+        size_t m_memoryLimit{ DEFAULT_MEMORY_LIMIT }; ///< The maximum number of bytes the grid and its indexes may occupy.
+        NEIGHBOURHOOD m_neighbourhood{ NEIGHBOURHOOD::FOUR_WAY }; ///< The moves the searches may make.
+        GRID_LAYOUT m_layout{ GRID_LAYOUT::ROW_MAJOR }; ///< The layout chosen for the searches; it takes effect once m_layoutCells is built.
+        std::vector<MAZE_DATA_TYPE> m_layoutCells; ///< A copy of the padded grid in m_layout's order, or empty when the searches walk the grid itself.
+        size_t m_layoutRowCells{ 0 }; ///< The number of cells in one row of blocks of m_layoutCells.
+        uint64_t m_generation{ 0 }; ///< Identifies the maze and settings the searches answer for; changes whenever an answer could.
 };
 
 #endif // __MAZE_H
\ No newline at end of file
@@ -0,0 +1,337 @@
+// Joseph Miller (c) 2019
+
+#include "MazeGenerator.h"
+#include <algorithm>
+
+/** Sets up a generator for mazes of the given size.
+    The maze starts as an open field.
+
+@param rows The number of rows to generate.
+@param columns The number of columns to generate.
+@param seed The seed of the random generator.
+*/
+MazeGenerator::MazeGenerator( const size_t rows, const size_t columns, const uint32_t seed ) :
+    m_rows( rows ),
+    m_columns( columns ),
+    m_cells( rows * columns, CLEAR ),
+    m_random( seed )
+{
+}
+
+/** Makes every cell clear.
+*/
+void MazeGenerator::OpenField()
+{
+    Fill( CLEAR );
+}
+
+/** Makes every cell blocked with the given probability, and clear otherwise.
+
+@param density The fraction of cells to block, from 0 to 1.
+*/
+void MazeGenerator::RandomObstacles( const double density )
+{
+    std::bernoulli_distribution blocked( density ); // whether each cell is blocked
+    for ( char & cell : m_cells )
+    {
+        cell = blocked( m_random ) ? BLOCKED : CLEAR;
+    }
+}
+
+/** Carves a perfect maze (exactly one path between any two clear cells) with a randomised depth first search.
+    Rooms sit on even rows and columns and the cells between two rooms are walls that get knocked through.
+    The search keeps an explicit stack, so large mazes don't run out of call stack.
+*/
+void MazeGenerator::RecursiveBacktracker()
+{
+    Fill( BLOCKED );
+    const size_t roomRows = ( m_rows + 1 ) / 2; // the rows of rooms
+    const size_t roomColumns = ( m_columns + 1 ) / 2; // the columns of rooms
+    if ( roomRows == 0 || roomColumns == 0 )
+    {
+        return;
+    }
+
+    std::vector<bool> visited( roomRows * roomColumns, false ); // the rooms already carved
+    std::vector<size_t> stack; // the rooms on the current path
+    visited[0] = true;
+    Cell( 0, 0 ) = CLEAR;
+    stack.push_back( 0 );
+
+    while ( !stack.empty() )
+    {
+        const size_t room = stack.back(); // the room to carve on from
+        const size_t row = room / roomColumns; // the room row
+        const size_t column = room % roomColumns; // the room column
+
+        size_t neighbours[4]; // the unvisited rooms next to this one
+        size_t neighbourCount = 0; // the number of unvisited rooms next to this one
+        if ( row > 0 && !visited[room - roomColumns] )
+        {
+            neighbours[neighbourCount++] = room - roomColumns;
+        }
+        if ( row + 1 < roomRows && !visited[room + roomColumns] )
+        {
+            neighbours[neighbourCount++] = room + roomColumns;
+        }
+        if ( column > 0 && !visited[room - 1] )
+        {
+            neighbours[neighbourCount++] = room - 1;
+        }
+        if ( column + 1 < roomColumns && !visited[room + 1] )
+        {
+            neighbours[neighbourCount++] = room + 1;
+        }
+
+        if ( neighbourCount == 0 ) // dead end, so back up
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        const size_t next = neighbours[std::uniform_int_distribution<size_t>( 0, neighbourCount - 1 )( m_random )]; // the room to carve into
+        const size_t nextRow = next / roomColumns;
+        const size_t nextColumn = next % roomColumns;
+        Cell( row + nextRow, column + nextColumn ) = CLEAR; // the wall between the rooms, in cell coordinates
+        Cell( nextRow * 2, nextColumn * 2 ) = CLEAR;
+        visited[next] = true;
+        stack.push_back( next );
+    }
+}
+
+/** Carves a perfect maze with randomised Prim's algorithm.
+    Prim's mazes branch far more than recursive backtracker mazes, so their paths are shorter and their frontiers wider.
+*/
+void MazeGenerator::Prim()
+{
+    Fill( BLOCKED );
+    const size_t roomRows = ( m_rows + 1 ) / 2; // the rows of rooms
+    const size_t roomColumns = ( m_columns + 1 ) / 2; // the columns of rooms
+    if ( roomRows == 0 || roomColumns == 0 )
+    {
+        return;
+    }
+
+    std::vector<bool> visited( roomRows * roomColumns, false ); // the rooms already carved
+    std::vector<std::pair<size_t, size_t>> walls; // the carved room and the room across each candidate wall
+
+    const auto addWalls = [&]( const size_t room )
+    {
+        const size_t row = room / roomColumns;
+        const size_t column = room % roomColumns;
+        if ( row > 0 && !visited[room - roomColumns] )
+        {
+            walls.push_back( { room, room - roomColumns } );
+        }
+        if ( row + 1 < roomRows && !visited[room + roomColumns] )
+        {
+            walls.push_back( { room, room + roomColumns } );
+        }
+        if ( column > 0 && !visited[room - 1] )
+        {
+            walls.push_back( { room, room - 1 } );
+        }
+        if ( column + 1 < roomColumns && !visited[room + 1] )
+        {
+            walls.push_back( { room, room + 1 } );
+        }
+    };
+
+    const size_t start = std::uniform_int_distribution<size_t>( 0, visited.size() - 1 )( m_random ); // the first room
+    visited[start] = true;
+    Cell( start / roomColumns * 2, start % roomColumns * 2 ) = CLEAR;
+    addWalls( start );
+
+    while ( !walls.empty() )
+    {
+        const size_t pick = std::uniform_int_distribution<size_t>( 0, walls.size() - 1 )( m_random ); // the wall to consider
+        const std::pair<size_t, size_t> wall = walls[pick];
+        walls[pick] = walls.back();
+        walls.pop_back();
+        if ( visited[wall.second] ) // the room was carved through another wall
+        {
+            continue;
+        }
+        const size_t row = wall.first / roomColumns;
+        const size_t column = wall.first % roomColumns;
+        const size_t nextRow = wall.second / roomColumns;
+        const size_t nextColumn = wall.second % roomColumns;
+        Cell( row + nextRow, column + nextColumn ) = CLEAR;
+        Cell( nextRow * 2, nextColumn * 2 ) = CLEAR;
+        visited[wall.second] = true;
+        addWalls( wall.second );
+    }
+}
+
+/** Builds one long serpentine corridor: every other row is a wall with a gap at alternating ends.
+*/
+void MazeGenerator::Corridors()
+{
+    Fill( CLEAR );
+    for ( size_t row = 1; row < m_rows; row += 2 )
+    {
+        const size_t gap = ( ( row / 2 ) % 2 == 0 ) ? m_columns - 1 : 0; // the column left open
+        for ( size_t column = 0; column < m_columns; ++column )
+        {
+            if ( column != gap )
+            {
+                Cell( row, column ) = BLOCKED;
+            }
+        }
+    }
+}
+
+/** Builds a spiral corridor winding from the edge of the maze into its centre.
+    A wall is laid along a spiral one cell inside the corridor, turning whenever it would come within one cell of
+    the edge or of wall already laid.
+*/
+void MazeGenerator::Spiral()
+{
+    Fill( CLEAR );
+    if ( m_rows < 2 || m_columns < 2 )
+    {
+        return;
+    }
+
+    const ptrdiff_t rowSteps[] = { 0, 1, 0, -1 }; // right, down, left, up
+    const ptrdiff_t columnSteps[] = { 1, 0, -1, 0 };
+    const auto isOpen = [&]( const ptrdiff_t row, const ptrdiff_t column ) // whether a position is inside the maze and not wall
+    {
+        return row >= 0 && column >= 0 && row < static_cast<ptrdiff_t>( m_rows ) && column < static_cast<ptrdiff_t>( m_columns )
+            && Cell( static_cast<size_t>( row ), static_cast<size_t>( column ) ) != BLOCKED;
+    };
+
+    ptrdiff_t row = 1; // the wall is laid from just below the top left corner
+    ptrdiff_t column = 0;
+    size_t direction = 0; // the index of the direction the wall is being laid in
+    size_t turnsWithoutMoving = 0; // the spiral is finished once the wall can't move in two directions in a row
+    Cell( 1, 0 ) = BLOCKED;
+    while ( turnsWithoutMoving < 2 )
+    {
+        const ptrdiff_t nextRow = row + rowSteps[direction];
+        const ptrdiff_t nextColumn = column + columnSteps[direction];
+        if ( isOpen( nextRow, nextColumn ) && isOpen( nextRow + rowSteps[direction], nextColumn + columnSteps[direction] ) )
+        {
+            row = nextRow;
+            column = nextColumn;
+            Cell( static_cast<size_t>( row ), static_cast<size_t>( column ) ) = BLOCKED;
+            turnsWithoutMoving = 0;
+        }
+        else
+        {
+            direction = ( direction + 1 ) % 4;
+            ++turnsWithoutMoving;
+        }
+    }
+}
+
+/** Turns clear cells into terrain of a random move cost with the given probability.
+
+@param density The fraction of clear cells to turn into terrain, from 0 to 1.
+*/
+void MazeGenerator::AddTerrain( const double density )
+{
+    std::bernoulli_distribution slowed( density ); // whether each clear cell becomes terrain
+    std::uniform_int_distribution<int> terrain( FIRST_TERRAIN, LAST_TERRAIN ); // the terrain a cell becomes
+    for ( char & cell : m_cells )
+    {
+        if ( cell == CLEAR && slowed( m_random ) )
+        {
+            cell = static_cast<char>( terrain( m_random ) );
+        }
+    }
+}
+
+/** Turns randomly chosen clear cells into exits.
+
+@param count The number of exits to add.
+
+@return The number of exits added, which is less than count if there weren't enough clear cells.
+*/
+size_t MazeGenerator::AddExits( const size_t count )
+{
+    std::vector<size_t> clearCells; // the cells that could become exits
+    for ( size_t cell = 0; cell < m_cells.size(); ++cell )
+    {
+        if ( m_cells[cell] == CLEAR )
+        {
+            clearCells.push_back( cell );
+        }
+    }
+    const size_t added = std::min( count, clearCells.size() ); // the number of exits to add
+    for ( size_t exit = 0; exit < added; ++exit ) // a partial shuffle picks distinct cells
+    {
+        const size_t pick = std::uniform_int_distribution<size_t>( exit, clearCells.size() - 1 )( m_random );
+        std::swap( clearCells[exit], clearCells[pick] );
+        m_cells[clearCells[exit]] = EXIT;
+    }
+    return added;
+}
+
+/** Picks random clear cells, such as starting points for queries.
+
+@param count The number of cells to pick; cells may be picked more than once.
+
+@return The row and column of each cell picked, or nothing if the maze has no clear cells.
+*/
+std::vector<std::pair<size_t, size_t>> MazeGenerator::RandomClearCells( const size_t count )
+{
+    std::vector<size_t> clearCells; // the cells that can be picked
+    for ( size_t cell = 0; cell < m_cells.size(); ++cell )
+    {
+        if ( m_cells[cell] == CLEAR )
+        {
+            clearCells.push_back( cell );
+        }
+    }
+    std::vector<std::pair<size_t, size_t>> picked; // the row and column of each cell picked
+    if ( clearCells.empty() )
+    {
+        return picked;
+    }
+    std::uniform_int_distribution<size_t> pick( 0, clearCells.size() - 1 );
+    picked.reserve( count );
+    for ( size_t cell = 0; cell < count; ++cell )
+    {
+        const size_t index = clearCells[pick( m_random )];
+        picked.push_back( { index / m_columns, index % m_columns } );
+    }
+    return picked;
+}
+
+/** Writes the maze in the map file format.
+
+@return The text of the map file.
+*/
+std::string MazeGenerator::ToText() const
+{
+    std::string text = std::to_string( m_columns ) + "," + std::to_string( m_rows ) + "\n";
+    text.reserve( text.size() + m_rows * ( m_columns + 1 ) );
+    for ( size_t row = 0; row < m_rows; ++row )
+    {
+        text.append( m_cells.data() + row * m_columns, m_columns );
+        text.push_back( '\n' );
+    }
+    return text;
+}
+
+/** Retrieves a cell of the maze.
+
+@param row The row of the cell.
+@param column The column of the cell.
+
+@return The cell in the map file format.
+*/
+char & MazeGenerator::Cell( const size_t row, const size_t column )
+{
+    return m_cells[row * m_columns + column];
+}
+
+/** Sets every cell of the maze to one value.
+
+@param value The value in the map file format.
+*/
+void MazeGenerator::Fill( const char value )
+{
+    std::fill( m_cells.begin(), m_cells.end(), value );
+}
@@ -0,0 +1,44 @@
+// Joseph Miller (c) 2019
+#ifndef __MAZE_GENERATOR_H
+#define __MAZE_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+class MazeGenerator
+{
+    public:
+        MazeGenerator( const size_t rows, const size_t columns, const uint32_t seed );
+        ~MazeGenerator() = default;
+        void OpenField();
+        void RandomObstacles( const double density );
+        void RecursiveBacktracker();
+        void Prim();
+        void Corridors();
+        void Spiral();
+        void AddTerrain( const double density );
+        size_t AddExits( const size_t count );
+        std::vector<std::pair<size_t, size_t>> RandomClearCells( const size_t count );
+        std::string ToText() const;
+
+    private:
+        static constexpr char CLEAR = '0'; ///< A clear cell in the map file format.
+        static constexpr char BLOCKED = '1'; ///< A blocked cell in the map file format.
+        static constexpr char EXIT = '2'; ///< An exit cell in the map file format.
+        static constexpr char FIRST_TERRAIN = '3'; ///< The cheapest terrain in the map file format.
+        static constexpr char LAST_TERRAIN = '9'; ///< The slowest terrain in the map file format.
+
+        char & Cell( const size_t row, const size_t column );
+        void Fill( const char value );
+
+        size_t m_rows; ///< The number of rows to generate.
+        size_t m_columns; ///< The number of columns to generate.
+        std::vector<char> m_cells; ///< Row-major cells in the map file format.
+        std::mt19937 m_random; ///< The seeded generator, so every maze can be regenerated exactly.
+};
+
+#endif // __MAZE_GENERATOR_H
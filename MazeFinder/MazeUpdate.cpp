@@ -0,0 +1,447 @@
+// Joseph Miller (c) 2019
+// Runtime changes to a loaded Maze: SetCell and the incremental repair of the indexes built at load time.
+
+#include "Maze.h"
+#include <algorithm>
+#include <limits>
+
+static constexpr int DISTANCE_AFFECTED = -2; ///< Marks a distance field cell whose shortest path ran through a cell that got farther from an exit.
+static constexpr uint32_t NO_COMPONENT = std::numeric_limits<uint32_t>::max(); ///< The component label of a blocked cell.
+static constexpr size_t MAX_REGION_FILLS = 4; ///< A cell has at most four neighbouring regions.
+
+/** Changes a single cell of the loaded maze, such as a door opening or closing.
+    The copy of the grid in the search layout, exit index, bit grid, and component labels are updated in place, and a built distance field is repaired
+    by touching only the cells whose distance changes, so an update costs about the size of the change rather than
+    the size of the maze. A maze searched in place in a mapped binary file is first copied into memory.
+    The hierarchy is discarded and must be rebuilt with BuildHierarchy. Changing only the move cost of a passable
+    cell, such as clear to terrain, leaves every number of spaces as it was, so nothing but the terrain count is touched.
+    Must not be called while queries on the maze are running.
+
+@param row The row of the cell to change.
+@param column The column of the cell to change.
+@param type What the cell becomes.
+
+@retval true if the cell was changed, or already was the given type.
+@retval false if no maze is loaded, or the position or type is invalid.
+*/
+bool Maze::SetCell( const size_t row, const size_t column, const MAZE_DATA_TYPE type )
+{
+    if ( row >= m_rowSize || column >= m_columnSize )
+    {
+        return false;
+    }
+    switch ( type )
+    {
+        case MAZE_DATA_TYPE::CLEAR: //intentional fallthrough
+        case MAZE_DATA_TYPE::BLOCKED: //intentional fallthrough
+        case MAZE_DATA_TYPE::EXIT:
+        {
+        } break;
+        default:
+        {
+            if ( !IsTerrain( type ) )
+            {
+                return false;
+            }
+        } break;
+    }
+
+    const size_t index = CellIndex( row, column ); // the index of the position within the padded grid
+    const MAZE_DATA_TYPE previous = Cells()[index]; // what the cell was
+    if ( previous == type )
+    {
+        return true;
+    }
+    AdvanceGeneration();
+    if ( m_mappedCells != nullptr ) // the mapped file is read only, so the grid moves into memory
+    {
+        m_mapData.assign( m_mappedCells, m_mappedCells + m_cellCount );
+        m_mappedCells = nullptr;
+        m_mappedFile.reset();
+    }
+    m_mapData[index] = type;
+    SetLayoutCell( row, column, type );
+    m_terrainCells = m_terrainCells + ( IsTerrain( type ) ? 1 : 0 ) - ( IsTerrain( previous ) ? 1 : 0 );
+    if ( previous != MAZE_DATA_TYPE::BLOCKED && previous != MAZE_DATA_TYPE::EXIT && type != MAZE_DATA_TYPE::BLOCKED && type != MAZE_DATA_TYPE::EXIT )
+    {
+        return true; // only the move cost changed
+    }
+
+    if ( previous == MAZE_DATA_TYPE::EXIT )
+    {
+        m_exits.erase( std::find( m_exits.begin(), m_exits.end(), std::make_pair( row + 1, column + 1 ) ) );
+    }
+    else if ( type == MAZE_DATA_TYPE::EXIT )
+    {
+        m_exits.push_back( { row + 1, column + 1 } );
+    }
+    m_bitGrid.SetCell( row, column, type != MAZE_DATA_TYPE::BLOCKED, type == MAZE_DATA_TYPE::EXIT );
+    ClearHierarchy();
+
+    if ( ( previous == MAZE_DATA_TYPE::BLOCKED ) != ( type == MAZE_DATA_TYPE::BLOCKED ) ) // regions may join or split
+    {
+        RelabelAroundCell( index );
+    }
+    else if ( type == MAZE_DATA_TYPE::EXIT ) // a clear or terrain cell became an exit
+    {
+        m_componentHasExit[m_componentLabels[index]] = true;
+    }
+    else // an exit became a clear or terrain cell
+    {
+        m_componentHasExit[m_componentLabels[index]] = ComponentHoldsExit( m_componentLabels[index] );
+    }
+
+    if ( DistanceFieldBuilt() )
+    {
+        if ( type == MAZE_DATA_TYPE::EXIT || previous == MAZE_DATA_TYPE::BLOCKED ) // the change can only shorten paths
+        {
+            RepairCloserDistances( index );
+        }
+        else
+        {
+            RepairFartherDistances( index );
+        }
+    }
+    return true;
+}
+
+/** Updates the component labels after a cell became passable or blocked.
+    A flood fill is started from every passable neighbour of the cell, and the fills take turns growing a cell at a
+    time. Fills that run into each other are in the same region. Once at most one region is still growing, every
+    other region has been fully walked, so only the smaller regions are ever relabelled and the largest keeps its label.
+
+@param index The index of the changed cell.
+*/
+void Maze::RelabelAroundCell( const size_t index )
+{
+    const MAZE_DATA_TYPE * cells = m_mapData.data(); // the padded grid
+    const ptrdiff_t neighbourOffsets[] = { -static_cast<ptrdiff_t>( m_stride ), -1, static_cast<ptrdiff_t>( m_stride ), 1 }; // offsets to the surrounding cells
+    const bool opened = cells[index] != MAZE_DATA_TYPE::BLOCKED; // whether the cell became passable
+    if ( m_regionMarks.size() != m_cellCount )
+    {
+        m_regionMarks.assign( m_cellCount, 0 );
+    }
+
+    std::vector<uint32_t> fills[MAX_REGION_FILLS]; // the cells each flood fill reached, in the order reached
+    size_t heads[MAX_REGION_FILLS] = { 0 }; // the position of the next cell each fill expands
+    size_t groups[MAX_REGION_FILLS]; // the union-find parent of each fill; joined fills are in the same region
+    size_t fillCount = 0; // the number of flood fills started
+    for ( const ptrdiff_t offset : neighbourOffsets )
+    {
+        const size_t neighbourIndex = index + offset;
+        if ( cells[neighbourIndex] != MAZE_DATA_TYPE::BLOCKED )
+        {
+            m_regionMarks[neighbourIndex] = static_cast<uint8_t>( fillCount + 1 );
+            fills[fillCount].push_back( static_cast<uint32_t>( neighbourIndex ) );
+            groups[fillCount] = fillCount;
+            ++fillCount;
+        }
+    }
+    const auto findGroup = [&groups]( size_t fill )
+    {
+        while ( groups[fill] != fill )
+        {
+            fill = groups[fill];
+        }
+        return fill;
+    };
+    const auto groupGrowing = [&]( const size_t group ) // whether any fill of the region still has cells to expand
+    {
+        for ( size_t fill = 0; fill < fillCount; ++fill )
+        {
+            if ( findGroup( fill ) == group && heads[fill] < fills[fill].size() )
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    size_t growingGroup = fillCount; // the region left growing once every other region is walked, or fillCount if none
+    for ( ;; )
+    {
+        size_t growingCount = 0; // the number of regions still growing
+        for ( size_t fill = 0; fill < fillCount; ++fill )
+        {
+            if ( findGroup( fill ) == fill && groupGrowing( fill ) )
+            {
+                growingGroup = fill;
+                ++growingCount;
+            }
+        }
+        if ( growingCount <= 1 )
+        {
+            growingGroup = ( growingCount == 1 ) ? growingGroup : fillCount;
+            break;
+        }
+        for ( size_t fill = 0; fill < fillCount; ++fill )
+        {
+            if ( heads[fill] == fills[fill].size() )
+            {
+                continue;
+            }
+            const size_t currentIndex = fills[fill][heads[fill]++]; // the cell to grow from
+            for ( const ptrdiff_t offset : neighbourOffsets )
+            {
+                const size_t neighbourIndex = currentIndex + offset;
+                if ( neighbourIndex == index || cells[neighbourIndex] == MAZE_DATA_TYPE::BLOCKED ) // an opened cell is joined in afterwards
+                {
+                    continue;
+                }
+                const uint8_t mark = m_regionMarks[neighbourIndex]; // the fill that reached the neighbour, or 0
+                if ( mark == 0 )
+                {
+                    m_regionMarks[neighbourIndex] = static_cast<uint8_t>( fill + 1 );
+                    fills[fill].push_back( static_cast<uint32_t>( neighbourIndex ) );
+                }
+                else
+                {
+                    const size_t ownGroup = findGroup( fill );
+                    const size_t otherGroup = findGroup( mark - 1 );
+                    groups[std::max( ownGroup, otherGroup )] = std::min( ownGroup, otherGroup );
+                }
+            }
+        }
+    }
+
+    // the region that keeps its label: the one still growing, or else the first
+    const size_t keptGroup = ( growingGroup < fillCount ) ? growingGroup : ( fillCount > 0 ? findGroup( 0 ) : fillCount );
+    const uint32_t previousComponent = m_componentLabels[index]; // the region of a cell that became blocked
+    uint32_t keptComponent = ( keptGroup < fillCount ) ? m_componentLabels[fills[keptGroup][0]] : NO_COMPONENT; // the label the kept region ends up with
+    if ( opened && keptComponent == NO_COMPONENT ) // a cell opened with nothing passable around it is a region of its own
+    {
+        keptComponent = static_cast<uint32_t>( m_componentHasExit.size() );
+        m_componentHasExit.push_back( false );
+    }
+
+    uint32_t splitComponents[MAX_REGION_FILLS] = { NO_COMPONENT, NO_COMPONENT, NO_COMPONENT, NO_COMPONENT }; // the new label of each region that split off
+    for ( size_t fill = 0; fill < fillCount; ++fill )
+    {
+        const size_t group = findGroup( fill );
+        if ( group == keptGroup )
+        {
+            continue;
+        }
+        if ( opened ) // every walked region joins the kept one through the opened cell
+        {
+            const uint32_t component = m_componentLabels[fills[fill][0]];
+            if ( m_componentHasExit[component] )
+            {
+                m_componentHasExit[keptComponent] = true;
+            }
+            for ( const uint32_t cell : fills[fill] )
+            {
+                m_componentLabels[cell] = keptComponent;
+            }
+        }
+        else // every walked region split off from the kept one
+        {
+            if ( splitComponents[group] == NO_COMPONENT ) // the first fill of the region makes its label
+            {
+                splitComponents[group] = static_cast<uint32_t>( m_componentHasExit.size() );
+                m_componentHasExit.push_back( false );
+            }
+            const uint32_t component = splitComponents[group];
+            for ( const uint32_t cell : fills[fill] )
+            {
+                m_componentLabels[cell] = component;
+                if ( cells[cell] == MAZE_DATA_TYPE::EXIT )
+                {
+                    m_componentHasExit[component] = true;
+                }
+            }
+        }
+    }
+
+    if ( opened )
+    {
+        m_componentLabels[index] = keptComponent;
+        if ( cells[index] == MAZE_DATA_TYPE::EXIT )
+        {
+            m_componentHasExit[keptComponent] = true;
+        }
+    }
+    else
+    {
+        m_componentLabels[index] = NO_COMPONENT;
+        if ( m_componentHasExit[previousComponent] ) // the exits may have gone with the cell or the regions that split off
+        {
+            m_componentHasExit[previousComponent] = ComponentHoldsExit( previousComponent );
+        }
+    }
+
+    for ( size_t fill = 0; fill < fillCount; ++fill ) // leave the marks clear for the next change
+    {
+        for ( const uint32_t cell : fills[fill] )
+        {
+            m_regionMarks[cell] = 0;
+        }
+    }
+}
+
+/** Checks whether any exit lies in a region.
+
+@param component The label of the region.
+
+@retval true if the region holds an exit.
+@retval false otherwise.
+*/
+bool Maze::ComponentHoldsExit( const uint32_t component ) const
+{
+    for ( const std::pair<size_t, size_t> & exit : m_exits )
+    {
+        if ( m_componentLabels[exit.first * m_stride + exit.second] == component )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Repairs the distance field after a change that can only shorten paths to an exit: a blocked cell became passable
+    or a cell became an exit. The cell takes its new distance from its neighbours and a breadth first search spreads
+    it outward, stopping wherever the old distances are already as short.
+
+@param index The index of the changed cell.
+*/
+void Maze::RepairCloserDistances( const size_t index )
+{
+    const MAZE_DATA_TYPE * cells = m_mapData.data(); // the padded grid
+    const ptrdiff_t neighbourOffsets[] = { -static_cast<ptrdiff_t>( m_stride ), -1, static_cast<ptrdiff_t>( m_stride ), 1 }; // offsets to the surrounding cells
+
+    int distance = ( cells[index] == MAZE_DATA_TYPE::EXIT ) ? 0 : PATH_UNREACHABLE; // the new distance of the changed cell
+    if ( distance == PATH_UNREACHABLE )
+    {
+        for ( const ptrdiff_t offset : neighbourOffsets )
+        {
+            const int neighbourDistance = m_distanceField[index + offset];
+            if ( neighbourDistance != PATH_UNREACHABLE && ( distance == PATH_UNREACHABLE || neighbourDistance + 1 < distance ) )
+            {
+                distance = neighbourDistance + 1;
+            }
+        }
+    }
+    if ( distance == PATH_UNREACHABLE ) // the cell opened into a region without an exit
+    {
+        return;
+    }
+
+    m_distanceField[index] = distance;
+    std::vector<uint32_t> frontier( 1, static_cast<uint32_t>( index ) ); // the cells whose distance got shorter, in breadth first order
+    for ( size_t head = 0; head < frontier.size(); ++head )
+    {
+        const size_t currentIndex = frontier[head];
+        const int nextDistance = m_distanceField[currentIndex] + 1; // the distance the surrounding points can now have
+        for ( const ptrdiff_t offset : neighbourOffsets )
+        {
+            const size_t neighbourIndex = currentIndex + offset;
+            int & neighbourDistance = m_distanceField[neighbourIndex];
+            if ( cells[neighbourIndex] != MAZE_DATA_TYPE::BLOCKED && ( neighbourDistance == PATH_UNREACHABLE || neighbourDistance > nextDistance ) )
+            {
+                neighbourDistance = nextDistance;
+                frontier.push_back( static_cast<uint32_t>( neighbourIndex ) );
+            }
+        }
+    }
+}
+
+/** Repairs the distance field after a change that can only lengthen paths to an exit: a cell became blocked or an
+    exit became a clear cell.
+    First the cells that lose their shortest path are found: walking outward from the changed cell in order of the old
+    distance, a cell one farther than an affected cell is affected too unless another neighbour still offers its old
+    distance. Every affected cell is then seeded with the best distance its unaffected neighbours offer, and the
+    seeds are spread through the affected cells in order of distance, merging the sorted seeds with a breadth first
+    queue. Cells outside the affected region keep their distances.
+
+@param index The index of the changed cell.
+*/
+void Maze::RepairFartherDistances( const size_t index )
+{
+    const MAZE_DATA_TYPE * cells = m_mapData.data(); // the padded grid
+    const ptrdiff_t neighbourOffsets[] = { -static_cast<ptrdiff_t>( m_stride ), -1, static_cast<ptrdiff_t>( m_stride ), 1 }; // offsets to the surrounding cells
+
+    if ( m_distanceField[index] == PATH_UNREACHABLE ) // no exit was reached through the cell, so nothing depends on it
+    {
+        return;
+    }
+
+    std::vector<std::pair<uint32_t, int>> affected; // every affected cell with its old distance, in order of old distance
+    affected.push_back( { static_cast<uint32_t>( index ), m_distanceField[index] } );
+    m_distanceField[index] = DISTANCE_AFFECTED;
+    for ( size_t head = 0; head < affected.size(); ++head )
+    {
+        const size_t currentIndex = affected[head].first;
+        const int childDistance = affected[head].second + 1; // the old distance of the cells that may have been reached through this one
+        for ( const ptrdiff_t offset : neighbourOffsets )
+        {
+            const size_t neighbourIndex = currentIndex + offset;
+            if ( cells[neighbourIndex] == MAZE_DATA_TYPE::BLOCKED || m_distanceField[neighbourIndex] != childDistance )
+            {
+                continue;
+            }
+            bool supported = false; // whether an unaffected neighbour still offers the old distance
+            for ( const ptrdiff_t supportOffset : neighbourOffsets )
+            {
+                if ( m_distanceField[neighbourIndex + supportOffset] == childDistance - 1 )
+                {
+                    supported = true;
+                    break;
+                }
+            }
+            if ( !supported )
+            {
+                affected.push_back( { static_cast<uint32_t>( neighbourIndex ), childDistance } );
+                m_distanceField[neighbourIndex] = DISTANCE_AFFECTED;
+            }
+        }
+    }
+
+    std::vector<std::pair<int, uint32_t>> seeds; // the best distance each affected cell gets from an unaffected neighbour
+    for ( const std::pair<uint32_t, int> & cell : affected )
+    {
+        if ( cells[cell.first] == MAZE_DATA_TYPE::BLOCKED )
+        {
+            continue;
+        }
+        int best = std::numeric_limits<int>::max(); // the shortest distance offered
+        for ( const ptrdiff_t offset : neighbourOffsets )
+        {
+            const int neighbourDistance = m_distanceField[cell.first + offset];
+            if ( neighbourDistance >= 0 )
+            {
+                best = std::min( best, neighbourDistance + 1 );
+            }
+        }
+        if ( best != std::numeric_limits<int>::max() )
+        {
+            seeds.push_back( { best, cell.first } );
+        }
+    }
+    for ( const std::pair<uint32_t, int> & cell : affected )
+    {
+        m_distanceField[cell.first] = PATH_UNREACHABLE;
+    }
+    std::sort( seeds.begin(), seeds.end() );
+
+    std::vector<std::pair<int, uint32_t>> frontier; // the cells reached from a settled cell, in order of distance
+    size_t seed = 0; // the next seed to settle
+    size_t head = 0; // the next frontier cell to settle
+    while ( seed < seeds.size() || head < frontier.size() )
+    {
+        const bool fromSeeds = ( head == frontier.size() ) || ( seed < seeds.size() && seeds[seed].first <= frontier[head].first );
+        const std::pair<int, uint32_t> current = fromSeeds ? seeds[seed++] : frontier[head++]; // the closest unsettled candidate
+        if ( m_distanceField[current.second] != PATH_UNREACHABLE ) // already settled at the same or a shorter distance
+        {
+            continue;
+        }
+        m_distanceField[current.second] = current.first;
+        for ( const ptrdiff_t offset : neighbourOffsets )
+        {
+            const size_t neighbourIndex = current.second + offset;
+            if ( cells[neighbourIndex] != MAZE_DATA_TYPE::BLOCKED && m_distanceField[neighbourIndex] == PATH_UNREACHABLE )
+            {
+                frontier.push_back( { current.first + 1, static_cast<uint32_t>( neighbourIndex ) } );
+            }
+        }
+    }
+}
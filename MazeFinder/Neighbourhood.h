@@ -0,0 +1,149 @@
+// Joseph Miller (c) 2019
+#ifndef __NEIGHBOURHOOD_H
+#define __NEIGHBOURHOOD_H
+
+#include "GridLayout.h"
+#include "Maze.h"
+#include <cstddef>
+#include <cstdint>
+
+/** Moves to the four cells sharing an edge.
+*/
+struct FourWayNeighbourhood
+{
+    static constexpr size_t MOVES = 4; ///< The number of moves.
+    static constexpr bool CUT_CORNERS = true; ///< Whether a diagonal move may pass a blocked cell; no move is diagonal.
+    static constexpr unsigned PARENT_BITS = 2; ///< The bits a recorded direction takes.
+};
+
+/** Moves to all eight surrounding cells; a diagonal move only needs the cell it moves to to be passable.
+*/
+struct EightWayNeighbourhood
+{
+    static constexpr size_t MOVES = 8; ///< The number of moves.
+    static constexpr bool CUT_CORNERS = true; ///< Whether a diagonal move may pass a blocked cell.
+    static constexpr unsigned PARENT_BITS = 4; ///< The bits a recorded direction takes, rounded up so a byte holds whole directions.
+};
+
+/** Moves to all eight surrounding cells, but a diagonal move also needs both cells it passes between to be passable.
+    A diagonal move can then always be made as two moves instead, so the regions of the maze are the same as with four moves.
+*/
+struct EightWayNoCornerCuttingNeighbourhood
+{
+    static constexpr size_t MOVES = 8; ///< The number of moves.
+    static constexpr bool CUT_CORNERS = false; ///< Whether a diagonal move may pass a blocked cell.
+    static constexpr unsigned PARENT_BITS = 4; ///< The bits a recorded direction takes, rounded up so a byte holds whole directions.
+};
+
+/** The moves of every neighbourhood are numbered the same way: up, left, down, and right first, then the diagonals
+    up-left, up-right, down-left, and down-right, so a recorded direction means the same move in all of them.
+*/
+static constexpr size_t ORTHOGONAL_MOVES = 4; ///< The number of moves to a cell sharing an edge.
+static constexpr ptrdiff_t MOVE_ROW_STEPS[] = { -1, 0, 1, 0, -1, -1, 1, 1 }; ///< The change in row of every move.
+static constexpr ptrdiff_t MOVE_COLUMN_STEPS[] = { 0, -1, 0, 1, -1, 1, -1, 1 }; ///< The change in column of every move.
+static constexpr uint8_t REVERSE_MOVES[] = { 2, 3, 0, 1, 7, 6, 5, 4 }; ///< The move that undoes every move.
+
+/** The step of every move of a neighbourhood through the grid of a layout.
+    In the row-major layout a step is an offset, as it has always been; the blocked layouts work out each move with
+    a few bit operations instead.
+*/
+template <typename NEIGHBOURHOOD_POLICY, typename LAYOUT_POLICY>
+struct NeighbourOffsets
+{
+    typename LAYOUT_POLICY::Step steps[NEIGHBOURHOOD_POLICY::MOVES]; ///< The step of each move, in move order.
+
+    /** Works out the steps for a padded grid.
+
+    @param rowCells The number of cells in one padded row, or in one row of blocks of a blocked layout.
+    */
+    explicit NeighbourOffsets( const size_t rowCells )
+    {
+        for ( size_t move = 0; move < NEIGHBOURHOOD_POLICY::MOVES; ++move )
+        {
+            steps[move] = LAYOUT_POLICY::MakeStep( MOVE_ROW_STEPS[move], MOVE_COLUMN_STEPS[move], rowCells );
+        }
+    }
+
+    /** Finds the cell a move reaches.
+
+    @param index The index of the cell to move from.
+    @param move The move to make.
+
+    @return The index of the cell moved to.
+    */
+    size_t Move( const size_t index, const size_t move ) const
+    {
+        return LAYOUT_POLICY::Move( index, steps[move] );
+    }
+};
+
+/** Calls visit( direction, neighbourIndex ) for every move that can be made from a cell, in move order, until visit returns true.
+    The cell moved to may be blocked, as with the four moves the searches always made; only the cells a diagonal
+    move passes between are checked, and only by neighbourhoods that don't cut corners. The blocked border keeps
+    every move in bounds.
+
+@param cells The padded grid, in the layout's order.
+@param index The index of the cell to move from.
+@param offsets The steps of the neighbourhood's moves.
+@param visit Called with the direction and index of each cell moved to; returns true to stop.
+
+@retval true if visit stopped the walk.
+@retval false if every move was visited.
+*/
+template <typename NEIGHBOURHOOD_POLICY, typename LAYOUT_POLICY, typename VISIT>
+inline bool VisitNeighbours( const Maze::MAZE_DATA_TYPE * cells, const size_t index, const NeighbourOffsets<NEIGHBOURHOOD_POLICY, LAYOUT_POLICY> & offsets, VISIT && visit )
+{
+    for ( uint8_t direction = 0; direction < ORTHOGONAL_MOVES; ++direction )
+    {
+        if ( visit( direction, offsets.Move( index, direction ) ) )
+        {
+            return true;
+        }
+    }
+    for ( uint8_t direction = ORTHOGONAL_MOVES; direction < NEIGHBOURHOOD_POLICY::MOVES; ++direction )
+    {
+        if constexpr ( !NEIGHBOURHOOD_POLICY::CUT_CORNERS )
+        {
+            const size_t vertical = ( MOVE_ROW_STEPS[direction] < 0 ) ? 0 : 2; // the move up or down the diagonal passes
+            const size_t horizontal = ( MOVE_COLUMN_STEPS[direction] < 0 ) ? 1 : 3; // the move left or right the diagonal passes
+            if ( cells[offsets.Move( index, vertical )] == Maze::MAZE_DATA_TYPE::BLOCKED || cells[offsets.Move( index, horizontal )] == Maze::MAZE_DATA_TYPE::BLOCKED )
+            {
+                continue;
+            }
+        }
+        if ( visit( direction, offsets.Move( index, direction ) ) )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Runs a search with the policy of a neighbourhood, choosing the template instantiation once per query.
+
+@param neighbourhood The neighbourhood to search with.
+@param search Called with a default constructed policy, whose type selects the instantiation.
+
+@return What search returns.
+*/
+template <typename SEARCH>
+inline auto WithNeighbourhood( const Maze::NEIGHBOURHOOD neighbourhood, SEARCH && search )
+{
+    switch ( neighbourhood )
+    {
+        case Maze::NEIGHBOURHOOD::EIGHT_WAY:
+        {
+            return search( EightWayNeighbourhood() );
+        } break;
+        case Maze::NEIGHBOURHOOD::EIGHT_WAY_NO_CORNER_CUTTING:
+        {
+            return search( EightWayNoCornerCuttingNeighbourhood() );
+        } break;
+        default:
+        {
+            return search( FourWayNeighbourhood() );
+        } break;
+    }
+}
+
+#endif // __NEIGHBOURHOOD_H
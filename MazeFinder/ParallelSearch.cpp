@@ -0,0 +1,342 @@
+// Joseph Miller (c) 2019
+// The parallel search of Maze: a level synchronous breadth first search whose levels are shared between the workers of a ThreadPool.
+
+#include "Maze.h"
+#include "GridLayout.h"
+#include "Neighbourhood.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+static constexpr size_t PARALLEL_LEVEL_MIN_CELLS = 4096; ///< Levels with fewer cells are expanded by worker 0 alone, since sharing them out costs more than it saves.
+static constexpr size_t STEAL_CHUNK_SIZE = 256; ///< The number of frontier cells a worker claims at a time.
+static constexpr size_t VISITED_WORD_BITS = 64; ///< The number of cells in each word of the visited bitmap.
+
+/** A barrier the workers of the parallel search meet at between levels.
+    Levels are short, so the workers yield in a loop rather than sleep on a condition variable.
+*/
+struct LevelBarrier
+{
+    const size_t count; ///< The number of workers that meet at the barrier.
+    std::atomic<size_t> waiting{ 0 }; ///< The number of workers that have arrived in the current phase.
+    std::atomic<size_t> phase{ 0 }; ///< Counts the times every worker has arrived.
+
+    /** Waits until every worker has arrived.
+        Everything a worker wrote before arriving is visible to every worker once they leave.
+    */
+    void Wait()
+    {
+        const size_t arrivedPhase = phase.load( std::memory_order_acquire ); // the phase this worker arrived in
+        if ( waiting.fetch_add( 1, std::memory_order_acq_rel ) + 1 == count ) // the last worker to arrive releases the others
+        {
+            waiting.store( 0, std::memory_order_relaxed );
+            phase.fetch_add( 1, std::memory_order_release );
+            return;
+        }
+        while ( phase.load( std::memory_order_acquire ) == arrivedPhase )
+        {
+            std::this_thread::yield();
+        }
+    }
+};
+
+/** Retrieves the minimum number of spaces using a breadth first search spread across the workers of a thread pool.
+    Gives the same answers as MinimumNumberOfSpacesBFS. It pays off on mazes of millions of cells whose search
+    frontiers grow wide; on narrow corridor mazes it runs at about the speed of the serial search.
+    The maze must not be loaded or reloaded while the search runs.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param pool The thread pool to run the search on.
+
+@return The minimum number of spaces from the start to the closest end point (-1 if no end point could be reached from start or if start was invalid), with the statistics of the search.
+*/
+SearchResult Maze::MinimumNumberOfSpacesParallelBFS( const size_t start_row, const size_t start_column, ThreadPool & pool ) const
+{
+    SearchWorkspace workspace; // the buffers for this search
+    return MinimumNumberOfSpacesParallelBFS( start_row, start_column, pool, workspace );
+}
+
+/** Retrieves the minimum number of spaces using a breadth first search spread across the workers of a thread pool, searching with the caller's buffers.
+    Once the workspace has searched the maze on the same pool, repeating queries on it makes no heap allocations.
+    Each worker grows its own frontier buffers, so the allocations are counted on the threads of the pool.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param pool The thread pool to run the search on.
+@param workspace The buffers to search with, kept for the next query.
+
+@return The minimum number of spaces from the start to the closest end point (-1 if no end point could be reached from start or if start was invalid), with the statistics of the search.
+*/
+SearchResult Maze::MinimumNumberOfSpacesParallelBFS( const size_t start_row, const size_t start_column, ThreadPool & pool, SearchWorkspace & workspace ) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(); // when the search started
+    SearchResult result; // the distance and counters of the search
+    const SearchProbe probe( result ); // counts the search in instrumented builds
+    if ( !ExitUnreachable( start_row, start_column ) )
+    {
+        result.distance = SearchParallelBFS( start_row, start_column, pool, workspace, result );
+    }
+    result.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start );
+    return result;
+}
+
+/** Finds the minimum number of spaces to the nearest exit with a level synchronous breadth first search in the maze's neighbourhood and layout.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param pool The thread pool to run the search on.
+@param workspace The buffers to search with.
+@param result Receives the number of cells expanded and the most cells a level held.
+
+@return The minimum number of spaces from the start to the closest end point, or -1 if no end point could be reached from start or if start was invalid.
+*/
+int Maze::SearchParallelBFS( const size_t start_row, const size_t start_column, ThreadPool & pool, SearchWorkspace & workspace, SearchResult & result ) const
+{
+    return WithNeighbourhood( m_neighbourhood, [&]( auto policy )
+    {
+        return WithLayout( SearchLayout(), [&]( auto layout )
+        {
+            return ParallelBreadthFirstSearch<decltype( policy ), decltype( layout )>( start_row, start_column, pool, workspace, result );
+        } );
+    } );
+}
+
+/** Finds the minimum number of spaces to the nearest exit with a level synchronous breadth first search.
+    Every worker keeps the cells it discovers in its own frontier buffer, so the next level is merged without a lock:
+    it is simply every worker's buffer. To expand a level, each worker claims chunks of its own buffer through an
+    atomic cursor and then steals chunks from the other workers' buffers the same way, until every buffer is drained.
+    A cell joins the next level when a worker sets its bit in a shared visited bitmap, so exactly one worker claims it.
+    The workers meet at a barrier after every level. Levels smaller than PARALLEL_LEVEL_MIN_CELLS are expanded by
+    worker 0 alone while the others wait, so narrow searches don't pay for a barrier on every level.
+    The bitmap and the frontiers are kept in the workspace, so the bitmap is cleared rather than allocated and the
+    frontiers keep their capacity for the next search on a pool of the same size.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param pool The thread pool to run the search on.
+@param workspace The buffers to search with.
+@param result Receives the number of cells expanded and the most cells a level held.
+
+@return The minimum number of spaces from the start to the closest end point, or -1 if no end point could be reached from start or if start was invalid.
+*/
+template <typename NEIGHBOURHOOD_POLICY, typename LAYOUT_POLICY>
+int Maze::ParallelBreadthFirstSearch( const size_t start_row, const size_t start_column, ThreadPool & pool, SearchWorkspace & workspace, SearchResult & result ) const
+{
+    if ( start_row >= m_rowSize || start_column >= m_columnSize ) // check that the row and column for start is within bounds
+    {
+        return PATH_UNREACHABLE;
+    }
+    const LayoutGrid<LAYOUT_POLICY> grid = Grid<LAYOUT_POLICY>(); // the padded grid in the layout's order
+    const MAZE_DATA_TYPE * cells = grid.cells;
+    const size_t startIndex = grid.Index( start_row, start_column ); // the index of the starting position
+    switch ( cells[startIndex] )
+    {
+        case MAZE_DATA_TYPE::EXIT: // If the start is the exit, the end point costs 0 spaces
+        {
+            return 0;
+        } break;
+        case MAZE_DATA_TYPE::BLOCKED: // a blocked start can't travel anywhere
+        {
+            return PATH_UNREACHABLE;
+        } break;
+        default:
+        {
+        } break;
+    }
+
+    const NeighbourOffsets<NEIGHBOURHOOD_POLICY, LAYOUT_POLICY> neighbourOffsets( grid.rowCells ); // steps to the cells a move reaches; the blocked border keeps these in bounds
+
+    const size_t workers = pool.GetThreadCount(); // the number of workers sharing each level
+    using WorkerFrontier = SearchWorkspace::WorkerFrontier;
+    const size_t visitedWords = ( grid.cellCount + VISITED_WORD_BITS - 1 ) / VISITED_WORD_BITS; // the words of the bitmap covering the maze
+    ScratchVector<std::atomic<uint64_t>> & visited = workspace.m_visitedWords; // one bit per cell, set by the worker that claims it
+    if ( visited.size() < visitedWords ) // the atomics can't be moved, so a larger bitmap is built in place of the old one
+    {
+        ScratchVector<std::atomic<uint64_t>>( visitedWords ).swap( visited );
+    }
+    for ( size_t word = 0; word < visitedWords; ++word )
+    {
+        visited[word].store( 0, std::memory_order_relaxed );
+    }
+    ScratchVector<WorkerFrontier> & frontiers = workspace.m_workerFrontiers; // the cells each worker discovered
+    if ( frontiers.size() != workers )
+    {
+        ScratchVector<WorkerFrontier>( workers ).swap( frontiers );
+    }
+    for ( WorkerFrontier & frontier : frontiers ) // an earlier search may have stopped partway through a level
+    {
+        static_cast<SearchCounters &>( frontier ) = SearchCounters();
+        frontier.levels[0].clear();
+        frontier.levels[1].clear();
+        frontier.cursor.store( 0, std::memory_order_relaxed );
+        frontier.cellsExpanded = 0;
+    }
+    LevelBarrier barrier{ workers };
+    std::atomic<bool> exitFound{ false }; // whether a worker reached an exit from the level being expanded
+    size_t parity = 0; // which of the two buffers of every worker holds the level being expanded
+    int depth = 0; // the distance of the cells in the level being expanded
+    int distance = PATH_UNREACHABLE; // the answer, once finished
+    bool finished = false; // whether the search is over; written by worker 0 while the others wait
+    bool sharedLevel = false; // whether the last level was expanded by every worker
+
+    // claims a cell for the next level, returning whether this worker was the one to claim it;
+    // while worker 0 expands a level alone the others are waiting, so it can skip the atomic read-modify-write
+    const auto claim = [&visited]( const size_t index, const bool shared )
+    {
+        std::atomic<uint64_t> & word = visited[index / VISITED_WORD_BITS];
+        const uint64_t bit = static_cast<uint64_t>( 1 ) << ( index % VISITED_WORD_BITS );
+        const uint64_t bits = word.load( std::memory_order_relaxed ); // the word as this worker last saw it
+        if ( ( bits & bit ) != 0 )
+        {
+            return false;
+        }
+        if ( !shared )
+        {
+            word.store( bits | bit, std::memory_order_relaxed );
+            return true;
+        }
+        return ( word.fetch_or( bit, std::memory_order_relaxed ) & bit ) == 0;
+    };
+
+    // adds the unclaimed neighbours of a cell to a next level buffer, returning whether one of them is an exit
+    const auto expand = [&]( const size_t currentIndex, ScratchVector<uint32_t> & next, SearchCounters & counters, const bool shared )
+    {
+        return VisitNeighbours( cells, currentIndex, neighbourOffsets, [&]( const uint8_t, const size_t neighbourIndex )
+        {
+            switch ( cells[neighbourIndex] )
+            {
+                case MAZE_DATA_TYPE::EXIT: // exit found one space past this level
+                {
+                    return true;
+                } break;
+                case MAZE_DATA_TYPE::BLOCKED: // blocked points are never enqueued
+                {
+                } break;
+                default: // cleared point
+                {
+                    if ( claim( neighbourIndex, shared ) )
+                    {
+                        next.push_back( static_cast<uint32_t>( neighbourIndex ) );
+                        counters.Enqueue();
+                    }
+                    else
+                    {
+                        counters.RevisitAvoided();
+                    }
+                } break;
+            }
+            return false;
+        } );
+    };
+
+    // run by worker 0 alone between barriers: finishes a shared level, then expands levels until one is worth sharing
+    const auto advance = [&]()
+    {
+        if ( sharedLevel )
+        {
+            if ( exitFound.load( std::memory_order_relaxed ) )
+            {
+                distance = depth + 1;
+                finished = true;
+                return;
+            }
+            parity ^= 1;
+            ++depth;
+        }
+        size_t levelCells = 0; // the number of cells in the level to expand
+        for ( WorkerFrontier & frontier : frontiers )
+        {
+            frontier.levels[parity ^ 1].clear();
+            frontier.cursor.store( 0, std::memory_order_relaxed );
+            levelCells += frontier.levels[parity].size();
+        }
+        while ( levelCells < PARALLEL_LEVEL_MIN_CELLS )
+        {
+            if ( levelCells == 0 ) // could not find an end point
+            {
+                finished = true;
+                return;
+            }
+            result.peakFrontier = std::max( result.peakFrontier, levelCells );
+            ScratchVector<uint32_t> & next = frontiers[0].levels[parity ^ 1]; // the next level, gathered in worker 0's buffer
+            for ( WorkerFrontier & frontier : frontiers )
+            {
+                for ( const uint32_t currentIndex : frontier.levels[parity] )
+                {
+                    ++frontiers[0].cellsExpanded;
+                    if ( expand( currentIndex, next, frontiers[0], false ) )
+                    {
+                        distance = depth + 1;
+                        finished = true;
+                        return;
+                    }
+                }
+                frontier.levels[parity].clear();
+            }
+            parity ^= 1;
+            ++depth;
+            levelCells = next.size();
+        }
+        result.peakFrontier = std::max( result.peakFrontier, levelCells );
+        sharedLevel = true;
+    };
+
+    // run by every worker: expands its own chunks of the level, then steals chunks from the other workers
+    const auto expandShared = [&]( const size_t worker )
+    {
+        WorkerFrontier & own = frontiers[worker];
+        ScratchVector<uint32_t> & next = own.levels[parity ^ 1];
+        for ( size_t victim = 0; victim < workers; ++victim )
+        {
+            WorkerFrontier & frontier = frontiers[( worker + victim ) % workers];
+            const ScratchVector<uint32_t> & level = frontier.levels[parity];
+            for ( size_t first = frontier.cursor.fetch_add( STEAL_CHUNK_SIZE, std::memory_order_relaxed ); first < level.size(); first = frontier.cursor.fetch_add( STEAL_CHUNK_SIZE, std::memory_order_relaxed ) )
+            {
+                if ( exitFound.load( std::memory_order_relaxed ) ) // the answer is known, so the rest of the level doesn't matter
+                {
+                    return;
+                }
+                const size_t last = std::min( first + STEAL_CHUNK_SIZE, level.size() ); // one past the last cell of the chunk
+                for ( size_t position = first; position < last; ++position )
+                {
+                    ++own.cellsExpanded;
+                    if ( expand( level[position], next, own, true ) )
+                    {
+                        exitFound.store( true, std::memory_order_relaxed );
+                        return;
+                    }
+                }
+            }
+        }
+    };
+
+    claim( startIndex, false );
+    frontiers[0].levels[parity].push_back( static_cast<uint32_t>( startIndex ) );
+    pool.Run( [&]( const size_t worker )
+    {
+        while ( true )
+        {
+            if ( worker == 0 )
+            {
+                advance();
+            }
+            barrier.Wait();
+            if ( finished )
+            {
+                return;
+            }
+            expandShared( worker );
+            barrier.Wait();
+        }
+    } );
+
+    for ( const WorkerFrontier & frontier : frontiers )
+    {
+        result.cellsExpanded += frontier.cellsExpanded;
+        result.counters.Add( frontier );
+    }
+    return distance;
+}
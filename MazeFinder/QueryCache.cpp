@@ -0,0 +1,164 @@
+// Joseph Miller (c) 2019
+// A least recently used cache of Maze query answers, sharded so concurrent queries rarely share a lock.
+
+#include "QueryCache.h"
+#include <algorithm>
+#include <chrono>
+
+static constexpr size_t CACHE_SHARDS = 16; ///< The number of independently locked parts of a cache.
+
+/** Creates an empty cache.
+
+@param capacity The most answers to keep; at least one per shard is always kept.
+*/
+QueryCache::QueryCache( const size_t capacity )
+    : m_capacity( std::max( capacity, CACHE_SHARDS ) )
+    , m_shardCapacity( ( std::max( capacity, CACHE_SHARDS ) + CACHE_SHARDS - 1 ) / CACHE_SHARDS )
+    , m_shards( new Shard[CACHE_SHARDS] )
+{
+}
+
+/** Retrieves the minimum number of spaces with the chosen search, searching only if the answer isn't cached.
+    A cached answer reports no cells expanded, and the time the lookup took. Two threads missing on the same
+    start at once both search, and the second answer simply replaces the first. Answers for an older generation of
+    the maze are never hit again and are left for the least recently used eviction to drop.
+    The maze must not be changed while a query runs, as with the searches themselves.
+
+@param maze The maze to search.
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param algorithm The search to run on a miss.
+
+@return The minimum number of spaces from the start to the closest end point (-1 if no end point could be reached from start or if start was invalid), with the statistics of the search.
+*/
+SearchResult QueryCache::Query( const Maze & maze, const size_t start_row, const size_t start_column, const Maze::SEARCH_ALGORITHM algorithm )
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(); // when the lookup started
+    const Key key{ maze.GetGeneration(), start_row, start_column, algorithm }; // what is being asked
+    Shard & shard = ShardOf( key );
+    {
+        std::lock_guard<std::mutex> lock( shard.mutex );
+        const auto found = shard.index.find( key );
+        if ( found != shard.index.end() )
+        {
+            shard.entries.splice( shard.entries.begin(), shard.entries, found->second ); // now the most recently used
+            m_hits.fetch_add( 1, std::memory_order_relaxed );
+            SearchResult result; // the cached answer, with nothing searched
+            result.distance = found->second->distance;
+            result.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start );
+            return result;
+        }
+    }
+
+    m_misses.fetch_add( 1, std::memory_order_relaxed );
+    const SearchResult result = maze.MinimumNumberOfSpaces( start_row, start_column, algorithm ); // searched without holding the lock
+
+    std::lock_guard<std::mutex> lock( shard.mutex );
+    const auto found = shard.index.find( key );
+    if ( found != shard.index.end() ) // another thread cached it while this one searched
+    {
+        shard.entries.splice( shard.entries.begin(), shard.entries, found->second );
+        found->second->distance = result.distance;
+        return result;
+    }
+    if ( shard.entries.size() >= m_shardCapacity ) // evict the least recently used answer
+    {
+        shard.index.erase( shard.entries.back().key );
+        shard.entries.pop_back();
+    }
+    shard.entries.push_front( { key, result.distance } );
+    shard.index.emplace( key, shard.entries.begin() );
+    return result;
+}
+
+/** Forgets every cached answer. The hit and miss counters are kept.
+*/
+void QueryCache::Clear()
+{
+    for ( size_t shard = 0; shard < CACHE_SHARDS; ++shard )
+    {
+        std::lock_guard<std::mutex> lock( m_shards[shard].mutex );
+        m_shards[shard].entries.clear();
+        m_shards[shard].index.clear();
+    }
+}
+
+/** Retrieves the most answers the cache keeps.
+
+@return the capacity in answers.
+*/
+size_t QueryCache::GetCapacity() const
+{
+    return m_capacity;
+}
+
+/** Retrieves the number of answers the cache holds, including any from an older generation not yet evicted.
+
+@return the number of cached answers.
+*/
+size_t QueryCache::GetSize() const
+{
+    size_t size = 0; // the entries counted so far
+    for ( size_t shard = 0; shard < CACHE_SHARDS; ++shard )
+    {
+        std::lock_guard<std::mutex> lock( m_shards[shard].mutex );
+        size += m_shards[shard].entries.size();
+    }
+    return size;
+}
+
+/** Retrieves the number of queries answered from the cache.
+
+@return the hit count.
+*/
+uint64_t QueryCache::GetHits() const
+{
+    return m_hits.load( std::memory_order_relaxed );
+}
+
+/** Retrieves the number of queries that had to search.
+
+@return the miss count.
+*/
+uint64_t QueryCache::GetMisses() const
+{
+    return m_misses.load( std::memory_order_relaxed );
+}
+
+/** Compares two keys.
+
+@retval true if both keys ask the same query of the same maze generation.
+@retval false otherwise.
+*/
+bool QueryCache::Key::operator==( const Key & other ) const
+{
+    return generation == other.generation && row == other.row && column == other.column && algorithm == other.algorithm;
+}
+
+/** Hashes a key by mixing its fields with the 64-bit FNV-1a steps.
+
+@param key The key to hash.
+
+@return The hash of the key.
+*/
+size_t QueryCache::KeyHash::operator()( const Key & key ) const
+{
+    const uint64_t fields[] = { key.generation, key.row, key.column, static_cast<uint64_t>( key.algorithm ) };
+    uint64_t hash = 14695981039346656037ull; // the FNV-1a offset basis
+    for ( const uint64_t field : fields )
+    {
+        hash = ( hash ^ field ) * 1099511628211ull; // the FNV-1a prime
+    }
+    return static_cast<size_t>( hash ^ ( hash >> 32 ) );
+}
+
+/** Finds the shard a key belongs to.
+
+@param key The key to place.
+
+@return The shard holding the key's entry, if any.
+*/
+QueryCache::Shard & QueryCache::ShardOf( const Key & key )
+{
+    return m_shards[KeyHash()( key ) % CACHE_SHARDS];
+}
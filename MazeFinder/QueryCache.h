@@ -0,0 +1,75 @@
+// Joseph Miller (c) 2019
+#ifndef __QUERY_CACHE_H
+#define __QUERY_CACHE_H
+
+#include "Maze.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/** Remembers the answers of Maze queries so repeated starting points skip the search.
+    Answers are keyed by the maze generation, the algorithm, and the start, and the least recently used answer is
+    evicted once the cache is full. Entries are spread across shards with a lock each, so concurrent queries only
+    contend when they land in the same shard. Generations are unique across every maze in the process, so one cache
+    can serve several mazes at once; the answers of a generation that has ended (by a load, reload, SetCell, or
+    anything else that can change answers) are never hit again and age out as other answers are cached.
+*/
+class QueryCache
+{
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = static_cast<size_t>( 1 ) << 16; ///< The default number of answers kept.
+
+        explicit QueryCache( const size_t capacity = DEFAULT_CAPACITY );
+        ~QueryCache() = default;
+        QueryCache( const QueryCache & ) = delete;
+        QueryCache & operator=( const QueryCache & ) = delete;
+        SearchResult Query( const Maze & maze, const size_t start_row, const size_t start_column, const Maze::SEARCH_ALGORITHM algorithm );
+        void Clear();
+        size_t GetCapacity() const;
+        size_t GetSize() const;
+        uint64_t GetHits() const;
+        uint64_t GetMisses() const;
+
+    private:
+        struct Key
+        {
+            uint64_t generation; ///< The maze generation the answer belongs to.
+            size_t row; ///< The row of the start.
+            size_t column; ///< The column of the start.
+            Maze::SEARCH_ALGORITHM algorithm; ///< The search that gave the answer.
+
+            bool operator==( const Key & other ) const;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()( const Key & key ) const;
+        };
+
+        struct Entry
+        {
+            Key key; ///< What the answer is for.
+            int distance; ///< The minimum number of spaces, or -1.
+        };
+
+        struct Shard
+        {
+            std::mutex mutex; ///< Guards everything else in the shard.
+            std::list<Entry> entries; ///< The answers, most recently used first.
+            std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index; ///< Finds the entry of a key.
+        };
+
+        Shard & ShardOf( const Key & key );
+
+        const size_t m_capacity; ///< The most answers kept across all shards.
+        const size_t m_shardCapacity; ///< The most answers kept in one shard.
+        std::unique_ptr<Shard[]> m_shards; ///< The entries, split by key hash.
+        std::atomic<uint64_t> m_hits{ 0 }; ///< The queries answered from the cache.
+        std::atomic<uint64_t> m_misses{ 0 }; ///< The queries that had to search.
+};
+
+#endif // __QUERY_CACHE_H
@@ -0,0 +1,401 @@
+// Joseph Miller (c) 2019
+// A long-running server answering pipelined distance queries on named mazes held in memory.
+
+#include "QueryServer.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+
+static constexpr size_t READ_BUFFER_BYTES = static_cast<size_t>( 1 ) << 16; ///< The most bytes read from a connection at once.
+static constexpr size_t MAX_LINE_BYTES = 4096; ///< The longest request line accepted before the connection is dropped.
+static constexpr size_t MAX_DISTANCE_CHARACTERS = 16; ///< Room for the digits of any distance and its sign.
+static constexpr std::chrono::milliseconds ACCEPT_RETRY_DELAY( 10 ); ///< How long to wait after a failed accept, such as when out of file descriptors.
+
+/** The searches the server can run, by the names the benchmark uses.
+*/
+static const std::pair<const char *, Maze::SEARCH_ALGORITHM> SERVER_ALGORITHMS[] =
+{
+    { "bfs", Maze::SEARCH_ALGORITHM::BFS },
+    { "dfs", Maze::SEARCH_ALGORITHM::DFS },
+    { "idfs", Maze::SEARCH_ALGORITHM::ITERATIVE_DFS },
+    { "bitbfs", Maze::SEARCH_ALGORITHM::BIT_PARALLEL_BFS },
+    { "field", Maze::SEARCH_ALGORITHM::DISTANCE_FIELD },
+    { "astar", Maze::SEARCH_ALGORITHM::A_STAR },
+    { "jps", Maze::SEARCH_ALGORITHM::JUMP_POINT },
+    { "hpa", Maze::SEARCH_ALGORITHM::HIERARCHICAL },
+    { "hpa_approx", Maze::SEARCH_ALGORITHM::HIERARCHICAL_APPROXIMATE },
+    { "dijkstra", Maze::SEARCH_ALGORITHM::DIJKSTRA },
+};
+
+/** Creates a server with no mazes that isn't listening yet.
+
+@param pool The workers that answer long runs of queries, and build each maze's hierarchy.
+*/
+QueryServer::QueryServer( ThreadPool & pool )
+    : m_pool( pool )
+    , m_poolWorkspaces( pool.GetThreadCount() )
+{
+}
+
+/** Drops every connection and waits for their threads.
+*/
+QueryServer::~QueryServer()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_connectionsMutex );
+        for ( Connection & connection : m_connections )
+        {
+            connection.socket.Shutdown();
+        }
+    }
+    ReapConnections( true );
+}
+
+/** Loads a maze to serve and builds its distance field and hierarchy, so every algorithm is ready for queries.
+    Mazes must all be added before Serve is called.
+
+@param name The name clients query the maze by, without spaces.
+@param filename The maze file, text or binary.
+@param neighbourhood The moves the searches of the maze may make.
+@param layout The order of the cells the searches of the maze walk; they walk the rows if its copy wouldn't fit the memory limit.
+
+@retval true if the maze was loaded.
+@retval false if the name is empty, has a space, or is taken, or the file couldn't be loaded.
+*/
+bool QueryServer::AddMaze( const std::string & name, const std::string & filename, const Maze::NEIGHBOURHOOD neighbourhood, const Maze::GRID_LAYOUT layout )
+{
+    if ( name.empty() || name.find( ' ' ) != std::string::npos || m_mazes.count( name ) != 0 )
+    {
+        return false;
+    }
+    std::unique_ptr<Maze> maze( new Maze );
+    maze->SetGridLayout( layout );
+    if ( !maze->LoadMaze( filename ) )
+    {
+        return false;
+    }
+    maze->SetNeighbourhood( neighbourhood );
+    maze->BuildDistanceField();
+    maze->BuildHierarchy( m_pool );
+    m_mazes.emplace( name, std::move( maze ) );
+    return true;
+}
+
+/** Starts listening for connections.
+
+@param address The address to listen on, "unix:PATH" or "tcp:PORT".
+
+@retval true if the server is listening.
+@retval false if the address couldn't be listened on.
+*/
+bool QueryServer::Listen( const std::string & address )
+{
+    return m_listener.Listen( address );
+}
+
+/** Accepts and serves connections until Stop is called, then drops the connections still open and waits for them.
+*/
+void QueryServer::Serve()
+{
+    while ( !m_stopping.load() )
+    {
+        ReapConnections( false );
+        Connection * connection = nullptr; // the connection being accepted
+        {
+            std::lock_guard<std::mutex> lock( m_connectionsMutex );
+            m_connections.emplace_back();
+            connection = &m_connections.back();
+        }
+        if ( !m_listener.Accept( connection->socket ) )
+        {
+            {
+                std::lock_guard<std::mutex> lock( m_connectionsMutex );
+                m_connections.pop_back();
+            }
+            if ( !m_stopping.load() )
+            {
+                std::this_thread::sleep_for( ACCEPT_RETRY_DELAY );
+            }
+            continue;
+        }
+        m_connectionCount.fetch_add( 1, std::memory_order_relaxed );
+        connection->thread = std::thread( &QueryServer::HandleConnection, this, std::ref( *connection ) );
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( m_connectionsMutex );
+        for ( Connection & connection : m_connections )
+        {
+            connection.socket.Shutdown();
+        }
+    }
+    ReapConnections( true );
+    m_listener.Close();
+}
+
+/** Makes Serve return. Only sets a flag and shuts the listener down, so it is safe to call from a signal handler.
+*/
+void QueryServer::Stop()
+{
+    m_stopping.store( true );
+    m_listener.Shutdown();
+}
+
+/** Retrieves the number of connections accepted.
+
+@return the connection count.
+*/
+uint64_t QueryServer::GetConnections() const
+{
+    return m_connectionCount.load( std::memory_order_relaxed );
+}
+
+/** Retrieves the number of distance queries answered.
+
+@return the query count.
+*/
+uint64_t QueryServer::GetQueries() const
+{
+    return m_queryCount.load( std::memory_order_relaxed );
+}
+
+/** Serves one connection until the client finishes writing or the connection fails.
+    Every complete line read is answered before the next read, with all of its answers sent in one write, so a
+    client pipelining requests gets its answers back in as few writes as it sent requests in. A last line without a
+    newline is answered once the client finishes writing. Blank lines are skipped without an answer. The connection
+    keeps one search workspace for all its queries, so after its first few it answers without allocating.
+
+@param connection The connection to serve.
+*/
+void QueryServer::HandleConnection( Connection & connection )
+{
+    std::vector<char> buffer( READ_BUFFER_BYTES ); // the bytes of the latest read
+    std::string pending; // the bytes read but not yet answered, ending in a partial line
+    std::vector<Request> requests; // the lines being answered, in order
+    std::string output; // the answers, written at once
+    SearchWorkspace workspace; // the search buffers of the queries answered on this thread
+    bool closing = false; // whether the client has finished writing
+    while ( !closing )
+    {
+        const ptrdiff_t bytes = connection.socket.Read( buffer.data(), buffer.size() );
+        closing = bytes <= 0;
+        if ( !closing )
+        {
+            pending.append( buffer.data(), static_cast<size_t>( bytes ) );
+        }
+
+        requests.clear();
+        size_t consumed = 0; // the bytes of pending already split into lines
+        for ( size_t newline = pending.find( '\n' ); newline != std::string::npos; newline = pending.find( '\n', consumed ) )
+        {
+            const std::string_view line( pending.data() + consumed, newline - consumed ); // the request, without its newline
+            consumed = newline + 1;
+            if ( !line.empty() && line != "\r" )
+            {
+                requests.emplace_back();
+                ParseRequest( line, requests.back() );
+            }
+        }
+        const std::string_view last( pending.data() + consumed, pending.size() - consumed ); // the partial line left over
+        if ( closing && !last.empty() && last != "\r" )
+        {
+            requests.emplace_back();
+            ParseRequest( last, requests.back() );
+        }
+        pending.erase( 0, consumed );
+        if ( !closing && pending.size() > MAX_LINE_BYTES ) // never going to be a request, and would otherwise grow without bound
+        {
+            requests.emplace_back();
+            requests.back().maze = nullptr;
+            requests.back().reply = "ERROR line too long";
+            closing = true;
+        }
+        if ( requests.empty() )
+        {
+            continue;
+        }
+
+        AnswerRequests( requests, workspace );
+        output.clear();
+        for ( const Request & request : requests )
+        {
+            if ( request.maze == nullptr )
+            {
+                output += request.reply;
+            }
+            else
+            {
+                char digits[MAX_DISTANCE_CHARACTERS]; // the distance as text
+                output.append( digits, std::to_chars( digits, digits + sizeof( digits ), request.distance ).ptr );
+            }
+            output += '\n';
+        }
+        if ( !connection.socket.WriteAll( output.data(), output.size() ) )
+        {
+            break;
+        }
+    }
+    connection.socket.ShutdownWrite();
+    connection.finished.store( true );
+}
+
+/** Parses a request line, answering it directly unless it is a distance query.
+
+@param line The request, without its newline; a trailing carriage return is ignored.
+@param request Receives the query, or the reply if the line isn't one.
+*/
+void QueryServer::ParseRequest( std::string_view line, Request & request ) const
+{
+    request.maze = nullptr;
+    request.reply.clear();
+    if ( !line.empty() && line.back() == '\r' )
+    {
+        line.remove_suffix( 1 );
+    }
+    std::string_view words[4]; // the words of the request; a fourth means too many
+    size_t wordCount = 0;
+    for ( size_t position = 0; position < line.size() && wordCount < 4; )
+    {
+        const size_t wordEnd = std::min( line.find( ' ', position ), line.size() ); // one past the last character of the word
+        if ( wordEnd > position )
+        {
+            words[wordCount++] = line.substr( position, wordEnd - position );
+        }
+        position = wordEnd + 1;
+    }
+
+    if ( wordCount == 1 && words[0] == "MAZES" )
+    {
+        for ( const auto & maze : m_mazes )
+        {
+            request.reply += request.reply.empty() ? "" : " ";
+            request.reply += maze.first;
+        }
+        return;
+    }
+    if ( wordCount == 2 && words[0] == "SIZE" )
+    {
+        const auto maze = m_mazes.find( words[1] ); // the maze asked about
+        request.reply = maze == m_mazes.end() ? "ERROR unknown maze" :
+            std::to_string( maze->second->GetColumnSize() ) + ',' + std::to_string( maze->second->GetRowSize() );
+        return;
+    }
+    if ( wordCount != 3 )
+    {
+        request.reply = "ERROR malformed request";
+        return;
+    }
+
+    const auto maze = m_mazes.find( words[0] ); // the maze queried
+    if ( maze == m_mazes.end() )
+    {
+        request.reply = "ERROR unknown maze";
+        return;
+    }
+    const std::pair<const char *, Maze::SEARCH_ALGORITHM> * algorithm = nullptr; // the search asked for
+    for ( const std::pair<const char *, Maze::SEARCH_ALGORITHM> & candidate : SERVER_ALGORITHMS )
+    {
+        if ( words[1] == candidate.first )
+        {
+            algorithm = &candidate;
+        }
+    }
+    if ( algorithm == nullptr )
+    {
+        request.reply = "ERROR unknown algorithm";
+        return;
+    }
+    const char * const end = words[2].data() + words[2].size(); // one past the last character of the coordinate
+    size_t x = 0;
+    size_t y = 0;
+    const std::from_chars_result column = std::from_chars( words[2].data(), end, x ); // the X coordinate
+    if ( column.ec != std::errc() || column.ptr == end || *column.ptr != ',' )
+    {
+        request.reply = "ERROR malformed coordinate";
+        return;
+    }
+    const std::from_chars_result row = std::from_chars( column.ptr + 1, end, y ); // the Y coordinate
+    if ( row.ec != std::errc() || row.ptr != end )
+    {
+        request.reply = "ERROR malformed coordinate";
+        return;
+    }
+    request.maze = maze->second.get();
+    request.algorithm = algorithm->second;
+    request.start = { y, x };
+}
+
+/** Answers the distance queries among the requests.
+    Consecutive queries on the same maze with the same algorithm are answered together: across the pool when there
+    are at least POOL_GROUP_QUERIES of them, otherwise one by one on this thread.
+
+@param requests The requests read from a connection; the distance of each query is filled in.
+@param workspace The search buffers of the queries answered on this thread.
+*/
+void QueryServer::AnswerRequests( std::vector<Request> & requests, SearchWorkspace & workspace )
+{
+    std::vector<std::pair<size_t, size_t>> starts; // the starts of a run handed to the pool
+    for ( size_t first = 0; first < requests.size(); )
+    {
+        const Maze * const maze = requests[first].maze; // the maze of the run
+        if ( maze == nullptr )
+        {
+            ++first;
+            continue;
+        }
+        const Maze::SEARCH_ALGORITHM algorithm = requests[first].algorithm; // the search of the run
+        size_t last = first + 1; // one past the last query of the run
+        while ( last < requests.size() && requests[last].maze == maze && requests[last].algorithm == algorithm )
+        {
+            ++last;
+        }
+
+        if ( last - first >= POOL_GROUP_QUERIES )
+        {
+            starts.clear();
+            for ( size_t query = first; query < last; ++query )
+            {
+                starts.push_back( requests[query].start );
+            }
+            const std::vector<int> distances = maze->MinimumNumberOfSpacesBatch( starts, algorithm, m_pool, m_poolWorkspaces );
+            for ( size_t query = first; query < last; ++query )
+            {
+                requests[query].distance = distances[query - first];
+            }
+        }
+        else
+        {
+            for ( size_t query = first; query < last; ++query )
+            {
+                requests[query].distance = maze->MinimumNumberOfSpaces( requests[query].start.first, requests[query].start.second, algorithm, workspace ).distance;
+            }
+        }
+        m_queryCount.fetch_add( last - first, std::memory_order_relaxed );
+        first = last;
+    }
+}
+
+/** Joins the threads of finished connections and forgets them.
+
+@param all Whether to wait for every connection rather than only those already finished.
+*/
+void QueryServer::ReapConnections( const bool all )
+{
+    std::lock_guard<std::mutex> lock( m_connectionsMutex );
+    for ( auto connection = m_connections.begin(); connection != m_connections.end(); )
+    {
+        if ( all || connection->finished.load() )
+        {
+            if ( connection->thread.joinable() )
+            {
+                connection->thread.join();
+            }
+            connection = m_connections.erase( connection );
+        }
+        else
+        {
+            ++connection;
+        }
+    }
+}
@@ -0,0 +1,84 @@
+// Joseph Miller (c) 2019
+#ifndef __QUERY_SERVER_H
+#define __QUERY_SERVER_H
+
+#include "Maze.h"
+#include "Socket.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+class ThreadPool;
+
+/** Serves distance queries on named mazes over a Socket, for as long as it runs.
+    Every maze is loaded once with its distance field and hierarchy built, so each query is answered straight from
+    memory. Each connection is read by its own thread, and requests are newline separated and may be pipelined:
+    a client can send any number before reading, and the answers come back one per line in request order.
+
+    "<maze> <algorithm> X,Y" answers the distance, -1 if no exit can be reached or the start is invalid.
+    "MAZES" answers the maze names separated by spaces. "SIZE <maze>" answers "columns,rows".
+    Anything else answers "ERROR <reason>" without closing the connection.
+
+    Runs of at least POOL_GROUP_QUERIES queries on the same maze and algorithm are answered across the shared thread
+    pool; shorter runs are answered on the connection's own thread, so light traffic never waits for the pool.
+    The mazes are never changed once serving starts, so every connection can search them at once.
+*/
+class QueryServer
+{
+    public:
+        static constexpr size_t POOL_GROUP_QUERIES = 256; ///< The fewest queries in a run that are worth handing to the pool.
+
+        explicit QueryServer( ThreadPool & pool );
+        ~QueryServer();
+        QueryServer( const QueryServer & ) = delete;
+        QueryServer & operator=( const QueryServer & ) = delete;
+        bool AddMaze( const std::string & name, const std::string & filename, const Maze::NEIGHBOURHOOD neighbourhood, const Maze::GRID_LAYOUT layout );
+        bool Listen( const std::string & address );
+        void Serve();
+        void Stop();
+        uint64_t GetConnections() const;
+        uint64_t GetQueries() const;
+
+    private:
+        struct Connection
+        {
+            Socket socket; ///< The client's end of the connection.
+            std::thread thread; ///< Reads, answers, and writes for the connection.
+            std::atomic<bool> finished{ false }; ///< Whether the thread is done and can be joined.
+        };
+
+        struct Request
+        {
+            const Maze * maze; ///< The maze queried, or nullptr if the line was answered directly.
+            Maze::SEARCH_ALGORITHM algorithm; ///< The search to answer with.
+            std::pair<size_t, size_t> start; ///< The row and column of the start.
+            int distance; ///< The answer, once searched.
+            std::string reply; ///< The answer of a line that isn't a query.
+        };
+
+        void HandleConnection( Connection & connection );
+        void ParseRequest( std::string_view line, Request & request ) const;
+        void AnswerRequests( std::vector<Request> & requests, SearchWorkspace & workspace );
+        void ReapConnections( const bool all );
+
+        ThreadPool & m_pool; ///< Answers the long runs of queries.
+        std::vector<SearchWorkspace> m_poolWorkspaces; ///< The search buffers of each worker of the pool, shared by every connection since only one run uses the pool at a time.
+        std::map<std::string, std::unique_ptr<Maze>, std::less<>> m_mazes; ///< The mazes served, by name, found by string_view too.
+        Socket m_listener; ///< Accepts new connections.
+        std::atomic<bool> m_stopping{ false }; ///< Whether Stop was called.
+        std::mutex m_connectionsMutex; ///< Guards m_connections.
+        std::list<Connection> m_connections; ///< The connections being served, or finished but not yet joined.
+        std::atomic<uint64_t> m_connectionCount{ 0 }; ///< The connections accepted so far.
+        std::atomic<uint64_t> m_queryCount{ 0 }; ///< The distance queries answered so far.
+};
+
+#endif // __QUERY_SERVER_H
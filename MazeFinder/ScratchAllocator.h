@@ -0,0 +1,64 @@
+// Joseph Miller (c) 2019
+#ifndef __SCRATCH_ALLOCATOR_H
+#define __SCRATCH_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+/** Counts the heap allocations made for search scratch buffers on the calling thread.
+
+@return the counter, which only ever grows.
+*/
+inline uint64_t & ScratchAllocationCount()
+{
+    static thread_local uint64_t count = 0; // the allocations made on this thread
+    return count;
+}
+
+/** The allocator of the search scratch buffers: the standard allocator, plus a count of every allocation made.
+    The buffers grow to the size of the maze on their first search and keep that capacity, so the count stops
+    climbing once a workspace has searched a maze, which is how a caller can check repeated queries don't allocate.
+    Growing a buffer leaves the new elements uninitialised unless a value is given, since the searches only read
+    the entries they have written; a buffer that must start cleared is resized or assigned with an explicit value.
+*/
+template <typename T>
+class ScratchAllocator
+{
+    public:
+        using value_type = T;
+
+        ScratchAllocator() = default;
+        template <typename U> ScratchAllocator( const ScratchAllocator<U> & ) {}
+
+        T * allocate( const size_t count )
+        {
+            ++ScratchAllocationCount();
+            return std::allocator<T>().allocate( count );
+        }
+
+        void deallocate( T * data, const size_t count )
+        {
+            std::allocator<T>().deallocate( data, count );
+        }
+
+        template <typename U> void construct( U * data )
+        {
+            ::new( static_cast<void *>( data ) ) U;
+        }
+
+        template <typename U, typename... ARGUMENTS> void construct( U * data, ARGUMENTS &&... arguments )
+        {
+            ::new( static_cast<void *>( data ) ) U( std::forward<ARGUMENTS>( arguments )... );
+        }
+
+        template <typename U> bool operator==( const ScratchAllocator<U> & ) const { return true; }
+        template <typename U> bool operator!=( const ScratchAllocator<U> & ) const { return false; }
+};
+
+template <typename T> using ScratchVector = std::vector<T, ScratchAllocator<T>>; ///< A search scratch buffer.
+
+#endif // __SCRATCH_ALLOCATOR_H
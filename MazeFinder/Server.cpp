@@ -0,0 +1,158 @@
+// Joseph Miller (c) 2019
+// The query server program: serves named mazes on a socket until interrupted.
+
+#include "Instrumentation.h"
+#include "QueryServer.h"
+#include "ThreadPool.h"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+static const char * const DEFAULT_ADDRESS = "unix:/tmp/mazefinder.sock"; ///< Where the server listens unless told otherwise.
+
+static QueryServer * s_server = nullptr; ///< The server to stop when interrupted.
+
+/** Stops the server on SIGINT or SIGTERM.
+
+@param signal The signal received.
+*/
+static void HandleStopSignal( int )
+{
+    if ( s_server != nullptr )
+    {
+        s_server->Stop();
+    }
+}
+
+/** Writes the command line options to std err.
+
+@param program The name the server was run as.
+*/
+static void PrintUsage( const char * program )
+{
+    std::cerr << "Usage: " << program << " --maze NAME=FILE [--maze NAME=FILE ...] [options]\n"
+              << "  --maze NAME=FILE       a maze to serve, queried by NAME (repeatable)\n"
+              << "  --address A            unix:PATH or tcp:PORT on 127.0.0.1 (default " << DEFAULT_ADDRESS << ")\n"
+              << "  --threads N            workers answering long runs of queries, 0 for one per hardware thread (default 0)\n"
+              << "  --neighbourhood N      four, eight, or eight_no_corner_cut moves (default four)\n"
+              << "  --layout L             row_major, tiled, or morton order of the cells the searches walk (default row_major)\n"
+              << "  --hardware-counters N  in instrumented builds, sample cycles, instructions, and cache misses every N searches per thread (default 0, off)\n"
+              << "Requests, one per line: \"NAME ALGORITHM X,Y\", \"MAZES\", or \"SIZE NAME\".\n"
+              << "ALGORITHM is one of bfs,dfs,idfs,bitbfs,field,astar,jps,hpa,hpa_approx,dijkstra." << std::endl;
+}
+
+/** Main. Loads every maze, then serves queries until SIGINT or SIGTERM, and writes a summary to std err, with the
+    search counters in instrumented builds.
+
+@param argc The number of command line arguments.
+@param argv The command line arguments.
+
+@return EXIT_SUCCESS, or EXIT_FAILURE if the arguments are invalid or a maze or the address can't be used.
+*/
+int main( int argc, char ** argv )
+{
+    std::string address = DEFAULT_ADDRESS;
+    std::vector<std::pair<std::string, std::string>> mazes; // the names and files of the mazes to serve
+    size_t threads = 0;
+    Maze::NEIGHBOURHOOD neighbourhood = Maze::NEIGHBOURHOOD::FOUR_WAY; // the moves the searches may make
+    Maze::GRID_LAYOUT layout = Maze::GRID_LAYOUT::ROW_MAJOR; // the order of the cells the searches walk
+    uint32_t samplePeriod = 0; // the searches per hardware counter sample, or 0 for none
+    for ( int argument = 1; argument < argc; ++argument )
+    {
+        const std::string option = argv[argument];
+        if ( argument + 1 >= argc )
+        {
+            PrintUsage( argv[0] );
+            return EXIT_FAILURE;
+        }
+        const std::string value = argv[++argument];
+        const size_t separator = value.find( '=' ); // splits a maze name from its file
+        if ( option == "--maze" && separator != std::string::npos )
+        {
+            mazes.emplace_back( value.substr( 0, separator ), value.substr( separator + 1 ) );
+        }
+        else if ( option == "--address" )
+        {
+            address = value;
+        }
+        else if ( option == "--threads" )
+        {
+            threads = std::strtoull( value.c_str(), nullptr, 10 );
+        }
+        else if ( option == "--neighbourhood" && value == "four" )
+        {
+            neighbourhood = Maze::NEIGHBOURHOOD::FOUR_WAY;
+        }
+        else if ( option == "--neighbourhood" && value == "eight" )
+        {
+            neighbourhood = Maze::NEIGHBOURHOOD::EIGHT_WAY;
+        }
+        else if ( option == "--neighbourhood" && value == "eight_no_corner_cut" )
+        {
+            neighbourhood = Maze::NEIGHBOURHOOD::EIGHT_WAY_NO_CORNER_CUTTING;
+        }
+        else if ( option == "--layout" && value == "row_major" )
+        {
+            layout = Maze::GRID_LAYOUT::ROW_MAJOR;
+        }
+        else if ( option == "--layout" && value == "tiled" )
+        {
+            layout = Maze::GRID_LAYOUT::TILED;
+        }
+        else if ( option == "--layout" && value == "morton" )
+        {
+            layout = Maze::GRID_LAYOUT::MORTON;
+        }
+        else if ( option == "--hardware-counters" )
+        {
+            samplePeriod = static_cast<uint32_t>( std::strtoul( value.c_str(), nullptr, 10 ) );
+        }
+        else
+        {
+            PrintUsage( argv[0] );
+            return EXIT_FAILURE;
+        }
+    }
+    if ( mazes.empty() )
+    {
+        PrintUsage( argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    if ( samplePeriod != 0 && !Instrumentation::EnableHardwareCounters( samplePeriod ) )
+    {
+        std::cerr << "Hardware counters are unavailable; counting without them" << std::endl;
+    }
+    ThreadPool pool( threads );
+    QueryServer server( pool );
+    for ( const std::pair<std::string, std::string> & maze : mazes )
+    {
+        std::cerr << "Loading " << maze.first << " from " << maze.second << "..." << std::endl;
+        if ( !server.AddMaze( maze.first, maze.second, neighbourhood, layout ) )
+        {
+            std::cerr << "Error loading maze: " << maze.first << '=' << maze.second << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if ( !server.Listen( address ) )
+    {
+        std::cerr << "Error listening on: " << address << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    s_server = &server;
+    std::signal( SIGINT, HandleStopSignal );
+    std::signal( SIGTERM, HandleStopSignal );
+    std::cerr << "Serving " << mazes.size() << " mazes on " << address << " with " << pool.GetThreadCount() << " workers" << std::endl;
+    server.Serve();
+    s_server = nullptr;
+    std::cerr << "Served " << server.GetQueries() << " queries over " << server.GetConnections() << " connections" << std::endl;
+    if ( INSTRUMENTATION_ENABLED )
+    {
+        std::cerr << Instrumentation::Report();
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,247 @@
+// Joseph Miller (c) 2019
+// Stream sockets for the query server: Unix domain sockets and localhost TCP behind one small interface.
+
+#include "Socket.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static constexpr int LISTEN_BACKLOG = 128; ///< The connections that may wait to be accepted.
+static const std::string UNIX_PREFIX = "unix:"; ///< Starts the address of a Unix domain socket.
+static const std::string TCP_PREFIX = "tcp:"; ///< Starts the address of a localhost TCP port.
+
+/** Closes the socket if it is still open.
+*/
+Socket::~Socket()
+{
+    Close();
+}
+
+/** Binds the socket to an address and listens for connections.
+    A stale Unix domain socket file left at the path is replaced.
+
+@param address The address to listen on, "unix:PATH" or "tcp:PORT".
+
+@retval true if the socket is listening.
+@retval false if the address is malformed or can't be bound.
+*/
+bool Socket::Listen( const std::string & address )
+{
+    return Open( address, true );
+}
+
+/** Connects the socket to a listening server.
+
+@param address The address of the server, "unix:PATH" or "tcp:PORT".
+
+@retval true if the socket is connected.
+@retval false if the address is malformed or nothing is listening there.
+*/
+bool Socket::Connect( const std::string & address )
+{
+    return Open( address, false );
+}
+
+/** Waits for a connection to a listening socket.
+
+@param connection Receives the connected socket.
+
+@retval true if a connection was accepted.
+@retval false if the socket was shut down or closed, or accepting failed.
+*/
+bool Socket::Accept( Socket & connection ) const
+{
+    connection.Close();
+    int descriptor = -1; // the socket of the new connection
+    do
+    {
+        descriptor = accept( m_descriptor, nullptr, nullptr );
+    } while ( descriptor < 0 && errno == EINTR );
+    if ( descriptor < 0 )
+    {
+        return false;
+    }
+    connection.m_descriptor = descriptor;
+    return true;
+}
+
+/** Closes the socket, removing the file of a listening Unix domain socket.
+*/
+void Socket::Close()
+{
+    if ( m_descriptor >= 0 )
+    {
+        close( m_descriptor );
+        m_descriptor = -1;
+    }
+    if ( !m_unixPath.empty() )
+    {
+        unlink( m_unixPath.c_str() );
+        m_unixPath.clear();
+    }
+}
+
+/** Shuts the socket down in both directions, waking any thread blocked accepting or reading on it.
+    Safe to call from a signal handler.
+*/
+void Socket::Shutdown() const
+{
+    if ( m_descriptor >= 0 )
+    {
+        shutdown( m_descriptor, SHUT_RDWR );
+    }
+}
+
+/** Tells the other end that nothing more will be written, while still reading what it sends back.
+*/
+void Socket::ShutdownWrite() const
+{
+    if ( m_descriptor >= 0 )
+    {
+        shutdown( m_descriptor, SHUT_WR );
+    }
+}
+
+/** Checks whether the socket is open.
+
+@retval true if the socket is listening or connected.
+@retval false if it is closed.
+*/
+bool Socket::IsOpen() const
+{
+    return m_descriptor >= 0;
+}
+
+/** Reads whatever has arrived, waiting for at least one byte.
+
+@param buffer Receives the bytes.
+@param size The most bytes to read.
+
+@return The number of bytes read, 0 once the other end has finished writing, or -1 on error.
+*/
+ptrdiff_t Socket::Read( char * buffer, const size_t size ) const
+{
+    ssize_t bytes = -1; // the bytes read
+    do
+    {
+        bytes = recv( m_descriptor, buffer, size, 0 );
+    } while ( bytes < 0 && errno == EINTR );
+    return bytes;
+}
+
+/** Writes every byte, however many writes it takes.
+    A peer that has gone away fails the write rather than raising SIGPIPE.
+
+@param data The bytes to write.
+@param size The number of bytes to write.
+
+@retval true if every byte was written.
+@retval false if the connection failed.
+*/
+bool Socket::WriteAll( const char * data, const size_t size ) const
+{
+    size_t written = 0; // the bytes written so far
+    while ( written < size )
+    {
+        const ssize_t bytes = send( m_descriptor, data + written, size - written, MSG_NOSIGNAL );
+        if ( bytes < 0 && errno == EINTR )
+        {
+            continue;
+        }
+        if ( bytes <= 0 )
+        {
+            return false;
+        }
+        written += static_cast<size_t>( bytes );
+    }
+    return true;
+}
+
+/** Creates the socket for an address and either listens on it or connects to it.
+
+@param address "unix:PATH" or "tcp:PORT".
+@param listening Whether to listen rather than connect.
+
+@retval true if the socket is ready.
+@retval false if the address is malformed or the socket couldn't be set up.
+*/
+bool Socket::Open( const std::string & address, const bool listening )
+{
+    Close();
+    sockaddr_un unixAddress{}; // the address if it is a Unix domain socket
+    sockaddr_in tcpAddress{}; // the address if it is a TCP port
+    const sockaddr * socketAddress = nullptr; // whichever of the two is used
+    socklen_t addressSize = 0;
+    int family = AF_UNIX;
+    if ( address.compare( 0, UNIX_PREFIX.size(), UNIX_PREFIX ) == 0 )
+    {
+        const std::string path = address.substr( UNIX_PREFIX.size() ); // the socket file
+        if ( path.empty() || path.size() >= sizeof( unixAddress.sun_path ) )
+        {
+            return false;
+        }
+        unixAddress.sun_family = AF_UNIX;
+        std::memcpy( unixAddress.sun_path, path.c_str(), path.size() + 1 );
+        socketAddress = reinterpret_cast<const sockaddr *>( &unixAddress );
+        addressSize = sizeof( unixAddress );
+        if ( listening )
+        {
+            unlink( path.c_str() ); // a socket file left by a server that didn't shut down cleanly
+        }
+    }
+    else if ( address.compare( 0, TCP_PREFIX.size(), TCP_PREFIX ) == 0 )
+    {
+        const unsigned long port = std::strtoul( address.c_str() + TCP_PREFIX.size(), nullptr, 10 ); // the port number
+        if ( port == 0 || port > 65535 )
+        {
+            return false;
+        }
+        family = AF_INET;
+        tcpAddress.sin_family = AF_INET;
+        tcpAddress.sin_port = htons( static_cast<uint16_t>( port ) );
+        tcpAddress.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+        socketAddress = reinterpret_cast<const sockaddr *>( &tcpAddress );
+        addressSize = sizeof( tcpAddress );
+    }
+    else
+    {
+        return false;
+    }
+
+    m_descriptor = socket( family, SOCK_STREAM, 0 );
+    if ( m_descriptor < 0 )
+    {
+        return false;
+    }
+    const int enable = 1;
+    if ( family == AF_INET )
+    {
+        setsockopt( m_descriptor, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof( enable ) ); // answers are small and shouldn't wait to be coalesced
+    }
+    if ( listening )
+    {
+        setsockopt( m_descriptor, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof( enable ) );
+        if ( bind( m_descriptor, socketAddress, addressSize ) != 0 || listen( m_descriptor, LISTEN_BACKLOG ) != 0 )
+        {
+            Close();
+            return false;
+        }
+        if ( family == AF_UNIX )
+        {
+            m_unixPath = address.substr( UNIX_PREFIX.size() );
+        }
+        return true;
+    }
+    if ( connect( m_descriptor, socketAddress, addressSize ) != 0 )
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,36 @@
+// Joseph Miller (c) 2019
+#ifndef __SOCKET_H
+#define __SOCKET_H
+
+#include <cstddef>
+#include <string>
+
+/** A stream socket on a Unix domain socket path or a localhost TCP port, for the query server and its clients.
+    Addresses are written "unix:PATH" or "tcp:PORT"; TCP only ever binds or connects to 127.0.0.1.
+    POSIX only, like the server programs that use it.
+*/
+class Socket
+{
+    public:
+        Socket() = default;
+        ~Socket();
+        Socket( const Socket & ) = delete;
+        Socket & operator=( const Socket & ) = delete;
+        bool Listen( const std::string & address );
+        bool Connect( const std::string & address );
+        bool Accept( Socket & connection ) const;
+        void Close();
+        void Shutdown() const;
+        void ShutdownWrite() const;
+        bool IsOpen() const;
+        ptrdiff_t Read( char * buffer, const size_t size ) const;
+        bool WriteAll( const char * data, const size_t size ) const;
+
+    private:
+        bool Open( const std::string & address, const bool listening );
+
+        int m_descriptor{ -1 }; ///< The socket file descriptor, or -1 when closed.
+        std::string m_unixPath; ///< The path a listening Unix domain socket is bound to, removed on Close.
+};
+
+#endif // __SOCKET_H
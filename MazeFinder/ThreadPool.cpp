@@ -0,0 +1,125 @@
+// Joseph Miller (c) 2019
+
+#include "ThreadPool.h"
+#include <algorithm>
+
+/** Starts the workers.
+
+@param threadCount The number of threads to run tasks on, including the thread calling Run, or 0 to use one per hardware thread.
+*/
+ThreadPool::ThreadPool( const size_t threadCount )
+{
+    size_t threads = threadCount; // the number of workers including the caller
+    if ( threads == 0 )
+    {
+        threads = std::max<size_t>( std::thread::hardware_concurrency(), 1 );
+    }
+    m_threads.reserve( threads - 1 );
+    for ( size_t worker = 1; worker < threads; ++worker )
+    {
+        m_threads.emplace_back( &ThreadPool::WorkerLoop, this, worker );
+    }
+}
+
+/** Stops and joins the workers.
+*/
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for ( std::thread & thread : m_threads )
+    {
+        thread.join();
+    }
+}
+
+/** Retrieves the number of workers a task runs on, including the thread calling Run.
+
+@return the number of workers.
+*/
+size_t ThreadPool::GetThreadCount() const
+{
+    return m_threads.size() + 1;
+}
+
+/** Runs a task once on every worker and waits for all of them to finish.
+    The task is told which worker it is running on, from 0 to GetThreadCount() - 1, so it can keep per-worker state
+    without locking. Splitting the work between the workers is up to the task.
+    If the task throws on any worker, the first exception is rethrown once every worker has finished.
+
+@param task The task to run.
+*/
+void ThreadPool::Run( const std::function<void( const size_t worker )> & task )
+{
+    std::lock_guard<std::mutex> runLock( m_runMutex );
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_task = &task;
+        m_busy = m_threads.size();
+        m_error = nullptr;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    RunTask( 0 ); // the caller is worker 0
+
+    std::unique_lock<std::mutex> lock( m_mutex );
+    m_done.wait( lock, [this]() { return m_busy == 0; } );
+    m_task = nullptr;
+    if ( m_error )
+    {
+        std::rethrow_exception( m_error );
+    }
+}
+
+/** Waits for tasks and runs each one once until the pool stops.
+
+@param worker The index of the worker.
+*/
+void ThreadPool::WorkerLoop( const size_t worker )
+{
+    uint64_t generation = 0; // the last task generation this worker ran
+    while ( true )
+    {
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            m_wake.wait( lock, [this, generation]() { return m_stopping || m_generation != generation; } );
+            if ( m_stopping )
+            {
+                return;
+            }
+            generation = m_generation;
+        }
+
+        RunTask( worker );
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if ( --m_busy == 0 )
+        {
+            m_done.notify_one();
+        }
+    }
+}
+
+/** Runs the current task on a worker, keeping the first exception it throws.
+
+@param worker The index of the worker.
+*/
+void ThreadPool::RunTask( const size_t worker )
+{
+    try
+    {
+        ( *m_task )( worker );
+    }
+    catch ( ... )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if ( !m_error )
+        {
+            m_error = std::current_exception();
+        }
+    }
+}
@@ -0,0 +1,40 @@
+// Joseph Miller (c) 2019
+#ifndef __THREAD_POOL_H
+#define __THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+    public:
+        explicit ThreadPool( const size_t threadCount = 0 );
+        ~ThreadPool();
+        ThreadPool( const ThreadPool & ) = delete;
+        ThreadPool & operator=( const ThreadPool & ) = delete;
+        size_t GetThreadCount() const;
+        void Run( const std::function<void( const size_t worker )> & task );
+
+    private:
+        void WorkerLoop( const size_t worker );
+        void RunTask( const size_t worker );
+
+        std::vector<std::thread> m_threads; ///< The background workers; the thread calling Run is worker 0.
+        std::mutex m_runMutex; ///< Lets only one Run use the workers at a time.
+        std::mutex m_mutex; ///< Guards the task, the generation, the busy count, and the stop flag.
+        std::condition_variable m_wake; ///< Wakes the workers when a task is posted or the pool stops.
+        std::condition_variable m_done; ///< Wakes Run when the last worker finishes the task.
+        const std::function<void( const size_t )> * m_task{ nullptr }; ///< The task being run.
+        uint64_t m_generation{ 0 }; ///< Counts the tasks posted, so a worker runs each task once.
+        size_t m_busy{ 0 }; ///< The number of background workers still running the task.
+        std::exception_ptr m_error; ///< The first exception thrown by the task, rethrown by Run.
+        bool m_stopping{ false }; ///< Whether the workers should exit.
+};
+
+#endif // __THREAD_POOL_H
@@ -0,0 +1,174 @@
+// Joseph Miller (c) 2019
+// The weighted search of Maze: Dijkstra over terrain move costs with a bucket queue (Dial's algorithm).
+
+#include "Maze.h"
+#include "GridLayout.h"
+#include "Neighbourhood.h"
+#include <algorithm>
+
+static constexpr size_t COST_BUCKETS = static_cast<size_t>( Maze::MAZE_DATA_TYPE::LAST_TERRAIN ) + 1; ///< One more bucket than the largest move cost, so pending costs never share a bucket.
+
+/** The cost of moving into a cell of each type: clear cells and exits cost one move, terrain its value, and blocked cells are never entered.
+    Indexed by the cell bytes as read, which is safe only because every way of loading or changing a maze rejects
+    bytes above LAST_TERRAIN (see LoadBinaryMaze and SetCell).
+*/
+static constexpr int MOVE_COSTS[COST_BUCKETS] = { 1, 0, 1, 3, 4, 5, 6, 7, 8, 9 };
+
+/** Retrieves the minimum move cost to the nearest exit using Dijkstra's algorithm.
+    Entering a clear cell or an exit costs one move and entering terrain costs its value, so on a maze without
+    terrain this is the minimum number of spaces and breadth first search answers it. The other searches count
+    spaces and treat terrain as clear.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+
+@return The minimum move cost from the start to the closest end point (-1 if no end point could be reached from start or if start was invalid), with the statistics of the search.
+*/
+SearchResult Maze::MinimumMoveCostDijkstra( const size_t start_row, const size_t start_column ) const
+{
+    return TimedSearch( start_row, start_column, SEARCH_ALGORITHM::DIJKSTRA );
+}
+
+/** Checks whether the loaded maze has terrain.
+
+@retval true if some cell costs more than one move to enter.
+@retval false if every move costs one, so move costs equal numbers of spaces.
+*/
+bool Maze::HasTerrain() const
+{
+    return m_terrainCells != 0;
+}
+
+/** Finds the minimum move cost to the nearest exit using Dijkstra's algorithm in the maze's neighbourhood and layout.
+    Mazes without terrain are searched with breadth first search, which needs no buckets at all.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param workspace The buffers to search with.
+@param result Receives the number of cells expanded and the most cells the buckets held.
+
+@return The minimum move cost from the start to the closest end point, or -1 if no end point could be reached from start or if start was invalid.
+*/
+int Maze::SearchDijkstra( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const
+{
+    if ( !HasTerrain() ) // every move costs one, so the nearest exit by spaces is the cheapest
+    {
+        return SearchBFS<false>( start_row, start_column, workspace, result );
+    }
+    return WithNeighbourhood( m_neighbourhood, [&]( auto policy )
+    {
+        return WithLayout( SearchLayout(), [&]( auto layout )
+        {
+            return DijkstraSearch<decltype( policy ), decltype( layout )>( start_row, start_column, workspace, result );
+        } );
+    } );
+}
+
+/** Finds the minimum move cost to the nearest exit using Dijkstra's algorithm with a bucket queue.
+    Move costs are small integers, so the open list is a ring of COST_BUCKETS buckets indexed by path cost instead of
+    a heap: every pending cell costs between the current cost and the current cost plus the largest move cost, so
+    each bucket only ever holds one cost, and popping is a walk forward around the ring. A cell is pushed again
+    whenever its cost improves and the stale entries are skipped when they come off. An exit costs the cheapest
+    move to enter, so as with breadth first search the first exit reached is the cheapest and is never queued.
+    A diagonal move costs the same as any other move into its cell.
+
+@param start_row the row the start location begins with.
+@param start_column the column the start location begins with.
+@param workspace The buffers to search with.
+@param result Receives the number of cells expanded and the most cells the buckets held.
+
+@return The minimum move cost from the start to the closest end point, or -1 if no end point could be reached from start or if start was invalid.
+*/
+template <typename NEIGHBOURHOOD_POLICY, typename LAYOUT_POLICY>
+int Maze::DijkstraSearch( const size_t start_row, const size_t start_column, SearchWorkspace & workspace, SearchResult & result ) const
+{
+    if ( start_row >= m_rowSize || start_column >= m_columnSize ) // check that the row and column for start is within bounds
+    {
+        return PATH_UNREACHABLE;
+    }
+    const LayoutGrid<LAYOUT_POLICY> grid = Grid<LAYOUT_POLICY>(); // the padded grid in the layout's order
+    const MAZE_DATA_TYPE * cells = grid.cells;
+    const size_t startIndex = grid.Index( start_row, start_column ); // the index of the starting position
+    switch ( cells[startIndex] )
+    {
+        case MAZE_DATA_TYPE::EXIT: // If the start is the exit, the end point costs 0 moves
+        {
+            return 0;
+        } break;
+        case MAZE_DATA_TYPE::BLOCKED: // a blocked start can't travel anywhere
+        {
+            return PATH_UNREACHABLE;
+        } break;
+        default:
+        {
+        } break;
+    }
+
+    const NeighbourOffsets<NEIGHBOURHOOD_POLICY, LAYOUT_POLICY> neighbourOffsets( grid.rowCells ); // steps to the cells a move reaches; the blocked border keeps these in bounds
+
+    const uint32_t stamp = workspace.NextStamp(); // marks the costs written by this search
+    ScratchVector<SearchWorkspace::StampedValue> & costs = workspace.m_distances; // holds the cheapest known cost from start, where stamped
+    ScratchVector<ScratchVector<uint32_t>> & buckets = workspace.m_costBuckets; // the pending cells, by cost modulo COST_BUCKETS
+    costs.resize( grid.cellCount, { 0, 0 } );
+    buckets.resize( COST_BUCKETS );
+    for ( ScratchVector<uint32_t> & bucket : buckets )
+    {
+        bucket.clear();
+    }
+
+    costs[startIndex] = { stamp, 0 }; // the start costs nothing to stand on
+    buckets[0].push_back( static_cast<uint32_t>( startIndex ) );
+    size_t pending = 1; // the number of entries in the buckets, including stale ones
+    size_t peakPending = 1; // the most entries the buckets have held
+    for ( int cost = 0; pending > 0; ++cost ) // walk the ring one cost at a time until every bucket is empty
+    {
+        ScratchVector<uint32_t> & bucket = buckets[static_cast<size_t>( cost ) % COST_BUCKETS];
+        while ( !bucket.empty() ) // cells pushed onto this bucket while it is drained cost more, so they land in other buckets
+        {
+            const size_t currentIndex = bucket.back();
+            bucket.pop_back();
+            --pending;
+            if ( costs[currentIndex].value != cost ) // a cheaper entry for the cell was already expanded
+            {
+                continue;
+            }
+            ++result.cellsExpanded; // increase the number of steps taken
+
+            // relax each neighbour, stopping at an exit: every pending cell costs at least as much as this one, so no exit is cheaper
+            const bool exitFound = VisitNeighbours( cells, currentIndex, neighbourOffsets, [&]( const uint8_t, const size_t neighbourIndex )
+            {
+                const MAZE_DATA_TYPE neighbour = cells[neighbourIndex];
+                if ( neighbour == MAZE_DATA_TYPE::EXIT )
+                {
+                    return true;
+                }
+                if ( neighbour == MAZE_DATA_TYPE::BLOCKED )
+                {
+                    return false;
+                }
+                const int neighbourCost = cost + MOVE_COSTS[static_cast<uint8_t>( neighbour )]; // the cost of reaching the neighbour through this cell
+                if ( costs[neighbourIndex].stamp != stamp || neighbourCost < costs[neighbourIndex].value )
+                {
+                    costs[neighbourIndex] = { stamp, neighbourCost };
+                    buckets[static_cast<size_t>( neighbourCost ) % COST_BUCKETS].push_back( static_cast<uint32_t>( neighbourIndex ) );
+                    peakPending = std::max( peakPending, ++pending );
+                    result.counters.Enqueue();
+                }
+                else
+                {
+                    result.counters.RevisitAvoided();
+                }
+                return false;
+            } );
+            if ( exitFound )
+            {
+                result.peakFrontier = peakPending;
+                return cost + MOVE_COSTS[static_cast<uint8_t>( MAZE_DATA_TYPE::EXIT )];
+            }
+        }
+    }
+
+    // could not find an end point
+    result.peakFrontier = peakPending;
+    return PATH_UNREACHABLE;
+}